@@ -0,0 +1,511 @@
+// batch.c
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stddef.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <time.h>
+#include <sys/wait.h>
+#include <sys/types.h>
+#include "config.h"
+#include "run_summary.h"
+
+#define MAX_SWEEPS 16         // --set options per batch
+#define MAX_SWEEP_VALUES 64   // Comma-separated values per --set
+#define SUMMARY_FD 3          // Descriptor the simulation writes its RunSummary to
+
+// A configuration override; several comma-separated values are swept across runs
+typedef struct {
+    char key[128];
+    char *values[MAX_SWEEP_VALUES];
+    int count;
+} Sweep;
+
+// A simulation currently running
+typedef struct {
+    pid_t pid;
+    int fd;  // Read end of the summary pipe
+    int run;
+} RunSlot;
+
+// An end-state counter reported for every run
+typedef struct {
+    const char *name;
+    size_t offset;
+    int is_double;
+} Metric;
+
+static const Metric metrics[] = {
+    { "killed_resistance", offsetof(RunSummary, killed_resistance), 0 },
+    { "injured_resistance", offsetof(RunSummary, injured_resistance), 0 },
+    { "caught_resistance", offsetof(RunSummary, caught_resistance), 0 },
+    { "killed_agency", offsetof(RunSummary, killed_agency), 0 },
+    { "injured_agency", offsetof(RunSummary, injured_agency), 0 },
+    { "caught_agency", offsetof(RunSummary, caught_agency), 0 },
+    { "total_arrests", offsetof(RunSummary, total_arrests), 0 },
+    { "total_imprisoned", offsetof(RunSummary, total_imprisoned), 0 },
+    { "total_released", offsetof(RunSummary, total_released), 0 },
+    { "total_resistance_groups", offsetof(RunSummary, total_resistance_groups), 0 },
+    { "end_seconds", offsetof(RunSummary, end_seconds), 1 },
+};
+#define METRIC_COUNT ((int)(sizeof(metrics) / sizeof(metrics[0])))
+
+static const double percentiles[] = { 5, 25, 50, 75, 95 };
+#define PERCENTILE_COUNT ((int)(sizeof(percentiles) / sizeof(percentiles[0])))
+
+// Global batch state
+static Sweep sweeps[MAX_SWEEPS];
+static int sweep_count = 0;
+static int combinations = 1;
+static int real_time = 0;
+
+// Function to print usage
+static void usage(const char *program) {
+    fprintf(stderr,
+            "Usage: %s config.txt [-n runs] [-j jobs] [-s base_seed] [--set key=v1,v2,...]...\n"
+            "          [--csv FILE] [--json FILE] [--runs FILE] [--sim PATH] [--real-time] [--verbose]\n"
+            "          (--real-time: run the processes on the wall clock, to check virtual-time results against)\n",
+            program);
+}
+
+// Function to read a metric of a run as a double
+static double metric_value(const RunSummary *summary, const Metric *metric) {
+    const char *base = (const char *)summary + metric->offset;
+    if (metric->is_double) {
+        return *(const double *)base;
+    }
+    return *(const int *)base;
+}
+
+// Function to pick the sweep value a run uses (runs cycle through every combination)
+static const char *sweep_value(int run, int sweep) {
+    int index = run % combinations;
+    for (int i = 0; i < sweep; i++) {
+        index /= sweeps[i].count;
+    }
+    return sweeps[sweep].values[index % sweeps[sweep].count];
+}
+
+// Function to parse a --set option into a sweep
+static int add_sweep(const char *assignment) {
+    if (sweep_count == MAX_SWEEPS) {
+        fprintf(stderr, "[Batch] Too many --set options (max %d).\n", MAX_SWEEPS);
+        return -1;
+    }
+
+    Sweep *sweep = &sweeps[sweep_count];
+    const char *equals = strchr(assignment, '=');
+    if (equals == NULL || equals == assignment || (size_t)(equals - assignment) >= sizeof(sweep->key)) {
+        fprintf(stderr, "[Batch] Invalid override '%s' (expected key=value[,value...]).\n", assignment);
+        return -1;
+    }
+    memcpy(sweep->key, assignment, equals - assignment);
+    sweep->key[equals - assignment] = '\0';
+
+    char *list = strdup(equals + 1);
+    if (list == NULL) {
+        perror("[Batch] Failed to copy override");
+        return -1;
+    }
+    sweep->count = 0;
+    for (char *value = strtok(list, ","); value != NULL; value = strtok(NULL, ",")) {
+        if (sweep->count == MAX_SWEEP_VALUES) {
+            fprintf(stderr, "[Batch] Too many values for '%s' (max %d).\n", sweep->key, MAX_SWEEP_VALUES);
+            return -1;
+        }
+        sweep->values[sweep->count++] = value;
+    }
+    if (sweep->count == 0) {
+        fprintf(stderr, "[Batch] No value given for '%s'.\n", sweep->key);
+        return -1;
+    }
+
+    // Reject unknown keys before starting any run
+    Config probe;
+    memset(&probe, 0, sizeof(probe));
+    if (set_config_value(&probe, sweep->key, sweep->values[0]) != 0) {
+        fprintf(stderr, "[Batch] Unknown configuration key '%s'.\n", sweep->key);
+        return -1;
+    }
+
+    combinations *= sweep->count;
+    sweep_count++;
+    return 0;
+}
+
+// Function to start one headless simulation run
+static int start_run(RunSlot *slot, int run, unsigned int seed, const char *sim_path, const char *config_path, int verbose) {
+    int fds[2];
+    if (pipe2(fds, O_CLOEXEC) == -1) {
+        perror("[Batch] pipe failed");
+        return -1;
+    }
+
+    pid_t pid = fork();
+    if (pid < 0) {
+        perror("[Batch] fork failed");
+        close(fds[0]);
+        close(fds[1]);
+        return -1;
+    }
+
+    if (pid == 0) {
+        // Child: summary pipe on SUMMARY_FD, simulation output discarded unless verbose
+        if (fds[1] == SUMMARY_FD) {
+            fcntl(SUMMARY_FD, F_SETFD, 0);
+        } else if (dup2(fds[1], SUMMARY_FD) == -1) {
+            perror("[Batch] dup2 failed");
+            _exit(EXIT_FAILURE);
+        }
+        if (!verbose) {
+            int null_fd = open("/dev/null", O_WRONLY);
+            if (null_fd != -1) {
+                dup2(null_fd, STDOUT_FILENO);
+                dup2(null_fd, STDERR_FILENO);
+                close(null_fd);
+            }
+        }
+
+        char seed_arg[32];
+        char shm_arg[64];
+        char fd_arg[16];
+        snprintf(seed_arg, sizeof(seed_arg), "%u", seed);
+        snprintf(shm_arg, sizeof(shm_arg), "/simulation_batch_%d_%d", (int)getppid(), run);
+        snprintf(fd_arg, sizeof(fd_arg), "%d", SUMMARY_FD);
+
+        // Each run gets its own seed, shared memory name and override values
+        const char *args[12 + 2 * MAX_SWEEPS];
+        char assignments[MAX_SWEEPS][256];
+        int n = 0;
+        args[n++] = sim_path;
+        args[n++] = config_path;
+        if (!real_time) {
+            args[n++] = "--virtual-time";
+        }
+        args[n++] = "--seed";
+        args[n++] = seed_arg;
+        args[n++] = "--shm-name";
+        args[n++] = shm_arg;
+        args[n++] = "--summary-fd";
+        args[n++] = fd_arg;
+        for (int i = 0; i < sweep_count; i++) {
+            snprintf(assignments[i], sizeof(assignments[i]), "%s=%s", sweeps[i].key, sweep_value(run, i));
+            args[n++] = "--set";
+            args[n++] = assignments[i];
+        }
+        args[n] = NULL;
+
+        execv(sim_path, (char *const *)args);
+        perror("[Batch] execv failed");
+        _exit(EXIT_FAILURE);
+    }
+
+    close(fds[1]);
+    slot->pid = pid;
+    slot->fd = fds[0];
+    slot->run = run;
+    return 0;
+}
+
+// Function to compare doubles for qsort
+static int compare_doubles(const void *a, const void *b) {
+    double x = *(const double *)a;
+    double y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+// Function to read a percentile from sorted values (linear interpolation between ranks)
+static double percentile(const double *sorted, int count, double p) {
+    if (count == 1) {
+        return sorted[0];
+    }
+    double rank = p / 100.0 * (count - 1);
+    int low = (int)rank;
+    if (low >= count - 1) {
+        return sorted[count - 1];
+    }
+    double fraction = rank - low;
+    return sorted[low] + (sorted[low + 1] - sorted[low]) * fraction;
+}
+
+// Aggregate of one metric over the runs of one override combination
+typedef struct {
+    int count;
+    double mean;
+    double min;
+    double max;
+    double p[PERCENTILE_COUNT];
+} Aggregate;
+
+// Function to aggregate one metric over the successful runs of one combination
+static void aggregate_metric(const RunSummary *results, const int *valid, int runs, int combo, const Metric *metric,
+                             double *scratch, Aggregate *aggregate) {
+    int count = 0;
+    double sum = 0.0;
+    for (int run = combo; run < runs; run += combinations) {
+        if (valid[run]) {
+            scratch[count] = metric_value(&results[run], metric);
+            sum += scratch[count];
+            count++;
+        }
+    }
+
+    memset(aggregate, 0, sizeof(*aggregate));
+    aggregate->count = count;
+    if (count == 0) {
+        return;
+    }
+    qsort(scratch, count, sizeof(double), compare_doubles);
+    aggregate->mean = sum / count;
+    aggregate->min = scratch[0];
+    aggregate->max = scratch[count - 1];
+    for (int i = 0; i < PERCENTILE_COUNT; i++) {
+        aggregate->p[i] = percentile(scratch, count, percentiles[i]);
+    }
+}
+
+// Function to write the aggregate table as CSV
+static void write_csv(FILE *out, const RunSummary *results, const int *valid, int runs, double *scratch) {
+    for (int i = 0; i < sweep_count; i++) {
+        fprintf(out, "%s,", sweeps[i].key);
+    }
+    fprintf(out, "metric,runs,mean,min");
+    for (int i = 0; i < PERCENTILE_COUNT; i++) {
+        fprintf(out, ",p%g", percentiles[i]);
+    }
+    fprintf(out, ",max\n");
+
+    for (int combo = 0; combo < combinations; combo++) {
+        for (int m = 0; m < METRIC_COUNT; m++) {
+            Aggregate aggregate;
+            aggregate_metric(results, valid, runs, combo, &metrics[m], scratch, &aggregate);
+            for (int i = 0; i < sweep_count; i++) {
+                fprintf(out, "%s,", sweep_value(combo, i));
+            }
+            fprintf(out, "%s,%d,%.4f,%.4f", metrics[m].name, aggregate.count, aggregate.mean, aggregate.min);
+            for (int i = 0; i < PERCENTILE_COUNT; i++) {
+                fprintf(out, ",%.4f", aggregate.p[i]);
+            }
+            fprintf(out, ",%.4f\n", aggregate.max);
+        }
+    }
+}
+
+// Function to write the aggregate table as JSON
+static void write_json(FILE *out, const RunSummary *results, const int *valid, int runs, double *scratch) {
+    fprintf(out, "{\n  \"runs\": %d,\n  \"combinations\": [\n", runs);
+    for (int combo = 0; combo < combinations; combo++) {
+        fprintf(out, "    {\n      \"overrides\": {");
+        for (int i = 0; i < sweep_count; i++) {
+            fprintf(out, "%s\"%s\": \"%s\"", i > 0 ? ", " : "", sweeps[i].key, sweep_value(combo, i));
+        }
+        fprintf(out, "},\n      \"metrics\": {\n");
+        for (int m = 0; m < METRIC_COUNT; m++) {
+            Aggregate aggregate;
+            aggregate_metric(results, valid, runs, combo, &metrics[m], scratch, &aggregate);
+            fprintf(out, "        \"%s\": {\"runs\": %d, \"mean\": %.4f, \"min\": %.4f",
+                    metrics[m].name, aggregate.count, aggregate.mean, aggregate.min);
+            for (int i = 0; i < PERCENTILE_COUNT; i++) {
+                fprintf(out, ", \"p%g\": %.4f", percentiles[i], aggregate.p[i]);
+            }
+            fprintf(out, ", \"max\": %.4f}%s\n", aggregate.max, m + 1 < METRIC_COUNT ? "," : "");
+        }
+        fprintf(out, "      }\n    }%s\n", combo + 1 < combinations ? "," : "");
+    }
+    fprintf(out, "  ]\n}\n");
+}
+
+// Function to write one CSV row per run
+static void write_runs(FILE *out, const RunSummary *results, const int *valid, int runs) {
+    fprintf(out, "run,seed");
+    for (int i = 0; i < sweep_count; i++) {
+        fprintf(out, ",%s", sweeps[i].key);
+    }
+    for (int m = 0; m < METRIC_COUNT; m++) {
+        fprintf(out, ",%s", metrics[m].name);
+    }
+    fprintf(out, "\n");
+
+    for (int run = 0; run < runs; run++) {
+        if (!valid[run]) {
+            continue;
+        }
+        fprintf(out, "%d,%u", run, results[run].seed);
+        for (int i = 0; i < sweep_count; i++) {
+            fprintf(out, ",%s", sweep_value(run, i));
+        }
+        for (int m = 0; m < METRIC_COUNT; m++) {
+            fprintf(out, metrics[m].is_double ? ",%.3f" : ",%.0f", metric_value(&results[run], &metrics[m]));
+        }
+        fprintf(out, "\n");
+    }
+}
+
+// Function to open an output file, or return stdout for "-"
+static FILE *open_output(const char *path) {
+    if (strcmp(path, "-") == 0) {
+        return stdout;
+    }
+    FILE *out = fopen(path, "w");
+    if (out == NULL) {
+        perror("[Batch] Failed to open output file");
+    }
+    return out;
+}
+
+// Main function
+int main(int argc, char *argv[]) {
+    const char *config_path = NULL;
+    const char *csv_path = NULL;
+    const char *json_path = NULL;
+    const char *runs_path = NULL;
+    const char *sim_path = NULL;
+    int runs = 100;
+    int jobs = 0;
+    unsigned int base_seed = (unsigned int)time(NULL);
+    int verbose = 0;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-n") == 0 && i + 1 < argc) {
+            runs = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "-j") == 0 && i + 1 < argc) {
+            jobs = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "-s") == 0 && i + 1 < argc) {
+            base_seed = (unsigned int)strtoul(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--set") == 0 && i + 1 < argc) {
+            if (add_sweep(argv[++i]) != 0) {
+                exit(EXIT_FAILURE);
+            }
+        } else if (strcmp(argv[i], "--csv") == 0 && i + 1 < argc) {
+            csv_path = argv[++i];
+        } else if (strcmp(argv[i], "--json") == 0 && i + 1 < argc) {
+            json_path = argv[++i];
+        } else if (strcmp(argv[i], "--runs") == 0 && i + 1 < argc) {
+            runs_path = argv[++i];
+        } else if (strcmp(argv[i], "--sim") == 0 && i + 1 < argc) {
+            sim_path = argv[++i];
+        } else if (strcmp(argv[i], "--real-time") == 0) {
+            real_time = 1;
+        } else if (strcmp(argv[i], "--verbose") == 0) {
+            verbose = 1;
+        } else if (config_path == NULL && argv[i][0] != '-') {
+            config_path = argv[i];
+        } else {
+            usage(argv[0]);
+            exit(EXIT_FAILURE);
+        }
+    }
+    if (config_path == NULL || runs <= 0) {
+        usage(argv[0]);
+        exit(EXIT_FAILURE);
+    }
+    if (jobs <= 0) {
+        long cores = sysconf(_SC_NPROCESSORS_ONLN);
+        jobs = cores > 0 ? (int)cores : 1;
+    }
+    if (csv_path == NULL && json_path == NULL) {
+        csv_path = "-";
+    }
+
+    // The simulation binary sits next to this one unless told otherwise
+    char default_sim[4096];
+    if (sim_path == NULL) {
+        const char *slash = strrchr(argv[0], '/');
+        if (slash == NULL) {
+            snprintf(default_sim, sizeof(default_sim), "./simulation");
+        } else {
+            snprintf(default_sim, sizeof(default_sim), "%.*s/simulation", (int)(slash - argv[0]), argv[0]);
+        }
+        sim_path = default_sim;
+    }
+
+    RunSummary *results = calloc(runs, sizeof(RunSummary));
+    int *valid = calloc(runs, sizeof(int));
+    double *scratch = malloc(sizeof(double) * runs);
+    RunSlot *slots = malloc(sizeof(RunSlot) * jobs);
+    if (results == NULL || valid == NULL || scratch == NULL || slots == NULL) {
+        perror("[Batch] Failed to allocate run tables");
+        exit(EXIT_FAILURE);
+    }
+
+    struct timespec wall_start, wall_end;
+    clock_gettime(CLOCK_MONOTONIC, &wall_start);
+
+    // Keep up to `jobs` simulations running until every run has finished
+    int next_run = 0;
+    int active = 0;
+    int failed = 0;
+    while (next_run < runs || active > 0) {
+        while (active < jobs && next_run < runs) {
+            if (start_run(&slots[active], next_run, base_seed + next_run, sim_path, config_path, verbose) != 0) {
+                failed++;
+            } else {
+                active++;
+            }
+            next_run++;
+        }
+        if (active == 0) {
+            continue;
+        }
+
+        int status;
+        pid_t pid = waitpid(-1, &status, 0);
+        if (pid == -1) {
+            perror("[Batch] waitpid failed");
+            break;
+        }
+
+        for (int i = 0; i < active; i++) {
+            if (slots[i].pid != pid) {
+                continue;
+            }
+            int run = slots[i].run;
+            ssize_t got = read(slots[i].fd, &results[run], sizeof(RunSummary));
+            close(slots[i].fd);
+            if (got == (ssize_t)sizeof(RunSummary) && WIFEXITED(status) && WEXITSTATUS(status) == 0) {
+                valid[run] = 1;
+            } else {
+                fprintf(stderr, "[Batch] Run %d (seed %u) failed.\n", run, base_seed + run);
+                failed++;
+            }
+            slots[i] = slots[--active];
+            break;
+        }
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &wall_end);
+    double wall_seconds = (wall_end.tv_sec - wall_start.tv_sec) + (wall_end.tv_nsec - wall_start.tv_nsec) / 1e9;
+    fprintf(stderr, "[Batch] %d runs (%d failed) across %d jobs in %.2f seconds, base seed %u.\n",
+            runs, failed, jobs, wall_seconds, base_seed);
+
+    int status = failed == runs ? EXIT_FAILURE : EXIT_SUCCESS;
+    const char *paths[] = { csv_path, json_path, runs_path };
+    for (int kind = 0; kind < 3; kind++) {
+        if (paths[kind] == NULL) {
+            continue;
+        }
+        FILE *out = open_output(paths[kind]);
+        if (out == NULL) {
+            status = EXIT_FAILURE;
+            continue;
+        }
+        if (kind == 0) {
+            write_csv(out, results, valid, runs, scratch);
+        } else if (kind == 1) {
+            write_json(out, results, valid, runs, scratch);
+        } else {
+            write_runs(out, results, valid, runs);
+        }
+        if (out != stdout) {
+            fclose(out);
+        }
+    }
+
+    free(results);
+    free(valid);
+    free(scratch);
+    free(slots);
+    return status;
+}
@@ -4,6 +4,70 @@
 #include <string.h>
 #include <stdlib.h>
 
+// Function to assign one configuration value by key; returns -1 for an unknown key
+int set_config_value(Config *config, const char *key, const char *value) {
+    if (strcmp(key, "agency_members") == 0)
+        config->agency_members = atoi(value);
+    else if (strcmp(key, "group_creation_interval") == 0)
+        config->group_creation_interval = atoi(value);
+    else if (strcmp(key, "group_size_min") == 0)
+        config->group_size_min = atoi(value);
+    else if (strcmp(key, "group_size_max") == 0)
+        config->group_size_max = atoi(value);
+    else if (strcmp(key, "military_group_percentage") == 0)
+        config->military_group_percentage = atoi(value);
+    else if (strcmp(key, "spy_infiltration_probability") == 0)
+        config->spy_infiltration_probability = atof(value);
+    else if (strcmp(key, "target_probability") == 0)
+        config->target_probability = atof(value);
+    else if (strcmp(key, "recovery_light") == 0)
+        config->recovery_light = atoi(value);
+    else if (strcmp(key, "recovery_severe") == 0)
+        config->recovery_severe = atoi(value);
+    else if (strcmp(key, "suspicion_threshold") == 0)
+        config->suspicion_threshold = atof(value);
+    else if (strcmp(key, "arrest_release_threshold") == 0)
+        config->arrest_release_threshold = atof(value);
+    else if (strcmp(key, "arrest_imprison_threshold") == 0)
+        config->arrest_imprison_threshold = atof(value);
+    else if (strcmp(key, "max_killed") == 0)
+        config->max_killed = atoi(value);
+    else if (strcmp(key, "max_injured") == 0)
+        config->max_injured = atoi(value);
+    else if (strcmp(key, "agency_time_limit") == 0)
+        config->agency_time_limit = atoi(value);
+    else if (strcmp(key, "task_pool_workers") == 0)
+        config->task_pool_workers = atoi(value);
+    else if (strcmp(key, "max_groups") == 0)
+        config->max_groups = atoi(value);
+    else if (strcmp(key, "max_resistance_members") == 0)
+        config->max_resistance_members = atoi(value);
+    else if (strcmp(key, "max_agency_members") == 0)
+        config->max_agency_members = atoi(value);
+    else if (strcmp(key, "detection_radius") == 0)
+        config->detection_radius = atof(value);
+    else if (strcmp(key, "log_level") == 0)
+        config->log_level = atoi(value);
+    else
+        return -1;
+    return 0;
+}
+
+// Function to apply a key=value override on top of a parsed configuration
+int apply_config_override(Config *config, const char *assignment) {
+    char key[128];
+    char value[128];
+    if (sscanf(assignment, "%127[^=]=%127s", key, value) != 2) {
+        fprintf(stderr, "Invalid override '%s' (expected key=value).\n", assignment);
+        return -1;
+    }
+    if (set_config_value(config, key, value) != 0) {
+        fprintf(stderr, "Unknown configuration key '%s'.\n", key);
+        return -1;
+    }
+    return 0;
+}
+
 // Function to parse the configuration file
 int parse_config(const char *filename, Config *config) {
     FILE *file = fopen(filename, "r");
@@ -27,37 +91,8 @@ int parse_config(const char *filename, Config *config) {
         if (sscanf(line, "%[^=]=%s", key, value) != 2)
             continue;
 
-        // Assign values to the config structure
-        if (strcmp(key, "agency_members") == 0)
-            config->agency_members = atoi(value);
-        else if (strcmp(key, "group_creation_interval") == 0)
-            config->group_creation_interval = atoi(value);
-        else if (strcmp(key, "group_size_min") == 0)
-            config->group_size_min = atoi(value);
-        else if (strcmp(key, "group_size_max") == 0)
-            config->group_size_max = atoi(value);
-        else if (strcmp(key, "military_group_percentage") == 0)
-            config->military_group_percentage = atoi(value);
-        else if (strcmp(key, "spy_infiltration_probability") == 0)
-            config->spy_infiltration_probability = atof(value);
-        else if (strcmp(key, "target_probability") == 0)
-            config->target_probability = atof(value);
-        else if (strcmp(key, "recovery_light") == 0)
-            config->recovery_light = atoi(value);
-        else if (strcmp(key, "recovery_severe") == 0)
-            config->recovery_severe = atoi(value);
-        else if (strcmp(key, "suspicion_threshold") == 0)
-            config->suspicion_threshold = atof(value);
-        else if (strcmp(key, "arrest_release_threshold") == 0)
-            config->arrest_release_threshold = atof(value);
-        else if (strcmp(key, "arrest_imprison_threshold") == 0)
-            config->arrest_imprison_threshold = atof(value);
-        else if (strcmp(key, "max_killed") == 0)
-            config->max_killed = atoi(value);
-        else if (strcmp(key, "max_injured") == 0)
-            config->max_injured = atoi(value);
-        else if (strcmp(key, "agency_time_limit") == 0)
-            config->agency_time_limit = atoi(value);
+        // Assign values to the config structure (unknown keys are ignored)
+        set_config_value(config, key, value);
     }
 
     fclose(file);
@@ -18,9 +18,21 @@ typedef struct {
     int max_killed;
     int max_injured;
     int agency_time_limit;
+    int task_pool_workers; // Worker threads running resistance members (0 = one per core)
+    int max_groups;             // Group slots in shared memory (0 = default)
+    int max_resistance_members; // Member slots in shared memory (0 = default)
+    int max_agency_members;     // Agent slots in shared memory (0 = default)
+    double detection_radius;    // Map distance within which an agent analyzes groups (0 = whole map)
+    int log_level;              // Most detailed message level logged (0 = default)
 } Config;
 
 // Function to parse the configuration file
 int parse_config(const char *filename, Config *config);
 
+// Function to assign one configuration value by key
+int set_config_value(Config *config, const char *key, const char *value);
+
+// Function to apply a key=value override on top of a parsed configuration
+int apply_config_override(Config *config, const char *assignment);
+
 #endif
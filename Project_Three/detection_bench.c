@@ -0,0 +1,178 @@
+// detection_bench.c
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+#include "shared.h"
+
+#define DEFAULT_QUERIES 2000   // Agent analyses timed per group count
+#define DEFAULT_RADIUS 25.0f   // Detection radius used unless --radius is given
+#define DEFAULT_ACTIVE 5       // Percentage of groups with spy activity since the last analysis
+#define MAX_SIZES 16           // Group counts per invocation
+
+// Result of one way of finding the groups near an agent
+typedef struct {
+    double ns_per_query;
+    double visited_per_query; // Groups locked and distance-checked
+    long found;               // Active groups within range over all queries
+} BenchResult;
+
+// Function to print usage
+static void usage(const char *program) {
+    fprintf(stderr, "Usage: %s [--radius R] [--queries Q] [--active PERCENT] [--seed N] [groups...]\n"
+                    "          (default group counts: 10000 30000 100000)\n", program);
+}
+
+// Function to read the monotonic clock in nanoseconds
+static long now_ns(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec * 1000000000L + now.tv_nsec;
+}
+
+// Function to create groups at random positions; the active percentage have spy time and are
+// marked dirty like a spy's activity marks them
+static void create_groups(SharedData *shared, int groups, int active) {
+    for (int i = 0; i < groups; i++) {
+        int index = slot_map_reserve(&shared->groups);
+        ResistanceGroup *group = slot_map_record(&shared->groups, index);
+        GroupTable *table = &shared->group_table;
+        group->group_id = i + 1;
+        group_has_spy(table)[index] = rand() % 5 == 0;
+        group_spy_time(table)[index] = rand() % 100 < active ? 3 : 0;
+        if (group_spy_time(table)[index] > 0) {
+            dirty_set_mark(&shared->dirty_groups, index);
+        }
+        group->live_members = 1;
+        group_x(table)[index] = (float)(rand() % 200 - 100);
+        group_y(table)[index] = (float)(rand() % 200 - 100);
+        slot_map_publish(&shared->groups, index);
+    }
+}
+
+// Function to check whether the locked group at a slot has spy time to analyze and is within radius of (x, y)
+static int near(SharedData *shared, int index, float x, float y, float radius) {
+    float dx = group_x(&shared->group_table)[index] - x;
+    float dy = group_y(&shared->group_table)[index] - y;
+    return group_spy_time(&shared->group_table)[index] > 0 && dx * dx + dy * dy <= radius * radius;
+}
+
+// Function to time analyses that scan every group slot, as agents did before the dirty set
+static BenchResult bench_scan(SharedData *shared, const float (*agents)[2], int queries, float radius) {
+    BenchResult result = { 0, 0, 0 };
+    long visited = 0;
+    long start = now_ns();
+    for (int q = 0; q < queries; q++) {
+        int extent = slot_map_extent(&shared->groups);
+        for (int i = 0; i < extent; i++) {
+            ResistanceGroup *group = lock_group(shared, slot_map_handle_at(&shared->groups, i));
+            if (group == NULL) {
+                continue;
+            }
+            visited++;
+            result.found += near(shared, i, agents[q][0], agents[q][1], radius);
+            unlock_group(group);
+        }
+    }
+    result.ns_per_query = (double)(now_ns() - start) / queries;
+    result.visited_per_query = (double)visited / queries;
+    return result;
+}
+
+// Function to time analyses that visit only the dirty groups, as agents do now
+static BenchResult bench_dirty(SharedData *shared, const float (*agents)[2], int queries, float radius) {
+    BenchResult result = { 0, 0, 0 };
+    long visited = 0;
+    long start = now_ns();
+    for (int q = 0; q < queries; q++) {
+        for (int i = dirty_set_next(&shared->dirty_groups, 0); i != -1; i = dirty_set_next(&shared->dirty_groups, i + 1)) {
+            ResistanceGroup *group = lock_group(shared, slot_map_handle_at(&shared->groups, i));
+            if (group == NULL) {
+                continue;
+            }
+            visited++;
+            result.found += near(shared, i, agents[q][0], agents[q][1], radius);
+            unlock_group(group);
+        }
+    }
+    result.ns_per_query = (double)(now_ns() - start) / queries;
+    result.visited_per_query = (double)visited / queries;
+    return result;
+}
+
+// Main function
+int main(int argc, char *argv[]) {
+    float radius = DEFAULT_RADIUS;
+    int queries = DEFAULT_QUERIES;
+    int active = DEFAULT_ACTIVE;
+    unsigned int seed = 1;
+    int sizes[MAX_SIZES];
+    int size_count = 0;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--radius") == 0 && i + 1 < argc) {
+            radius = (float)atof(argv[++i]);
+        } else if (strcmp(argv[i], "--queries") == 0 && i + 1 < argc) {
+            queries = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--active") == 0 && i + 1 < argc) {
+            active = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+            seed = (unsigned int)strtoul(argv[++i], NULL, 10);
+        } else if (argv[i][0] != '-' && size_count < MAX_SIZES && atoi(argv[i]) > 0) {
+            sizes[size_count++] = atoi(argv[i]);
+        } else {
+            usage(argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+    if (size_count == 0) {
+        sizes[size_count++] = 10000;
+        sizes[size_count++] = 30000;
+        sizes[size_count++] = 100000;
+    }
+    if (radius <= 0.0f || queries <= 0 || active < 0 || active > 100) {
+        usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    printf("[Bench] %d agent analyses per size, detection radius %.1f, %d%% of groups active.\n",
+           queries, radius, active);
+    printf("%10s %14s %14s %14s %14s\n", "groups", "scan us/query", "dirty us/query", "scan visited", "dirty visited");
+
+    for (int s = 0; s < size_count; s++) {
+        char shm_name[SHM_NAME_LENGTH];
+        snprintf(shm_name, sizeof(shm_name), "/detection_bench_%d", (int)getpid());
+        SharedData *shared = init_shared_data(shm_name, sizes[s], 1, 1);
+        if (shared == NULL) {
+            fprintf(stderr, "[Bench] Failed to initialize shared data for %d groups.\n", sizes[s]);
+            return EXIT_FAILURE;
+        }
+
+        float (*agents)[2] = malloc(sizeof(float[2]) * queries);
+        if (agents == NULL) {
+            perror("[Bench] Failed to allocate agent positions");
+            destroy_shared_data(shared);
+            return EXIT_FAILURE;
+        }
+
+        srand(seed);
+        create_groups(shared, sizes[s], active);
+        for (int q = 0; q < queries; q++) {
+            agents[q][0] = (float)(rand() % 200 - 100);
+            agents[q][1] = (float)(rand() % 200 - 100);
+        }
+
+        BenchResult scan = bench_scan(shared, (const float (*)[2])agents, queries, radius);
+        BenchResult dirty = bench_dirty(shared, (const float (*)[2])agents, queries, radius);
+        if (scan.found != dirty.found) {
+            fprintf(stderr, "[Bench] Scan found %ld active groups in range, dirty set %ld.\n", scan.found, dirty.found);
+        }
+        printf("%10d %14.1f %14.1f %14.0f %14.0f\n", sizes[s], scan.ns_per_query / 1000.0,
+               dirty.ns_per_query / 1000.0, scan.visited_per_query, dirty.visited_per_query);
+
+        free(agents);
+        destroy_shared_data(shared);
+    }
+    return 0;
+}
@@ -0,0 +1,94 @@
+// dirty_set.c
+#include "dirty_set.h"
+
+// Function to round a size up to 16 bytes so the bitmap stays aligned
+static size_t align16(size_t size) {
+    return (size + 15) & ~(size_t)15;
+}
+
+// Function to address the bitmap
+static unsigned long long *bits(DirtySet *set) {
+    return (unsigned long long *)((char *)set + set->bits_offset);
+}
+
+// Function to compute the storage a set of the given capacity needs in the shared segment
+size_t dirty_set_storage_size(int capacity) {
+    return align16(sizeof(unsigned long long) * ((capacity + 63) / 64));
+}
+
+// Function to initialize an empty set over storage in the same segment as the set
+void dirty_set_init(DirtySet *set, void *storage, int capacity) {
+    set->capacity = capacity;
+    set->words = (capacity + 63) / 64;
+    set->count = 0;
+    set->bits_offset = (char *)storage - (char *)set;
+    for (int i = 0; i < set->words; i++) {
+        bits(set)[i] = 0;
+    }
+}
+
+// Function to mark an index; returns 1 if it was not marked before
+int dirty_set_mark(DirtySet *set, int index) {
+    if (index < 0 || index >= set->capacity) {
+        return 0;
+    }
+    unsigned long long bit = 1ULL << (index % 64);
+    unsigned long long old = __atomic_fetch_or(&bits(set)[index / 64], bit, __ATOMIC_RELEASE);
+    if (old & bit) {
+        return 0;
+    }
+    __atomic_fetch_add(&set->count, 1, __ATOMIC_RELAXED);
+    return 1;
+}
+
+// Function to clear an index; returns 1 if it was marked
+int dirty_set_clear(DirtySet *set, int index) {
+    if (index < 0 || index >= set->capacity) {
+        return 0;
+    }
+    unsigned long long bit = 1ULL << (index % 64);
+    unsigned long long old = __atomic_fetch_and(&bits(set)[index / 64], ~bit, __ATOMIC_ACQ_REL);
+    if (!(old & bit)) {
+        return 0;
+    }
+    __atomic_fetch_sub(&set->count, 1, __ATOMIC_RELAXED);
+    return 1;
+}
+
+// Function to find the first marked index at or after from; returns -1 when there is none
+int dirty_set_next(DirtySet *set, int from) {
+    return dirty_set_next_in(set, from, ~0ULL);
+}
+
+// Function to find the first marked index at or after from whose position in its 64-index word has its bit set
+// in lanes; returns -1 when there is none
+int dirty_set_next_in(DirtySet *set, int from, unsigned long long lanes) {
+    if (from < 0) {
+        from = 0;
+    }
+    if (from >= set->capacity || lanes == 0) {
+        return -1;
+    }
+    int word = from / 64;
+    unsigned long long pending = __atomic_load_n(&bits(set)[word], __ATOMIC_ACQUIRE) & lanes & (~0ULL << (from % 64));
+    while (pending == 0) {
+        if (++word >= set->words) {
+            return -1;
+        }
+        pending = __atomic_load_n(&bits(set)[word], __ATOMIC_ACQUIRE) & lanes;
+    }
+    return word * 64 + __builtin_ctzll(pending);
+}
+
+// Function to read the marks of the 64-index word holding index; bit b marks the word's b-th index
+unsigned long long dirty_set_word(DirtySet *set, int index) {
+    if (index < 0 || index >= set->capacity) {
+        return 0;
+    }
+    return __atomic_load_n(&bits(set)[index / 64], __ATOMIC_ACQUIRE);
+}
+
+// Function to read the number of marked indices
+int dirty_set_count(DirtySet *set) {
+    return __atomic_load_n(&set->count, __ATOMIC_RELAXED);
+}
@@ -0,0 +1,42 @@
+// dirty_set.h
+#ifndef DIRTY_SET_H
+#define DIRTY_SET_H
+
+#include <stddef.h>
+
+// Bitmap of slot indices living in shared memory, marking entities changed since a consumer last processed them.
+// Marking and clearing are atomic and O(1); iteration visits the marked indices in ascending order and skips
+// 64 clear indices per word load, so consumers pay for the activity since their last pass, not for the capacity.
+typedef struct {
+    int capacity;     // Indices below this can be marked
+    int words;        // 64-bit words in the bitmap
+    int count;        // Indices currently marked
+    long bits_offset; // Offset of the bitmap from this set
+} DirtySet;
+
+// Function to compute the storage a set of the given capacity needs in the shared segment
+size_t dirty_set_storage_size(int capacity);
+
+// Function to initialize an empty set over storage in the same segment as the set
+void dirty_set_init(DirtySet *set, void *storage, int capacity);
+
+// Function to mark an index; returns 1 if it was not marked before
+int dirty_set_mark(DirtySet *set, int index);
+
+// Function to clear an index; returns 1 if it was marked
+int dirty_set_clear(DirtySet *set, int index);
+
+// Function to find the first marked index at or after from; returns -1 when there is none
+int dirty_set_next(DirtySet *set, int from);
+
+// Function to find the first marked index at or after from whose position in its 64-index word has its bit set
+// in lanes; words with no such index are skipped in one load. Returns -1 when there is none.
+int dirty_set_next_in(DirtySet *set, int from, unsigned long long lanes);
+
+// Function to read the marks of the 64-index word holding index; bit b marks the word's b-th index
+unsigned long long dirty_set_word(DirtySet *set, int index);
+
+// Function to read the number of marked indices
+int dirty_set_count(DirtySet *set);
+
+#endif
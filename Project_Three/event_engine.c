@@ -0,0 +1,122 @@
+// event_engine.c
+#include "event_engine.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+// Global event queue (binary min-heap ordered by time, then sequence)
+static Event *heap = NULL;
+static long heap_count = 0;
+static long heap_capacity = 0;
+static long next_seq = 0;
+static long now_ms = 0;
+
+// Function to compare two events; non-zero when a is due before b
+static int event_before(const Event *a, const Event *b) {
+    if (a->time_ms != b->time_ms) {
+        return a->time_ms < b->time_ms;
+    }
+    return a->seq < b->seq;
+}
+
+// Function to create an empty event queue with the clock at zero
+int event_engine_init(void) {
+    heap = malloc(sizeof(Event) * EVENT_QUEUE_INITIAL);
+    if (heap == NULL) {
+        perror("[Event Engine] Failed to allocate event queue");
+        return -1;
+    }
+    heap_capacity = EVENT_QUEUE_INITIAL;
+    heap_count = 0;
+    next_seq = 0;
+    now_ms = 0;
+    return 0;
+}
+
+// Function to schedule a step delay_ms after the current simulated time
+int event_schedule(TaskStep step, void *arg, long delay_ms) {
+    if (heap_count == heap_capacity) {
+        Event *grown = realloc(heap, sizeof(Event) * heap_capacity * 2);
+        if (grown == NULL) {
+            perror("[Event Engine] Failed to grow event queue");
+            return -1;
+        }
+        heap = grown;
+        heap_capacity *= 2;
+    }
+
+    Event event;
+    event.time_ms = now_ms + (delay_ms > 0 ? delay_ms : 0);
+    event.seq = next_seq++;
+    event.step = step;
+    event.arg = arg;
+
+    // Sift up
+    long i = heap_count++;
+    while (i > 0) {
+        long parent = (i - 1) / 2;
+        if (!event_before(&event, &heap[parent])) {
+            break;
+        }
+        heap[i] = heap[parent];
+        i = parent;
+    }
+    heap[i] = event;
+    return 0;
+}
+
+// Function to remove the earliest event from the heap
+static Event pop_event(void) {
+    Event top = heap[0];
+    Event last = heap[--heap_count];
+
+    // Sift down
+    long i = 0;
+    while (1) {
+        long child = 2 * i + 1;
+        if (child >= heap_count) {
+            break;
+        }
+        if (child + 1 < heap_count && event_before(&heap[child + 1], &heap[child])) {
+            child++;
+        }
+        if (!event_before(&heap[child], &last)) {
+            break;
+        }
+        heap[i] = heap[child];
+        i = child;
+    }
+    if (heap_count > 0) {
+        heap[i] = last;
+    }
+    return top;
+}
+
+// Function to read the simulated clock in milliseconds
+long event_now_ms(void) {
+    return now_ms;
+}
+
+// Function to run events in time order until the queue drains or *running becomes zero; returns events run
+long event_engine_run(volatile int *running) {
+    long events_run = 0;
+    while (*running && heap_count > 0) {
+        Event event = pop_event();
+        now_ms = event.time_ms;
+
+        int delay_ms = event.step(event.arg);
+        events_run++;
+
+        if (delay_ms >= 0 && event_schedule(event.step, event.arg, delay_ms) != 0) {
+            break;
+        }
+    }
+    return events_run;
+}
+
+// Function to release the event queue
+void event_engine_destroy(void) {
+    free(heap);
+    heap = NULL;
+    heap_count = 0;
+    heap_capacity = 0;
+}
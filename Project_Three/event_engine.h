@@ -0,0 +1,32 @@
+// event_engine.h
+#ifndef EVENT_ENGINE_H
+#define EVENT_ENGINE_H
+
+#include "task_pool.h"
+
+#define EVENT_QUEUE_INITIAL 1024 // Initial capacity of the event heap
+
+// A scheduled step on the simulated clock
+typedef struct {
+    long time_ms; // Simulated time the step is due
+    long seq;     // Scheduling order, breaks ties so equal times run first-in first-out
+    TaskStep step;
+    void *arg;
+} Event;
+
+// Function to create an empty event queue with the clock at zero
+int event_engine_init(void);
+
+// Function to schedule a step delay_ms after the current simulated time
+int event_schedule(TaskStep step, void *arg, long delay_ms);
+
+// Function to read the simulated clock in milliseconds
+long event_now_ms(void);
+
+// Function to run events in time order until the queue drains or *running becomes zero; returns events run
+long event_engine_run(volatile int *running);
+
+// Function to release the event queue
+void event_engine_destroy(void);
+
+#endif
@@ -0,0 +1,120 @@
+// group_table.c
+#include "group_table.h"
+#include <string.h>
+
+// 128-bit vectors (GCC vector extensions): native SSE2 on x86-64 and NEON on ARM, so no target flags are
+// needed; wider generic vectors are split into scalar code when the target lacks them. Two make one step.
+typedef int IntLanes __attribute__((vector_size(16)));
+typedef long long MaskWords __attribute__((vector_size(16)));
+#define VECTOR_LANES ((int)(sizeof(IntLanes) / sizeof(int)))
+
+// Function to round a size up to 64 bytes so every column starts on a cache line
+static size_t align64(size_t size) {
+    return (size + 63) & ~(size_t)63;
+}
+
+// Function to compute the storage a table of the given capacity needs in the shared segment
+size_t group_table_storage_size(int capacity) {
+    // One cache line of slack lets the columns start on a line even when the storage does not
+    return 64 + align64(sizeof(int) * capacity) * 2 + align64(sizeof(float) * capacity) * 2;
+}
+
+// Function to initialize a zeroed table over storage in the same segment as the table
+void group_table_init(GroupTable *table, void *storage, int capacity) {
+    char *start = (char *)(((size_t)storage + 63) & ~(size_t)63);
+    table->capacity = capacity;
+    table->spy_time_offset = start - (char *)table;
+    table->has_spy_offset = table->spy_time_offset + align64(sizeof(int) * capacity);
+    table->x_offset = table->has_spy_offset + align64(sizeof(int) * capacity);
+    table->y_offset = table->x_offset + align64(sizeof(float) * capacity);
+    memset(start, 0, group_table_storage_size(capacity) - 64);
+}
+
+// Functions to address the columns
+int *group_spy_time(GroupTable *table) {
+    return (int *)((char *)table + table->spy_time_offset);
+}
+
+int *group_has_spy(GroupTable *table) {
+    return (int *)((char *)table + table->has_spy_offset);
+}
+
+float *group_x(GroupTable *table) {
+    return (float *)((char *)table + table->x_offset);
+}
+
+float *group_y(GroupTable *table) {
+    return (float *)((char *)table + table->y_offset);
+}
+
+// Function to list the slots in [first, end) whose group hides a spy with at least min_spy_time, in one
+// vectorized sweep; fills candidates (room for end - first slots) and returns how many were found
+int group_table_candidates(GroupTable *table, int first, int end, int min_spy_time, int *candidates) {
+    const int *spy_time = group_spy_time(table);
+    const int *has_spy = group_has_spy(table);
+    if (end > table->capacity) {
+        end = table->capacity;
+    }
+
+    IntLanes threshold = { min_spy_time, min_spy_time, min_spy_time, min_spy_time };
+    IntLanes zero = { 0, 0, 0, 0 };
+
+    int count = 0;
+    int i = first;
+    for (; i + GROUP_TABLE_LANES <= end; i += GROUP_TABLE_LANES) {
+        IntLanes times[2];
+        IntLanes spies[2];
+        memcpy(times, &spy_time[i], sizeof(times));
+        memcpy(spies, &has_spy[i], sizeof(spies));
+        IntLanes hit[2]; // -1 in every lane that scores
+        hit[0] = (times[0] >= threshold) & (spies[0] != zero);
+        hit[1] = (times[1] >= threshold) & (spies[1] != zero);
+
+        // Most steps score nothing; only a step with a hit is unpacked lane by lane
+        MaskWords either = (MaskWords)(hit[0] | hit[1]);
+        if ((either[0] | either[1]) != 0) {
+            for (int lane = 0; lane < GROUP_TABLE_LANES; lane++) {
+                if (hit[lane / VECTOR_LANES][lane % VECTOR_LANES]) {
+                    candidates[count++] = i + lane;
+                }
+            }
+        }
+    }
+    for (; i < end; i++) {
+        if (spy_time[i] >= min_spy_time && has_spy[i]) {
+            candidates[count++] = i;
+        }
+    }
+    return count;
+}
+
+// Function to list the slots first + b, for each bit b set in lanes, whose group hides a spy with at least
+// min_spy_time; fills candidates (room for 64) and returns how many were found
+int group_table_candidates_in(GroupTable *table, int first, unsigned long long lanes, int min_spy_time,
+                              int *candidates) {
+    int count = 0;
+    if (__builtin_popcountll(lanes) > GROUP_TABLE_DENSE_LANES) {
+        int swept[64];
+        int found = group_table_candidates(table, first, first + 64, min_spy_time, swept);
+        for (int c = 0; c < found; c++) {
+            if (lanes >> (swept[c] - first) & 1) {
+                candidates[count++] = swept[c];
+            }
+        }
+        return count;
+    }
+
+    const int *spy_time = group_spy_time(table);
+    const int *has_spy = group_has_spy(table);
+    while (lanes != 0) {
+        int i = first + __builtin_ctzll(lanes);
+        lanes &= lanes - 1;
+        if (i >= table->capacity) {
+            break;
+        }
+        if (spy_time[i] >= min_spy_time && has_spy[i]) {
+            candidates[count++] = i;
+        }
+    }
+    return count;
+}
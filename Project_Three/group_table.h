@@ -0,0 +1,44 @@
+// group_table.h
+#ifndef GROUP_TABLE_H
+#define GROUP_TABLE_H
+
+#include <stddef.h>
+
+#define GROUP_TABLE_LANES 8        // Groups scored per vector step
+#define GROUP_TABLE_DENSE_LANES 16 // Slots of a 64-slot word past which one sweep beats checking each slot
+
+// Group fields stored as columns indexed by group slot, living in shared memory next to the group records.
+// A pass over one field streams only that field: suspicion scoring reads 8 bytes per group instead of
+// whole records, and the render-only positions stay out of its way. Writers hold the group's lock.
+typedef struct {
+    int capacity;
+    long spy_time_offset; // int per slot: time a spy has spent in the group (seconds)
+    long has_spy_offset;  // int per slot: 1 when the group hides a spy
+    long x_offset;        // float per slot: position on the map
+    long y_offset;        // float per slot
+} GroupTable;
+
+// Function to compute the storage a table of the given capacity needs in the shared segment
+size_t group_table_storage_size(int capacity);
+
+// Function to initialize a zeroed table over storage in the same segment as the table
+void group_table_init(GroupTable *table, void *storage, int capacity);
+
+// Functions to address the columns
+int *group_spy_time(GroupTable *table);
+int *group_has_spy(GroupTable *table);
+float *group_x(GroupTable *table);
+float *group_y(GroupTable *table);
+
+// Function to list the slots in [first, end) whose group hides a spy with at least min_spy_time, in one
+// vectorized sweep; fills candidates (room for end - first slots) and returns how many were found.
+// Reads without locks, so callers recheck each candidate under its group's lock.
+int group_table_candidates(GroupTable *table, int first, int end, int min_spy_time, int *candidates);
+
+// Function to list the slots first + b, for each bit b set in lanes, whose group hides a spy with at least
+// min_spy_time (first is a multiple of 64, e.g. the start of a dirty-set word). Few lanes are checked slot by
+// slot, many in one vectorized sweep of the word. Fills candidates (room for 64) and returns how many were found.
+int group_table_candidates_in(GroupTable *table, int first, unsigned long long lanes, int min_spy_time,
+                              int *candidates);
+
+#endif
@@ -0,0 +1,839 @@
+// log.c
+#include "log.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <signal.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+#define LOG_MAX_RINGS 256        // Threads of a process that can hold a buffer at once
+#define LOG_RING_BYTES 16384     // Buffer per thread (a power of two, at most 65536)
+#define LOG_MAX_RECORD 512       // Largest message record: header and arguments
+#define LOG_MAX_STRING 63        // String arguments are cut to this length
+#define LOG_FLUSH_MS 20          // Interval between writer passes
+#define LOG_OUTPUT_BYTES 65536   // Output collected by the writer before a write
+#define LOG_LINE_BYTES 1024      // Longest text line
+#define LOG_MAX_FORMATS 1024     // Format strings a process remembers having written to a binary log
+#define LOG_MAX_FORMAT_TEXT 1024 // Longest format string written to a binary log
+
+// Types of the value a conversion takes
+typedef enum {
+    ARG_LITERAL = 0, // %%
+    ARG_INT,
+    ARG_UINT,
+    ARG_LONG,
+    ARG_ULONG,
+    ARG_LLONG,
+    ARG_ULLONG,
+    ARG_SIZE,
+    ARG_DOUBLE,
+    ARG_STRING,
+    ARG_POINTER,
+    ARG_UNSUPPORTED
+} LogArgType;
+
+// Buffer one thread appends to and the writer drains (one producer, one consumer, no locks).
+// Head and tail count bytes ever appended and drained; each sits on its own cache line.
+typedef struct {
+    unsigned long head __attribute__((aligned(64))); // Written by the owning thread
+    long logged;                                     // Messages appended (owning thread)
+    long dropped;                                    // Messages lost to a full buffer (owning thread)
+    unsigned long tail __attribute__((aligned(64))); // Written by the writer
+    long reported_logged;                            // Counts already added to the totals (writer)
+    long reported_dropped;
+    unsigned char data[LOG_RING_BYTES] __attribute__((aligned(64)));
+} LogRing;
+
+// Run-wide counts, in memory shared by every process forked after log_init
+typedef struct {
+    long logged;
+    long dropped;
+} LogTotals;
+
+// Output collected by the writer for one descriptor
+typedef struct {
+    int fd;
+    size_t length;
+    char data[LOG_OUTPUT_BYTES];
+} LogOutput;
+
+static int log_level = LOG_DEFAULT_LEVEL;
+static int initialized = 0;
+static uint32_t process_id = 0;
+static int64_t origin_ns = 0;
+static long (*clock_ms_hook)(void) = NULL;
+static LogTotals *totals = NULL;
+
+// Thread buffers, claimed by threads on their first message and released when they exit
+static LogRing *rings[LOG_MAX_RINGS];
+static int ring_claimed[LOG_MAX_RINGS];
+static int ring_count = 0; // Buffers ever claimed (the writer scans this many)
+static long unattached_dropped = 0; // Messages from threads that found no free buffer
+static pthread_key_t ring_key;
+static __thread LogRing *thread_ring = NULL;
+static __thread int thread_slot = -1;
+
+// Writer state; the writer sleeps on wake until its next pass or until a waiting thread wakes it
+static pthread_t writer_thread;
+static pthread_mutex_t wake_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t wake;
+static int wake_requested = 0;
+static int wait_when_full = 0;
+static volatile sig_atomic_t writer_running = 0;
+static volatile sig_atomic_t exit_requested = 0;
+static int writer_stop = 0;
+static long writer_passes = 0;
+static long reported_unattached = 0;
+static int64_t last_time_ns = 0;
+static int binary_fd = -1;
+static uint64_t announced[LOG_MAX_FORMATS]; // Format keys written by this process (open addressing)
+static LogOutput text_output = { STDOUT_FILENO, 0, { 0 } };
+static LogOutput error_output = { STDERR_FILENO, 0, { 0 } };
+static LogOutput binary_output = { -1, 0, { 0 } };
+
+// Function to round a size up to 8 bytes
+static size_t align8(size_t size) {
+    return (size + 7) & ~(size_t)7;
+}
+
+// Function to read the clock messages are stamped with
+static int64_t now_ns(void) {
+    if (clock_ms_hook != NULL) {
+        return (int64_t)clock_ms_hook() * 1000000;
+    }
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (int64_t)now.tv_sec * 1000000000 + now.tv_nsec - origin_ns;
+}
+
+// Function to name a level as printed
+const char *log_level_name(int level) {
+    static const char *names[] = { "?", "ERROR", "WARN", "INFO", "DEBUG" };
+    return level >= LOG_ERROR && level <= LOG_DEBUG ? names[level] : names[0];
+}
+
+// Function to find the next conversion in a format; returns its '%' (or NULL) and sets its length and type
+static const char *next_conversion(const char *format, size_t *length, int *type) {
+    const char *start = strchr(format, '%');
+    if (start == NULL) {
+        return NULL;
+    }
+    const char *p = start + 1;
+    while (*p != '\0' && strchr("-+ #0", *p) != NULL) {
+        p++;
+    }
+    while (*p >= '0' && *p <= '9') {
+        p++;
+    }
+    if (*p == '.') {
+        p++;
+        while (*p >= '0' && *p <= '9') {
+            p++;
+        }
+    }
+    while (*p == 'h') {
+        p++; // Short values arrive promoted to int
+    }
+    int longs = 0;
+    while (*p == 'l') {
+        longs++;
+        p++;
+    }
+    int sized = 0;
+    if (*p == 'z') {
+        sized = 1;
+        p++;
+    }
+
+    switch (*p) {
+    case '%':
+        *type = ARG_LITERAL;
+        break;
+    case 'd':
+    case 'i':
+        *type = sized ? ARG_SIZE : longs == 0 ? ARG_INT : longs == 1 ? ARG_LONG : ARG_LLONG;
+        break;
+    case 'u':
+    case 'x':
+    case 'X':
+    case 'o':
+        *type = sized ? ARG_SIZE : longs == 0 ? ARG_UINT : longs == 1 ? ARG_ULONG : ARG_ULLONG;
+        break;
+    case 'c':
+        *type = ARG_INT;
+        break;
+    case 'f':
+    case 'F':
+    case 'e':
+    case 'E':
+    case 'g':
+    case 'G':
+    case 'a':
+    case 'A':
+        *type = ARG_DOUBLE;
+        break;
+    case 's':
+        *type = ARG_STRING;
+        break;
+    case 'p':
+        *type = ARG_POINTER;
+        break;
+    default:
+        *type = ARG_UNSUPPORTED; // Including '*' widths
+        break;
+    }
+    *length = (size_t)(p - start) + (*p != '\0');
+    return start;
+}
+
+// Function to store a message's arguments as 8-byte values and length-prefixed strings; returns the bytes used
+static size_t encode_arguments(unsigned char *out, size_t space, const char *format, va_list args) {
+    size_t used = 0;
+    size_t length;
+    int type;
+    const char *spec;
+    while ((spec = next_conversion(format, &length, &type)) != NULL) {
+        format = spec + length;
+        if (type == ARG_LITERAL) {
+            continue;
+        }
+        if (type == ARG_UNSUPPORTED) {
+            break; // The rest of the format is printed as it stands
+        }
+
+        if (type == ARG_STRING) {
+            const char *text = va_arg(args, const char *);
+            if (text == NULL) {
+                text = "(null)";
+            }
+            uint16_t text_length = (uint16_t)strnlen(text, LOG_MAX_STRING);
+            size_t need = align8(sizeof(text_length) + text_length);
+            if (used + need > space) {
+                break;
+            }
+            memset(out + used, 0, need);
+            memcpy(out + used, &text_length, sizeof(text_length));
+            memcpy(out + used + sizeof(text_length), text, text_length);
+            used += need;
+            continue;
+        }
+
+        if (used + sizeof(int64_t) > space) {
+            break;
+        }
+        int64_t value = 0;
+        double real;
+        switch (type) {
+        case ARG_INT:
+            value = va_arg(args, int);
+            break;
+        case ARG_UINT:
+            value = va_arg(args, unsigned int);
+            break;
+        case ARG_LONG:
+            value = va_arg(args, long);
+            break;
+        case ARG_ULONG:
+            value = (int64_t)va_arg(args, unsigned long);
+            break;
+        case ARG_LLONG:
+            value = va_arg(args, long long);
+            break;
+        case ARG_ULLONG:
+            value = (int64_t)va_arg(args, unsigned long long);
+            break;
+        case ARG_SIZE:
+            value = (int64_t)va_arg(args, size_t);
+            break;
+        case ARG_POINTER:
+            value = (int64_t)(uintptr_t)va_arg(args, void *);
+            break;
+        case ARG_DOUBLE:
+            real = va_arg(args, double);
+            memcpy(&value, &real, sizeof(value));
+            break;
+        }
+        memcpy(out + used, &value, sizeof(value));
+        used += sizeof(value);
+    }
+    return used;
+}
+
+// Function to append text to a bounded line
+static void append_text(char *out, size_t size, size_t *written, const char *text, size_t length) {
+    if (*written + length >= size) {
+        length = size - 1 - *written;
+    }
+    memcpy(out + *written, text, length);
+    *written += length;
+    out[*written] = '\0';
+}
+
+// Function to format a message from its format and stored arguments; returns the length written
+size_t log_format_message(char *out, size_t size, const char *format, const unsigned char *args, size_t args_size) {
+    size_t written = 0;
+    size_t used = 0;
+    if (size == 0) {
+        return 0;
+    }
+    out[0] = '\0';
+
+    while (1) {
+        size_t length;
+        int type;
+        const char *spec = next_conversion(format, &length, &type);
+        append_text(out, size, &written, format, spec != NULL ? (size_t)(spec - format) : strlen(format));
+        if (spec == NULL) {
+            break;
+        }
+        format = spec + length;
+        if (type == ARG_LITERAL) {
+            append_text(out, size, &written, "%", 1);
+            continue;
+        }
+
+        char conversion[32];
+        if (type == ARG_UNSUPPORTED || length >= sizeof(conversion)) {
+            append_text(out, size, &written, spec, strlen(spec)); // No arguments were stored past this point
+            break;
+        }
+        memcpy(conversion, spec, length);
+        conversion[length] = '\0';
+
+        int printed = 0;
+        if (type == ARG_STRING) {
+            uint16_t text_length;
+            if (used + sizeof(text_length) > args_size) {
+                break;
+            }
+            memcpy(&text_length, args + used, sizeof(text_length));
+            size_t need = align8(sizeof(text_length) + text_length);
+            if (text_length > LOG_MAX_STRING || used + need > args_size) {
+                break;
+            }
+            char text[LOG_MAX_STRING + 1];
+            memcpy(text, args + used + sizeof(text_length), text_length);
+            text[text_length] = '\0';
+            used += need;
+            printed = snprintf(out + written, size - written, conversion, text);
+        } else {
+            int64_t value;
+            if (used + sizeof(value) > args_size) {
+                break;
+            }
+            memcpy(&value, args + used, sizeof(value));
+            used += sizeof(value);
+            double real;
+            switch (type) {
+            case ARG_INT:
+                printed = snprintf(out + written, size - written, conversion, (int)value);
+                break;
+            case ARG_UINT:
+                printed = snprintf(out + written, size - written, conversion, (unsigned int)value);
+                break;
+            case ARG_LONG:
+                printed = snprintf(out + written, size - written, conversion, (long)value);
+                break;
+            case ARG_ULONG:
+                printed = snprintf(out + written, size - written, conversion, (unsigned long)value);
+                break;
+            case ARG_LLONG:
+                printed = snprintf(out + written, size - written, conversion, (long long)value);
+                break;
+            case ARG_ULLONG:
+                printed = snprintf(out + written, size - written, conversion, (unsigned long long)value);
+                break;
+            case ARG_SIZE:
+                printed = snprintf(out + written, size - written, conversion, (size_t)value);
+                break;
+            case ARG_POINTER:
+                printed = snprintf(out + written, size - written, conversion, (void *)(uintptr_t)value);
+                break;
+            case ARG_DOUBLE:
+                memcpy(&real, &value, sizeof(real));
+                printed = snprintf(out + written, size - written, conversion, real);
+                break;
+            }
+        }
+        if (printed > 0) {
+            written += (size_t)printed < size - written ? (size_t)printed : size - 1 - written;
+        }
+    }
+    return written;
+}
+
+// Function to build a message record; returns its size
+static size_t make_record(unsigned char *record, int level, int64_t time_ns, const char *format, va_list args) {
+    LogRecordHeader *header = (LogRecordHeader *)record;
+    size_t size = sizeof(*header) + encode_arguments(record + sizeof(*header), LOG_MAX_RECORD - sizeof(*header),
+                                                     format, args);
+    header->size = (uint16_t)size;
+    header->level = (uint8_t)level;
+    header->kind = LOG_RECORD_MESSAGE;
+    header->pid = process_id;
+    header->time_ns = time_ns;
+    header->format = (uint64_t)(uintptr_t)format;
+    return size;
+}
+
+// Function to release a thread's buffer when the thread exits (the writer still drains what it holds)
+static void release_ring(void *claim) {
+    __atomic_store_n((int *)claim, 0, __ATOMIC_RELEASE);
+}
+
+// Function to claim a free buffer for the calling thread; returns NULL when every buffer is taken.
+// Buffers the writer has drained come first, so a thread replacing one that just exited starts empty.
+static LogRing *claim_ring(void) {
+    for (int i = 0; i < 2 * LOG_MAX_RINGS; i++) {
+        int slot = i % LOG_MAX_RINGS;
+        LogRing *ring = __atomic_load_n(&rings[slot], __ATOMIC_ACQUIRE);
+        if (i < LOG_MAX_RINGS && ring != NULL &&
+            __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE) != __atomic_load_n(&ring->head, __ATOMIC_RELAXED)) {
+            continue;
+        }
+        int expected = 0;
+        if (!__atomic_compare_exchange_n(&ring_claimed[slot], &expected, 1, 0, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED)) {
+            continue;
+        }
+        ring = __atomic_load_n(&rings[slot], __ATOMIC_ACQUIRE);
+        if (ring == NULL) {
+            void *memory;
+            if (posix_memalign(&memory, 64, sizeof(LogRing)) != 0) {
+                release_ring(&ring_claimed[slot]);
+                return NULL;
+            }
+            ring = memset(memory, 0, sizeof(LogRing));
+            __atomic_store_n(&rings[slot], ring, __ATOMIC_RELEASE);
+        }
+        int count = __atomic_load_n(&ring_count, __ATOMIC_RELAXED);
+        while (count < slot + 1 &&
+               !__atomic_compare_exchange_n(&ring_count, &count, slot + 1, 0, __ATOMIC_RELEASE, __ATOMIC_RELAXED)) {
+            // Another thread raised the count: retry against its value
+        }
+        thread_slot = slot;
+        pthread_setspecific(ring_key, &ring_claimed[slot]);
+        return ring;
+    }
+    return NULL;
+}
+
+// Function to append a record to the calling thread's buffer; returns 0, or -1 when it does not fit
+static int ring_append(LogRing *ring, const void *record, size_t size) {
+    unsigned long head = ring->head; // Only the owning thread writes the head
+    unsigned long tail = __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE);
+    size_t offset = head & (LOG_RING_BYTES - 1);
+    size_t pad = offset + size > LOG_RING_BYTES ? LOG_RING_BYTES - offset : 0;
+    if (head + pad + size - tail > LOG_RING_BYTES) {
+        return -1;
+    }
+    if (pad > 0) {
+        // Records never wrap: fill the end of the buffer and start again at its beginning
+        LogRecordHeader *filler = (LogRecordHeader *)(ring->data + offset);
+        filler->size = (uint16_t)pad;
+        filler->kind = LOG_RECORD_PAD;
+        offset = 0;
+    }
+    memcpy(ring->data + offset, record, size);
+    __atomic_store_n(&ring->head, head + pad + size, __ATOMIC_RELEASE);
+    return 0;
+}
+
+// Function to start a writer pass now instead of at the end of its interval
+static void wake_writer(void) {
+    pthread_mutex_lock(&wake_mutex);
+    wake_requested = 1;
+    pthread_cond_signal(&wake);
+    pthread_mutex_unlock(&wake_mutex);
+}
+
+// Function to log a message without blocking; dropped (and counted) when the thread's buffer is full
+void log_message(int level, const char *format, ...) {
+    if (level > log_level || !initialized) {
+        return;
+    }
+    LogRing *ring = thread_ring;
+    if (ring == NULL && (ring = thread_ring = claim_ring()) == NULL) {
+        __atomic_add_fetch(&unattached_dropped, 1, __ATOMIC_RELAXED);
+        return;
+    }
+
+    unsigned char record[LOG_MAX_RECORD] __attribute__((aligned(8)));
+    va_list args;
+    va_start(args, format);
+    size_t size = make_record(record, level, now_ns(), format, args);
+    va_end(args);
+
+    int appended;
+    while ((appended = ring_append(ring, record, size)) != 0 && wait_when_full && writer_running) {
+        wake_writer();
+        struct timespec wait = { 0, 50000L };
+        nanosleep(&wait, NULL);
+    }
+    if (appended == 0) {
+        __atomic_store_n(&ring->logged, ring->logged + 1, __ATOMIC_RELAXED);
+    } else {
+        __atomic_store_n(&ring->dropped, ring->dropped + 1, __ATOMIC_RELAXED);
+    }
+}
+
+// Function to write a whole buffer to a descriptor, retrying short and interrupted writes
+static void write_all(int fd, const char *data, size_t length) {
+    while (length > 0) {
+        ssize_t written = write(fd, data, length);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return; // Nowhere to report it: the output itself failed
+        }
+        data += written;
+        length -= (size_t)written;
+    }
+}
+
+// Function to write collected output
+static void output_flush(LogOutput *output) {
+    if (output->length > 0 && output->fd >= 0) {
+        write_all(output->fd, output->data, output->length);
+    }
+    output->length = 0;
+}
+
+// Function to make room for length more bytes of output
+static char *output_reserve(LogOutput *output, size_t length) {
+    if (output->length + length > sizeof(output->data)) {
+        output_flush(output);
+    }
+    return output->data + output->length;
+}
+
+// Function to write a format string to the binary log the first time this process uses it
+static void announce_format(uint64_t key) {
+    size_t slot = (size_t)(key >> 3) % LOG_MAX_FORMATS;
+    for (int probe = 0; probe < LOG_MAX_FORMATS; probe++) {
+        if (announced[slot] == key) {
+            return;
+        }
+        if (announced[slot] == 0) {
+            announced[slot] = key;
+            break;
+        }
+        slot = (slot + 1) % LOG_MAX_FORMATS; // A full table announces again; the decoder keeps the first
+    }
+
+    const char *text = (const char *)(uintptr_t)key;
+    size_t text_length = strnlen(text, LOG_MAX_FORMAT_TEXT - 1);
+    LogRecordHeader header;
+    memset(&header, 0, sizeof(header));
+    header.size = (uint16_t)align8(sizeof(header) + text_length + 1);
+    header.kind = LOG_RECORD_FORMAT;
+    header.pid = process_id;
+    header.time_ns = last_time_ns;
+    header.format = key;
+
+    char *out = output_reserve(&binary_output, header.size);
+    memset(out, 0, header.size);
+    memcpy(out, &header, sizeof(header));
+    memcpy(out + sizeof(header), text, text_length);
+    binary_output.length += header.size;
+}
+
+// Function to write one message as a binary record or a text line
+static void emit(const LogRecordHeader *record) {
+    last_time_ns = record->time_ns;
+    if (binary_fd >= 0) {
+        announce_format(record->format);
+        memcpy(output_reserve(&binary_output, record->size), record, record->size);
+        binary_output.length += record->size;
+        return;
+    }
+
+    LogOutput *output = record->level <= LOG_WARN ? &error_output : &text_output;
+    char *line = output_reserve(output, LOG_LINE_BYTES);
+    int prefix = snprintf(line, LOG_LINE_BYTES, "%9.3f %-5s ", record->time_ns / 1e9, log_level_name(record->level));
+    size_t length = (size_t)prefix + log_format_message(line + prefix, LOG_LINE_BYTES - prefix - 1,
+                                                        (const char *)(uintptr_t)record->format,
+                                                        (const unsigned char *)(record + 1),
+                                                        record->size - sizeof(*record));
+    if (length == 0 || line[length - 1] != '\n') {
+        line[length++] = '\n';
+    }
+    output->length += length;
+}
+
+// Function to emit a message from the writer itself
+static void emit_notice(int level, const char *format, ...) {
+    unsigned char record[LOG_MAX_RECORD] __attribute__((aligned(8)));
+    va_list args;
+    va_start(args, format);
+    make_record(record, level, last_time_ns, format, args);
+    va_end(args);
+    emit((const LogRecordHeader *)record);
+}
+
+// Function to return the oldest message a buffer holds, skipping filler; NULL when drained up to head
+static const LogRecordHeader *ring_front(LogRing *ring, unsigned long head) {
+    while (ring->tail != head) {
+        const LogRecordHeader *record = (const LogRecordHeader *)(ring->data + (ring->tail & (LOG_RING_BYTES - 1)));
+        if (record->kind != LOG_RECORD_PAD) {
+            return record;
+        }
+        __atomic_store_n(&ring->tail, ring->tail + record->size, __ATOMIC_RELEASE);
+    }
+    return NULL;
+}
+
+// Function to add the buffers' counts to the run totals and report messages dropped since the last pass
+static void account(int count) {
+    long logged = 0;
+    long dropped = 0;
+    for (int i = 0; i < count; i++) {
+        LogRing *ring = __atomic_load_n(&rings[i], __ATOMIC_ACQUIRE);
+        if (ring == NULL) {
+            continue;
+        }
+        long ring_logged = __atomic_load_n(&ring->logged, __ATOMIC_RELAXED);
+        long ring_dropped = __atomic_load_n(&ring->dropped, __ATOMIC_RELAXED);
+        logged += ring_logged - ring->reported_logged;
+        dropped += ring_dropped - ring->reported_dropped;
+        ring->reported_logged = ring_logged;
+        ring->reported_dropped = ring_dropped;
+    }
+    long unattached = __atomic_load_n(&unattached_dropped, __ATOMIC_RELAXED);
+    dropped += unattached - reported_unattached;
+    reported_unattached = unattached;
+
+    __atomic_add_fetch(&totals->logged, logged, __ATOMIC_RELAXED);
+    __atomic_add_fetch(&totals->dropped, dropped, __ATOMIC_RELAXED);
+    if (dropped > 0) {
+        emit_notice(LOG_WARN, "[Log] %ld messages dropped: thread buffers were full.", dropped);
+    }
+}
+
+// Function to write every buffered message, oldest first across the threads' buffers
+static void drain(void) {
+    LogRing *pending[LOG_MAX_RINGS];
+    unsigned long heads[LOG_MAX_RINGS];
+    int pending_count = 0;
+    int count = __atomic_load_n(&ring_count, __ATOMIC_ACQUIRE);
+    for (int i = 0; i < count; i++) {
+        LogRing *ring = __atomic_load_n(&rings[i], __ATOMIC_ACQUIRE);
+        if (ring == NULL) {
+            continue;
+        }
+        unsigned long head = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+        if (ring->tail != head) {
+            pending[pending_count] = ring;
+            heads[pending_count] = head;
+            pending_count++;
+        }
+    }
+
+    // Merge the buffers by timestamp so lines from different threads come out in order
+    while (pending_count > 0) {
+        int oldest = -1;
+        const LogRecordHeader *oldest_record = NULL;
+        for (int i = 0; i < pending_count; i++) {
+            const LogRecordHeader *record = ring_front(pending[i], heads[i]);
+            if (record == NULL) {
+                pending_count--;
+                pending[i] = pending[pending_count];
+                heads[i] = heads[pending_count];
+                i--;
+                continue;
+            }
+            if (oldest_record == NULL || record->time_ns < oldest_record->time_ns) {
+                oldest = i;
+                oldest_record = record;
+            }
+        }
+        if (oldest_record == NULL) {
+            break;
+        }
+        emit(oldest_record);
+        __atomic_store_n(&pending[oldest]->tail, pending[oldest]->tail + oldest_record->size, __ATOMIC_RELEASE);
+    }
+
+    account(count);
+    output_flush(&binary_output);
+    output_flush(&text_output);
+    output_flush(&error_output);
+    __atomic_add_fetch(&writer_passes, 1, __ATOMIC_RELEASE);
+}
+
+// Thread function of the writer: drain the buffers at a fixed interval until stopped
+static void *writer_main(void *args) {
+    (void)args;
+    while (!__atomic_load_n(&writer_stop, __ATOMIC_ACQUIRE)) {
+        struct timespec deadline;
+        clock_gettime(CLOCK_MONOTONIC, &deadline);
+        deadline.tv_nsec += LOG_FLUSH_MS * 1000000L;
+        if (deadline.tv_nsec >= 1000000000L) {
+            deadline.tv_sec++;
+            deadline.tv_nsec -= 1000000000L;
+        }
+        pthread_mutex_lock(&wake_mutex);
+        while (!wake_requested && pthread_cond_timedwait(&wake, &wake_mutex, &deadline) == 0) {
+            // Spurious wakeup: keep waiting for the deadline
+        }
+        wake_requested = 0;
+        pthread_mutex_unlock(&wake_mutex);
+
+        int exiting = exit_requested;
+        drain();
+        if (exiting) {
+            _exit(EXIT_SUCCESS);
+        }
+    }
+    drain();
+    return NULL;
+}
+
+// Function to start the writer thread of this process
+static int start_writer(void) {
+    pthread_condattr_t attributes;
+    pthread_condattr_init(&attributes);
+    pthread_condattr_setclock(&attributes, CLOCK_MONOTONIC);
+    pthread_mutex_init(&wake_mutex, NULL); // In a forked child the parent's writer may have held it
+    pthread_cond_init(&wake, &attributes);
+    pthread_condattr_destroy(&attributes);
+    wake_requested = 0;
+    __atomic_store_n(&writer_stop, 0, __ATOMIC_RELAXED);
+    if (pthread_create(&writer_thread, NULL, writer_main, NULL) != 0) {
+        perror("[Log] Failed to start the log writer");
+        return -1;
+    }
+    writer_running = 1;
+    return 0;
+}
+
+// Function to start logging (before any other thread or fork)
+int log_init(int level, const char *binary_path) {
+    log_level = level > 0 ? level : LOG_DEFAULT_LEVEL;
+
+    totals = mmap(NULL, sizeof(LogTotals), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (totals == MAP_FAILED) {
+        perror("[Log] Failed to map log counters");
+        totals = NULL;
+        return -1;
+    }
+    if (pthread_key_create(&ring_key, release_ring) != 0) {
+        perror("[Log] Failed to create the thread buffer key");
+        return -1;
+    }
+
+    if (binary_path != NULL) {
+        binary_fd = open(binary_path, O_WRONLY | O_CREAT | O_TRUNC | O_APPEND, 0644);
+        if (binary_fd < 0) {
+            perror("[Log] Failed to open binary log");
+            return -1;
+        }
+        LogFileHeader header = { LOG_MAGIC, LOG_VERSION };
+        write_all(binary_fd, (const char *)&header, sizeof(header));
+        binary_output.fd = binary_fd;
+    }
+
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    origin_ns = (int64_t)now.tv_sec * 1000000000 + now.tv_nsec;
+    process_id = (uint32_t)getpid();
+    fflush(stdout); // Anything printed before logging started comes first
+    initialized = 1;
+
+    if (start_writer() != 0) {
+        initialized = 0;
+        return -1;
+    }
+    atexit(log_shutdown);
+    return 0;
+}
+
+// Function to stamp messages with another clock in milliseconds
+void log_set_clock(long (*clock_ms)(void)) {
+    clock_ms_hook = clock_ms;
+}
+
+// Function to make threads whose buffer is full wait for the writer instead of dropping the message
+void log_wait_when_full(int wait) {
+    wait_when_full = wait;
+}
+
+// Function to restart logging in a forked child: drop the parent's buffered messages and start a writer
+void log_after_fork(void) {
+    if (!initialized) {
+        return;
+    }
+    writer_running = 0; // The parent's writer thread was not copied
+    exit_requested = 0;
+    process_id = (uint32_t)getpid();
+
+    // The parent writes what it had buffered; only the forking thread exists here
+    for (int i = 0; i < ring_count; i++) {
+        LogRing *ring = rings[i];
+        if (ring != NULL) {
+            ring->tail = ring->head;
+            ring->reported_logged = ring->logged;
+            ring->reported_dropped = ring->dropped;
+        }
+        if (i != thread_slot) {
+            ring_claimed[i] = 0;
+        }
+    }
+    reported_unattached = unattached_dropped;
+    memset(announced, 0, sizeof(announced));
+    text_output.length = 0;
+    error_output.length = 0;
+    binary_output.length = 0;
+
+    start_writer();
+}
+
+// Signal handler: let the writer finish its pass, then end the process
+static void request_exit(int sig) {
+    (void)sig;
+    if (!writer_running) {
+        _exit(EXIT_SUCCESS);
+    }
+    exit_requested = 1;
+}
+
+// Function to end the process on a signal once the writer has written everything logged
+void log_exit_on_signal(int sig) {
+    signal(sig, request_exit);
+}
+
+// Function to wait until everything this process logged before the call has been written
+void log_flush(void) {
+    if (!writer_running) {
+        return;
+    }
+    // The pass under way may have started before the call: wait for the one after it
+    long target = __atomic_load_n(&writer_passes, __ATOMIC_ACQUIRE) + 2;
+    struct timespec wait = { 0, 1000000L };
+    while (__atomic_load_n(&writer_passes, __ATOMIC_ACQUIRE) < target) {
+        nanosleep(&wait, NULL);
+    }
+}
+
+// Function to read the messages logged and dropped by every process of the run, as of their last write
+void log_totals(long *logged, long *dropped) {
+    *logged = totals != NULL ? __atomic_load_n(&totals->logged, __ATOMIC_RELAXED) : 0;
+    *dropped = totals != NULL ? __atomic_load_n(&totals->dropped, __ATOMIC_RELAXED) : 0;
+}
+
+// Function to stop the writer after it has written everything logged (also run at exit)
+void log_shutdown(void) {
+    if (!writer_running) {
+        return;
+    }
+    __atomic_store_n(&writer_stop, 1, __ATOMIC_RELEASE);
+    wake_writer();
+    pthread_join(writer_thread, NULL);
+    writer_running = 0;
+}
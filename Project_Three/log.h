@@ -0,0 +1,87 @@
+// log.h
+#ifndef LOG_H
+#define LOG_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define LOG_MAGIC 0x474F4C53 // "SLOG"
+#define LOG_VERSION 1
+
+// Message levels; a message is kept when its level is at or below the configured level
+typedef enum {
+    LOG_ERROR = 1,
+    LOG_WARN,
+    LOG_INFO,
+    LOG_DEBUG
+} LogLevel;
+
+#define LOG_DEFAULT_LEVEL LOG_INFO
+
+// Kinds of records in a thread buffer and in a binary log
+typedef enum {
+    LOG_RECORD_PAD = 0,  // Filler up to the end of a thread buffer (never written to a log)
+    LOG_RECORD_MESSAGE,  // A message: its arguments follow the header
+    LOG_RECORD_FORMAT    // The text of a format key follows the header
+} LogRecordKind;
+
+// Header of a record (24 bytes). Records are padded to 8 bytes. Message arguments are stored as
+// 8-byte values, and strings as a 16-bit length followed by their bytes.
+typedef struct {
+    uint16_t size;    // Bytes in the record including this header
+    uint8_t level;
+    uint8_t kind;     // LogRecordKind
+    uint32_t pid;
+    int64_t time_ns;  // Nanoseconds since log_init (simulated time in virtual-time runs)
+    uint64_t format;  // Address of the format string, the same in every process forked after log_init
+} LogRecordHeader;
+
+// Binary log file header; records follow it, and every process of the run appends to the same file
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+} LogFileHeader;
+
+// Function to start logging (before any other thread or fork); text goes to stdout and stderr,
+// or records go to binary_path when it is not NULL. Returns 0 on success, -1 on failure.
+int log_init(int level, const char *binary_path);
+
+// Function to stamp messages with another clock in milliseconds (the simulated clock in virtual time)
+void log_set_clock(long (*clock_ms)(void));
+
+// Function to make threads whose buffer is full wait for the writer instead of dropping the message
+// (for virtual time, where one thread logs as fast as it can and nothing has a deadline)
+void log_wait_when_full(int wait);
+
+// Function to restart logging in a forked child: drop the parent's buffered messages and start a writer
+void log_after_fork(void);
+
+// Function to end the process on a signal once the writer has written everything logged
+void log_exit_on_signal(int sig);
+
+// Function to log a message without blocking; dropped (and counted) when the thread's buffer is full
+// unless threads were told to wait.
+// Conversions: d i u x X o c with h, hh, l, ll or z; f F e E g G a A; s; p; and %%.
+void log_message(int level, const char *format, ...) __attribute__((format(printf, 2, 3)));
+
+#define log_error(...) log_message(LOG_ERROR, __VA_ARGS__)
+#define log_warn(...) log_message(LOG_WARN, __VA_ARGS__)
+#define log_info(...) log_message(LOG_INFO, __VA_ARGS__)
+#define log_debug(...) log_message(LOG_DEBUG, __VA_ARGS__)
+
+// Function to wait until everything this process logged before the call has been written
+void log_flush(void);
+
+// Function to read the messages logged and dropped by every process of the run, as of their last write
+void log_totals(long *logged, long *dropped);
+
+// Function to stop the writer after it has written everything logged (also run at exit)
+void log_shutdown(void);
+
+// Function to name a level as printed
+const char *log_level_name(int level);
+
+// Function to format a message from its format and stored arguments; returns the length written
+size_t log_format_message(char *out, size_t size, const char *format, const unsigned char *args, size_t args_size);
+
+#endif
@@ -0,0 +1,172 @@
+// log_decode.c
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include "log.h"
+
+#define MAX_FORMATS 4096 // Distinct format strings a log may hold (a power of two)
+#define LINE_BYTES 1024
+
+// Format string of a key, as written by the first process that used it
+typedef struct {
+    uint64_t key;
+    const char *text;
+} FormatEntry;
+
+static FormatEntry formats[MAX_FORMATS];
+static const unsigned char *log_data = NULL;
+
+// Function to print usage
+static void usage(const char *program) {
+    fprintf(stderr, "Usage: %s simulation.slog [--level N] [--pid]\n"
+                    "          (levels: 1 = errors, 2 = warnings, 3 = events, 4 = activity)\n", program);
+}
+
+// Function to find the slot of a format key (the slot is free when the key is not stored)
+static FormatEntry *format_slot(uint64_t key) {
+    size_t slot = (size_t)(key >> 3) & (MAX_FORMATS - 1);
+    for (int probe = 0; probe < MAX_FORMATS; probe++) {
+        if (formats[slot].key == key || formats[slot].key == 0) {
+            return &formats[slot];
+        }
+        slot = (slot + 1) & (MAX_FORMATS - 1);
+    }
+    return NULL;
+}
+
+// Function to order messages by time, then by position in the file
+static int compare_messages(const void *a, const void *b) {
+    long offset_a = *(const long *)a;
+    long offset_b = *(const long *)b;
+    const LogRecordHeader *record_a = (const LogRecordHeader *)(log_data + offset_a);
+    const LogRecordHeader *record_b = (const LogRecordHeader *)(log_data + offset_b);
+    if (record_a->time_ns != record_b->time_ns) {
+        return record_a->time_ns < record_b->time_ns ? -1 : 1;
+    }
+    return (offset_a > offset_b) - (offset_a < offset_b);
+}
+
+// Function to read a whole file; returns NULL on failure
+static unsigned char *read_file(const char *path, long *size) {
+    FILE *file = fopen(path, "rb");
+    if (file == NULL) {
+        perror("[Decode] Failed to open log");
+        return NULL;
+    }
+    unsigned char *data = NULL;
+    if (fseek(file, 0, SEEK_END) == 0 && (*size = ftell(file)) >= 0 && fseek(file, 0, SEEK_SET) == 0) {
+        data = malloc(*size > 0 ? *size : 1);
+        if (data == NULL) {
+            perror("[Decode] Failed to allocate the log");
+        } else if (fread(data, 1, *size, file) != (size_t)*size) {
+            perror("[Decode] Failed to read log");
+            free(data);
+            data = NULL;
+        }
+    } else {
+        perror("[Decode] Failed to size log");
+    }
+    fclose(file);
+    return data;
+}
+
+// Main function
+int main(int argc, char *argv[]) {
+    const char *path = NULL;
+    int max_level = LOG_DEBUG;
+    int show_pid = 0;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--level") == 0 && i + 1 < argc) {
+            max_level = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--pid") == 0) {
+            show_pid = 1;
+        } else if (argv[i][0] != '-' && path == NULL) {
+            path = argv[i];
+        } else {
+            usage(argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+    if (path == NULL) {
+        usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    long size;
+    unsigned char *data = read_file(path, &size);
+    if (data == NULL) {
+        return EXIT_FAILURE;
+    }
+    log_data = data;
+    LogFileHeader header;
+    if (size < (long)sizeof(header) || (memcpy(&header, data, sizeof(header)), header.magic != LOG_MAGIC)) {
+        fprintf(stderr, "[Decode] %s is not a binary simulation log.\n", path);
+        free(data);
+        return EXIT_FAILURE;
+    }
+    if (header.version != LOG_VERSION) {
+        fprintf(stderr, "[Decode] Log version %u is not supported (expected %d).\n", header.version, LOG_VERSION);
+        free(data);
+        return EXIT_FAILURE;
+    }
+
+    // First pass: collect format strings and messages. Processes write concurrently, so a message may
+    // come before the format record another process wrote for the same key.
+    long *messages = malloc(sizeof(long) * (size / sizeof(LogRecordHeader) + 1));
+    if (messages == NULL) {
+        perror("[Decode] Failed to allocate the message index");
+        free(data);
+        return EXIT_FAILURE;
+    }
+    long message_count = 0;
+    long offset = sizeof(header);
+    while (offset + (long)sizeof(LogRecordHeader) <= size) {
+        const LogRecordHeader *record = (const LogRecordHeader *)(data + offset);
+        if (record->size < sizeof(LogRecordHeader) || record->size % 8 != 0 || offset + record->size > size) {
+            fprintf(stderr, "[Decode] Log is cut or damaged at byte %ld; decoding what came before.\n", offset);
+            break;
+        }
+        if (record->kind == LOG_RECORD_FORMAT) {
+            FormatEntry *entry = format_slot(record->format);
+            if (entry != NULL && entry->key == 0 && data[offset + record->size - 1] == '\0') {
+                entry->key = record->format;
+                entry->text = (const char *)(record + 1);
+            }
+        } else if (record->kind == LOG_RECORD_MESSAGE && record->level <= max_level) {
+            messages[message_count++] = offset;
+        }
+        offset += record->size;
+    }
+
+    // Second pass: print the messages of every process in time order
+    qsort(messages, message_count, sizeof(long), compare_messages);
+    long unknown = 0;
+    for (long i = 0; i < message_count; i++) {
+        const LogRecordHeader *record = (const LogRecordHeader *)(data + messages[i]);
+        FormatEntry *entry = format_slot(record->format);
+        if (entry == NULL || entry->key == 0) {
+            unknown++;
+            continue;
+        }
+        char line[LINE_BYTES];
+        log_format_message(line, sizeof(line), entry->text, (const unsigned char *)(record + 1),
+                           record->size - sizeof(*record));
+        size_t length = strlen(line);
+        if (length > 0 && line[length - 1] == '\n') {
+            line[length - 1] = '\0';
+        }
+        if (show_pid) {
+            printf("%9.3f %-5s %6u %s\n", record->time_ns / 1e9, log_level_name(record->level), record->pid, line);
+        } else {
+            printf("%9.3f %-5s %s\n", record->time_ns / 1e9, log_level_name(record->level), line);
+        }
+    }
+    if (unknown > 0) {
+        fprintf(stderr, "[Decode] %ld messages skipped: their format strings are missing from the log.\n", unknown);
+    }
+
+    free(messages);
+    free(data);
+    return 0;
+}
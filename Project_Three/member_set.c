@@ -0,0 +1,211 @@
+// member_set.c
+#include "member_set.h"
+#include <sched.h>
+#include <stdlib.h>
+
+#define REBUILD_CLAIMED (MEMBER_SET_CAPACITY / 2) // Claimed slots past which removed slots are purged
+#define REBUILD_REMOVED (MEMBER_SET_CAPACITY / 4) // Removed slots a rebuild must reclaim to be worth its pass
+
+// Function to pick the first probe slot for a member id (Fibonacci hashing)
+static unsigned int member_hash(int member_id) {
+    return ((unsigned int)member_id * 2654435761u) & (MEMBER_SET_CAPACITY - 1);
+}
+
+// Function to take the writer lock; writers hold it for one O(1) update or, rarely, a rebuild
+static void lock_writers(MemberSet *set) {
+    while (__atomic_exchange_n(&set->writer, 1, __ATOMIC_ACQUIRE)) {
+        sched_yield();
+    }
+}
+
+// Function to release the writer lock
+static void unlock_writers(MemberSet *set) {
+    __atomic_store_n(&set->writer, 0, __ATOMIC_RELEASE);
+}
+
+// Function to find the slot holding a key; returns -1 when the key is not in the table
+static int find_slot(MemberSet *set, int member_id) {
+    unsigned int slot = member_hash(member_id);
+    for (int probes = 0; probes < MEMBER_SET_CAPACITY; probes++) {
+        int key = __atomic_load_n(&set->entries[slot].key, __ATOMIC_ACQUIRE);
+        if (key == member_id) {
+            return (int)slot;
+        }
+        if (key == 0) {
+            return -1;
+        }
+        slot = (slot + 1) & (MEMBER_SET_CAPACITY - 1);
+    }
+    return -1;
+}
+
+// Function to fill a slot with a present member (writer lock held); the key goes first so readers never see
+// a present flag under the key it replaced
+static void fill_slot(MemberSetEntry *entry, int member_id, int value) {
+    __atomic_store_n(&entry->key, member_id, __ATOMIC_RELEASE);
+    __atomic_store_n(&entry->value, value, __ATOMIC_RELAXED);
+    __atomic_store_n(&entry->present, 1, __ATOMIC_RELEASE);
+}
+
+// Function to list a slot that just became present (writer lock held)
+static void track_present(MemberSet *set, int slot) {
+    set->entries[slot].position = set->count;
+    set->present_slots[set->count] = slot;
+    __atomic_fetch_add(&set->count, 1, __ATOMIC_RELAXED);
+}
+
+// Function to unlist a slot that just stopped being present (writer lock held); the last listed slot fills the gap
+static void untrack_present(MemberSet *set, int slot) {
+    int position = set->entries[slot].position;
+    int last = set->present_slots[set->count - 1];
+    set->present_slots[position] = last;
+    set->entries[last].position = position;
+    __atomic_fetch_sub(&set->count, 1, __ATOMIC_RELAXED);
+}
+
+// Function to rebuild the table with only its present members (writer lock held). Readers that overlap see
+// the sequence change and retry. Without memory for the copy the removed slots simply stay.
+static void rebuild(MemberSet *set) {
+    MemberSetEntry *kept = malloc(sizeof(MemberSetEntry) * (set->count > 0 ? set->count : 1));
+    if (kept == NULL) {
+        return;
+    }
+    int kept_count = 0;
+    for (int i = 0; i < MEMBER_SET_CAPACITY; i++) {
+        if (set->entries[i].key != 0 && set->entries[i].present) {
+            kept[kept_count++] = set->entries[i];
+        }
+    }
+
+    // Odd sequence: lookups that started before the rebuild will retry
+    __atomic_store_n(&set->sequence, set->sequence + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    for (int i = 0; i < MEMBER_SET_CAPACITY; i++) {
+        __atomic_store_n(&set->entries[i].present, 0, __ATOMIC_RELAXED);
+        __atomic_store_n(&set->entries[i].key, 0, __ATOMIC_RELAXED);
+    }
+    for (int k = 0; k < kept_count; k++) {
+        unsigned int slot = member_hash(kept[k].key);
+        while (set->entries[slot].key != 0) {
+            slot = (slot + 1) & (MEMBER_SET_CAPACITY - 1);
+        }
+        fill_slot(&set->entries[slot], kept[k].key, kept[k].value);
+        set->entries[slot].position = k;
+        set->present_slots[k] = (int)slot;
+    }
+    set->claimed = kept_count;
+    __atomic_store_n(&set->sequence, set->sequence + 1, __ATOMIC_RELEASE);
+    free(kept);
+}
+
+// Function to check whether a member is in the set (no lock; retries across a rebuild)
+int member_set_contains(MemberSet *set, int member_id) {
+    while (1) {
+        unsigned int sequence = __atomic_load_n(&set->sequence, __ATOMIC_ACQUIRE);
+        if (sequence & 1) {
+            sched_yield(); // A writer is rebuilding the table
+            continue;
+        }
+        int slot = find_slot(set, member_id);
+        int present = slot >= 0 && __atomic_load_n(&set->entries[slot].present, __ATOMIC_ACQUIRE);
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        if (__atomic_load_n(&set->sequence, __ATOMIC_RELAXED) == sequence) {
+            return present;
+        }
+    }
+}
+
+// Function to add a member with a value; returns 1 if added, 0 if already present, -1 if the set is full
+int member_set_add(MemberSet *set, int member_id, int value) {
+    if (member_id <= 0) {
+        return -1;
+    }
+    lock_writers(set);
+
+    // Look for the member's own slot, noting the first removed slot on the way in case it has none
+    unsigned int slot = member_hash(member_id);
+    int reuse = -1;
+    int probes;
+    for (probes = 0; probes < MEMBER_SET_CAPACITY; probes++) {
+        MemberSetEntry *entry = &set->entries[slot];
+        if (entry->key == member_id || entry->key == 0) {
+            break;
+        }
+        if (reuse < 0 && !entry->present) {
+            reuse = (int)slot;
+        }
+        slot = (slot + 1) & (MEMBER_SET_CAPACITY - 1);
+    }
+
+    int result = 1;
+    int filled = (int)slot;
+    if (probes < MEMBER_SET_CAPACITY && set->entries[slot].key == member_id) {
+        MemberSetEntry *entry = &set->entries[slot];
+        __atomic_store_n(&entry->value, value, __ATOMIC_RELAXED);
+        if (entry->present) {
+            result = 0;
+        } else {
+            __atomic_store_n(&entry->present, 1, __ATOMIC_RELEASE);
+        }
+    } else if (reuse >= 0) {
+        fill_slot(&set->entries[reuse], member_id, value); // Take over a removed member's slot
+        filled = reuse;
+    } else if (probes < MEMBER_SET_CAPACITY) {
+        fill_slot(&set->entries[slot], member_id, value);
+        set->claimed++;
+    } else {
+        result = -1; // Every slot holds a present member
+    }
+    if (result == 1) {
+        track_present(set, filled);
+    }
+
+    // Purge removed slots once they crowd the table, so misses keep stopping at an empty slot within a few probes
+    if (set->claimed > REBUILD_CLAIMED && set->claimed - set->count >= REBUILD_REMOVED) {
+        rebuild(set);
+    }
+    unlock_writers(set);
+    return result;
+}
+
+// Function to remove a member; returns 1 if it was present
+int member_set_remove(MemberSet *set, int member_id) {
+    lock_writers(set);
+    int slot = find_slot(set, member_id);
+    if (slot < 0 || !set->entries[slot].present) {
+        unlock_writers(set);
+        return 0;
+    }
+    __atomic_store_n(&set->entries[slot].present, 0, __ATOMIC_RELEASE);
+    untrack_present(set, slot);
+
+    // Removed slots just before an empty one end no probe path, so they can be emptied at once
+    unsigned int next = ((unsigned int)slot + 1) & (MEMBER_SET_CAPACITY - 1);
+    unsigned int tail = (unsigned int)slot;
+    while (set->entries[next].key == 0 && set->entries[tail].key != 0 && !set->entries[tail].present) {
+        __atomic_store_n(&set->entries[tail].key, 0, __ATOMIC_RELEASE);
+        set->claimed--;
+        next = tail;
+        tail = (tail - 1) & (MEMBER_SET_CAPACITY - 1);
+    }
+    unlock_writers(set);
+    return 1;
+}
+
+// Function to read the number of members present
+int member_set_count(MemberSet *set) {
+    return __atomic_load_n(&set->count, __ATOMIC_RELAXED);
+}
+
+// Function to copy up to max present members into member_ids/values; returns how many were copied
+int member_set_snapshot(MemberSet *set, int *member_ids, int *values, int max) {
+    lock_writers(set);
+    int copied = set->count < max ? set->count : max;
+    for (int k = 0; k < copied; k++) {
+        MemberSetEntry *entry = &set->entries[set->present_slots[k]];
+        member_ids[k] = entry->key;
+        values[k] = entry->value;
+    }
+    unlock_writers(set);
+    return copied;
+}
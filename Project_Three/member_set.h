@@ -0,0 +1,45 @@
+// member_set.h
+#ifndef MEMBER_SET_H
+#define MEMBER_SET_H
+
+#define MEMBER_SET_CAPACITY 8192 // Slots per set (power of two); caps the members present at once, not the ids seen
+
+// One slot of the set; a removed member's slot keeps its key until a later add reuses it or the table is rebuilt
+typedef struct {
+    int key;      // Member id (0 = empty)
+    int present;  // 1 while the member is in the set
+    int value;    // Caller data stored with the member (e.g. its group handle)
+    int position; // Index in present_slots while present
+} MemberSetEntry;
+
+// Open-addressing set of member ids living in shared memory.
+// Lookups take no lock: they probe with atomic loads and retry only if the table was rebuilt meanwhile.
+// Add and remove are O(1) under a short writer spin lock. Removed slots are reused by later adds, and once
+// they crowd the table it is rebuilt, so probes stay short however many distinct ids pass through the set.
+typedef struct {
+    MemberSetEntry entries[MEMBER_SET_CAPACITY];
+    int present_slots[MEMBER_SET_CAPACITY]; // Slots of the present members, densely in the first count places
+    int count;             // Members currently present
+    int claimed;           // Slots holding a key, present or removed
+    int writer;            // 1 while a writer holds the set
+    unsigned int sequence; // Odd while the table is being rebuilt
+} MemberSet;
+
+// Function to check whether a member is in the set (wait-free)
+int member_set_contains(MemberSet *set, int member_id);
+
+// Function to add a member with a value; returns 1 if added, 0 if already present, -1 if the set is full
+int member_set_add(MemberSet *set, int member_id, int value);
+
+// Function to remove a member; returns 1 if it was present
+int member_set_remove(MemberSet *set, int member_id);
+
+// Function to read the number of members present
+int member_set_count(MemberSet *set);
+
+// Function to copy up to max present members into member_ids/values; returns how many were copied.
+// Takes the writer lock for the copy, so it costs the members present rather than the capacity and
+// never sees a rebuild half done.
+int member_set_snapshot(MemberSet *set, int *member_ids, int *values, int max);
+
+#endif
@@ -0,0 +1,21 @@
+// run_summary.h
+#ifndef RUN_SUMMARY_H
+#define RUN_SUMMARY_H
+
+// End state of one simulation run, written by simulation --summary-fd and read by batch
+typedef struct {
+    unsigned int seed;
+    int killed_resistance;
+    int injured_resistance;
+    int caught_resistance;
+    int killed_agency;
+    int injured_agency;
+    int caught_agency;
+    int total_arrests;
+    int total_imprisoned;
+    int total_released;
+    int total_resistance_groups;
+    double end_seconds; // Simulated time at termination
+} RunSummary;
+
+#endif
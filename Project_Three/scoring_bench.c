@@ -0,0 +1,200 @@
+// scoring_bench.c
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <semaphore.h>
+#include "group_table.h"
+#include "dirty_set.h"
+
+#define DEFAULT_ACTIVE 5             // Percentage of groups with spy time
+#define DEFAULT_THRESHOLD 0.02       // Suspicion threshold (spy time / agency time limit)
+#define DEFAULT_TIME_LIMIT 240       // Agency time limit in seconds
+#define TARGET_GROUPS_SCORED 50000000L // Groups scored per variant, spread over repeated sweeps
+#define MAX_SIZES 16                 // Group counts per invocation
+
+// Group record as the table stored it before the columns: hot fields, position and lock interleaved
+typedef struct {
+    int group_id;
+    int has_spy;
+    int is_military;
+    int spy_time;
+    int current_member_count;
+    float x;
+    float y;
+    int live_members;
+    sem_t lock;
+} RecordGroup;
+
+// Function to print usage
+static void usage(const char *program) {
+    fprintf(stderr, "Usage: %s [--active PERCENT] [--seed N] [groups...]\n"
+                    "          (default group counts: 1000 100000 1000000)\n", program);
+}
+
+// Function to read the monotonic clock in nanoseconds
+static long now_ns(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec * 1000000000L + now.tv_nsec;
+}
+
+// Function to score records one by one as the agency did: suspicion as a double against the threshold
+static int score_records(const RecordGroup *records, int groups, double threshold, int limit, int *candidates) {
+    int count = 0;
+    for (int i = 0; i < groups; i++) {
+        double suspicion = (double)records[i].spy_time / limit;
+        if (suspicion > threshold && records[i].has_spy) {
+            candidates[count++] = i;
+        }
+    }
+    return count;
+}
+
+// Function to score the columns one group at a time against the integer threshold
+static int score_columns(GroupTable *table, int groups, int min_spy_time, int *candidates) {
+    const int *spy_time = group_spy_time(table);
+    const int *has_spy = group_has_spy(table);
+    int count = 0;
+    for (int i = 0; i < groups; i++) {
+        if (spy_time[i] >= min_spy_time && has_spy[i]) {
+            candidates[count++] = i;
+        }
+    }
+    return count;
+}
+
+// Function to score only the dirty groups (those with spy time), a 64-group word at a time, as agents do
+static int score_dirty_words(GroupTable *table, DirtySet *dirty, int groups, int min_spy_time, int *candidates) {
+    int count = 0;
+    int i;
+    for (int first = 0; (i = dirty_set_next(dirty, first)) != -1 && i < groups; first += 64) {
+        first = i - i % 64;
+        count += group_table_candidates_in(table, first, dirty_set_word(dirty, first), min_spy_time,
+                                           candidates + count);
+    }
+    return count;
+}
+
+// Main function
+int main(int argc, char *argv[]) {
+    int active = DEFAULT_ACTIVE;
+    unsigned int seed = 1;
+    int sizes[MAX_SIZES];
+    int size_count = 0;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--active") == 0 && i + 1 < argc) {
+            active = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+            seed = (unsigned int)strtoul(argv[++i], NULL, 10);
+        } else if (argv[i][0] != '-' && size_count < MAX_SIZES && atoi(argv[i]) > 0) {
+            sizes[size_count++] = atoi(argv[i]);
+        } else {
+            usage(argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+    if (size_count == 0) {
+        sizes[size_count++] = 1000;
+        sizes[size_count++] = 100000;
+        sizes[size_count++] = 1000000;
+    }
+    if (active < 0 || active > 100) {
+        usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    // Smallest integer spy time above the threshold, as the agency computes it
+    int min_spy_time = 1;
+    while (!((double)min_spy_time / DEFAULT_TIME_LIMIT > DEFAULT_THRESHOLD)) {
+        min_spy_time++;
+    }
+
+    printf("[Bench] Suspicion scoring, %d%% of groups with spy time, threshold %.2f of %d s (spy time >= %d).\n",
+           active, DEFAULT_THRESHOLD, DEFAULT_TIME_LIMIT, min_spy_time);
+    printf("%10s %16s %16s %16s %16s %12s %10s\n", "groups", "records ns/grp", "columns ns/grp", "vector ns/grp",
+           "masked ns/grp", "candidates", "speedup");
+
+    for (int s = 0; s < size_count; s++) {
+        int groups = sizes[s];
+        RecordGroup *records = calloc(groups, sizeof(RecordGroup));
+        void *storage = malloc(sizeof(GroupTable) + group_table_storage_size(groups));
+        void *dirty_storage = malloc(sizeof(DirtySet) + dirty_set_storage_size(groups));
+        int *candidates = malloc(sizeof(int) * groups);
+        if (records == NULL || storage == NULL || dirty_storage == NULL || candidates == NULL) {
+            perror("[Bench] Failed to allocate groups");
+            free(records);
+            free(storage);
+            free(dirty_storage);
+            free(candidates);
+            return EXIT_FAILURE;
+        }
+        GroupTable *table = storage;
+        group_table_init(table, (char *)storage + sizeof(GroupTable), groups);
+        DirtySet *dirty = dirty_storage;
+        dirty_set_init(dirty, (char *)dirty_storage + sizeof(DirtySet), groups);
+
+        // The same groups in both layouts
+        srand(seed);
+        for (int i = 0; i < groups; i++) {
+            records[i].group_id = i + 1;
+            records[i].has_spy = rand() % 5 == 0;
+            records[i].spy_time = rand() % 100 < active ? 3 * (1 + rand() % 4) : 0;
+            records[i].x = (float)(rand() % 200 - 100);
+            records[i].y = (float)(rand() % 200 - 100);
+            group_has_spy(table)[i] = records[i].has_spy;
+            group_spy_time(table)[i] = records[i].spy_time;
+            group_x(table)[i] = records[i].x;
+            group_y(table)[i] = records[i].y;
+            if (records[i].spy_time > 0) {
+                dirty_set_mark(dirty, i);
+            }
+        }
+
+        long sweeps = TARGET_GROUPS_SCORED / groups;
+        if (sweeps < 1) {
+            sweeps = 1;
+        }
+        int found[4] = { 0, 0, 0, 0 };
+        long elapsed[4];
+
+        long start = now_ns();
+        for (long r = 0; r < sweeps; r++) {
+            found[0] = score_records(records, groups, DEFAULT_THRESHOLD, DEFAULT_TIME_LIMIT, candidates);
+        }
+        elapsed[0] = now_ns() - start;
+
+        start = now_ns();
+        for (long r = 0; r < sweeps; r++) {
+            found[1] = score_columns(table, groups, min_spy_time, candidates);
+        }
+        elapsed[1] = now_ns() - start;
+
+        start = now_ns();
+        for (long r = 0; r < sweeps; r++) {
+            found[2] = group_table_candidates(table, 0, groups, min_spy_time, candidates);
+        }
+        elapsed[2] = now_ns() - start;
+
+        start = now_ns();
+        for (long r = 0; r < sweeps; r++) {
+            found[3] = score_dirty_words(table, dirty, groups, min_spy_time, candidates);
+        }
+        elapsed[3] = now_ns() - start;
+
+        if (found[0] != found[1] || found[0] != found[2] || found[0] != found[3]) {
+            fprintf(stderr, "[Bench] Candidate counts differ: records %d, columns %d, vector %d, masked %d.\n",
+                    found[0], found[1], found[2], found[3]);
+        }
+        double scored = (double)sweeps * groups;
+        printf("%10d %16.3f %16.3f %16.3f %16.3f %12d %9.1fx\n", groups, elapsed[0] / scored, elapsed[1] / scored,
+               elapsed[2] / scored, elapsed[3] / scored, found[2], (double)elapsed[0] / elapsed[2]);
+
+        free(records);
+        free(storage);
+        free(dirty_storage);
+        free(candidates);
+    }
+    return 0;
+}
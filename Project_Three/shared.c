@@ -7,18 +7,41 @@
 #include <sys/stat.h>        
 #include <sys/mman.h>
 #include <unistd.h>
+#include <time.h>
+
+// Lock levels held by the calling thread (bit per level), used to enforce the lock order
+static __thread unsigned int held_lock_levels = 0;
+
+// Function to round a size up to 16 bytes so each region of the segment stays aligned
+static size_t align16(size_t size) {
+    return (size + 15) & ~(size_t)15;
+}
+
+// Function to initialize shared data under the given name with room for the given entities
+SharedData* init_shared_data(const char *shm_name, int max_groups, int max_members, int max_agents) {
+    if (max_groups <= 0) max_groups = DEFAULT_MAX_GROUPS;
+    if (max_members <= 0) max_members = DEFAULT_MAX_RESISTANCE_MEMBERS;
+    if (max_agents <= 0) max_agents = DEFAULT_MAX_AGENCY_MEMBERS;
+    if (max_groups > SLOT_MAP_MAX_CAPACITY || max_members > SLOT_MAP_MAX_CAPACITY || max_agents > SLOT_MAP_MAX_CAPACITY) {
+        fprintf(stderr, "Entity capacities are limited to %d slots each.\n", SLOT_MAP_MAX_CAPACITY);
+        return NULL;
+    }
 
-// Function to initialize shared data
-SharedData* init_shared_data() {
-    const char *shm_name = "/simulation_shared_memory";
     int shm_fd = shm_open(shm_name, O_CREAT | O_RDWR, 0666);
     if (shm_fd == -1) {
         perror("shm_open failed");
         return NULL;
     }
 
-    // Size of shared memory
-    size_t size = sizeof(SharedData);
+    // Size of shared memory: the header followed by the storage of each slot map
+    size_t groups_size = slot_map_storage_size(max_groups, sizeof(ResistanceGroup));
+    size_t members_size = slot_map_storage_size(max_members, sizeof(ResistanceMember));
+    size_t agents_size = slot_map_storage_size(max_agents, sizeof(AgencyMember));
+    size_t table_size = group_table_storage_size(max_groups);
+    size_t dirty_size = dirty_set_storage_size(max_groups);
+    size_t snapshots_size = snapshot_storage_size(max_groups, max_agents, MAX_CAUGHT_RESISTANCE, MAX_CAUGHT_AGENCY);
+    size_t size = align16(sizeof(SharedData)) + groups_size + members_size + agents_size + table_size + dirty_size
+                + snapshots_size;
     if (ftruncate(shm_fd, size) == -1) {
         perror("ftruncate failed");
         return NULL;
@@ -30,10 +53,32 @@ SharedData* init_shared_data() {
         perror("mmap failed");
         return NULL;
     }
+    close(shm_fd);
 
     // Initialize shared data if first time
     // To keep it simple, we'll assume it's always the first time
-    memset(shared, 0, sizeof(SharedData));
+    memset(shared, 0, size);
+    snprintf(shared->shm_name, sizeof(shared->shm_name), "%s", shm_name);
+    shared->segment_size = size;
+
+    // Lay the entity maps out after the header
+    char *storage = (char *)shared + align16(sizeof(SharedData));
+    slot_map_init(&shared->groups, storage, max_groups, sizeof(ResistanceGroup));
+    storage += groups_size;
+    slot_map_init(&shared->members, storage, max_members, sizeof(ResistanceMember));
+    storage += members_size;
+    slot_map_init(&shared->agents, storage, max_agents, sizeof(AgencyMember));
+    storage += agents_size;
+    group_table_init(&shared->group_table, storage, max_groups);
+    storage += table_size;
+    dirty_set_init(&shared->dirty_groups, storage, max_groups);
+    storage += dirty_size;
+
+    // Every partition starts unclaimed and empty
+    for (int i = 0; i < ANALYSIS_PARTITIONS; i++) {
+        shared->partitions[i].owner = -1;
+    }
+    snapshot_init(&shared->snapshots, storage, max_groups, max_agents, MAX_CAUGHT_RESISTANCE, MAX_CAUGHT_AGENCY);
 
     // Initialize semaphores
     if (sem_init(&shared->semaphore, 1, 1) == -1) {
@@ -41,9 +86,13 @@ SharedData* init_shared_data() {
         return NULL;
     }
 
-    if (sem_init(&shared->group_semaphore, 1, 1) == -1) {
-        perror("sem_init group_semaphore failed");
-        return NULL;
+    // Group locks belong to the slot, so a reused slot keeps its lock
+    for (int i = 0; i < max_groups; i++) {
+        ResistanceGroup *group = slot_map_record(&shared->groups, i);
+        if (sem_init(&group->lock, 1, 1) == -1) {
+            perror("sem_init group lock failed");
+            return NULL;
+        }
     }
 
     return shared;
@@ -51,19 +100,20 @@ SharedData* init_shared_data() {
 
 // Function to destroy shared data
 int destroy_shared_data(SharedData *data) {
-    const char *shm_name = "/simulation_shared_memory";
+    char shm_name[SHM_NAME_LENGTH];
+    snprintf(shm_name, sizeof(shm_name), "%s", data->shm_name);
     if (sem_destroy(&data->semaphore) == -1) {
         perror("sem_destroy semaphore failed");
         return -1;
     }
 
-    if (sem_destroy(&data->group_semaphore) == -1) {
-        perror("sem_destroy group_semaphore failed");
-        return -1;
+    for (int i = 0; i < data->groups.capacity; i++) {
+        ResistanceGroup *group = slot_map_record(&data->groups, i);
+        sem_destroy(&group->lock);
     }
 
     // Unmap shared memory
-    if (munmap(data, sizeof(SharedData)) == -1) {
+    if (munmap(data, data->segment_size) == -1) {
         perror("munmap failed");
         return -1;
     }
@@ -77,11 +127,136 @@ int destroy_shared_data(SharedData *data) {
     return 0;
 }
 
-// Function to check if a member is suspected
+// Function to publish a snapshot of the observable state for lock-free observers (one publisher at a time)
+void publish_snapshot(SharedData *shared, long now_ms) {
+    SnapshotStore *store = &shared->snapshots;
+    Snapshot *snapshot = snapshot_begin_write(store);
+    snapshot->published_ms = now_ms;
+
+    SnapshotCounters *counters = &snapshot->counters;
+    counters->killed_resistance = counter_read(&shared->killed_resistance);
+    counters->injured_resistance = counter_read(&shared->injured_resistance);
+    counters->caught_resistance = counter_read(&shared->caught_resistance);
+    counters->killed_agency = counter_read(&shared->killed_agency);
+    counters->injured_agency = counter_read(&shared->injured_agency);
+    counters->caught_agency = counter_read(&shared->caught_agency);
+    counters->total_arrests = counter_read(&shared->total_arrests);
+    counters->total_imprisoned = counter_read(&shared->total_imprisoned);
+    counters->total_released = counter_read(&shared->total_released);
+    counters->total_resistance_groups = counter_read(&shared->total_resistance_groups);
+    counters->current_agency_members = counter_read(&shared->current_agency_members);
+    counters->live_groups = slot_map_count(&shared->groups);
+
+    // A group's position and type never change once published, so the slots are recopied only when
+    // groups appeared or dissolved since this buffer was last written. Slots are read without their lock;
+    // one reused during the copy bumps the change counter and is recopied next time.
+    int changes = slot_map_changes(&shared->groups);
+    if (snapshot->group_changes != changes) {
+        SnapshotGroup *groups = snapshot_groups(snapshot);
+        int *has_spy = group_has_spy(&shared->group_table);
+        float *x = group_x(&shared->group_table);
+        float *y = group_y(&shared->group_table);
+        int extent = slot_map_extent(&shared->groups);
+        for (int i = 0; i < extent; i++) {
+            int handle = slot_map_handle_at(&shared->groups, i);
+            if (handle >= 0) {
+                ResistanceGroup *group = slot_map_record(&shared->groups, i);
+                groups[i].kind = has_spy[i] ? SNAPSHOT_GROUP_SPY
+                               : group->is_military ? SNAPSHOT_GROUP_MILITARY : SNAPSHOT_GROUP_SOCIAL;
+                groups[i].x = x[i];
+                groups[i].y = y[i];
+                if (slot_map_handle_at(&shared->groups, i) != handle) {
+                    handle = -1;
+                }
+            }
+            groups[i].handle = handle;
+        }
+        snapshot->group_extent = extent;
+        snapshot->group_changes = changes;
+    }
+
+    // Agent and casualty positions, copied in one short pass under the position lock
+    shared_lock(shared, &shared->semaphore, LOCK_LEVEL_AGENCY);
+    float (*agents)[2] = snapshot_agents(snapshot);
+    int agent_count = 0;
+    int agent_extent = slot_map_extent(&shared->agents);
+    for (int i = 0; i < agent_extent; i++) {
+        if (slot_map_handle_at(&shared->agents, i) < 0) {
+            continue; // Free slot
+        }
+        AgencyMember *agency_member = slot_map_record(&shared->agents, i);
+        agents[agent_count][0] = agency_member->x;
+        agents[agent_count][1] = agency_member->y;
+        agent_count++;
+    }
+    snapshot->agent_count = agent_count;
+
+    int caught_resistance = shared->caught_resistance_positions_count;
+    if (caught_resistance > MAX_CAUGHT_RESISTANCE) caught_resistance = MAX_CAUGHT_RESISTANCE;
+    memcpy(snapshot_caught_resistance(snapshot), shared->caught_resistance_positions, sizeof(float[2]) * caught_resistance);
+    snapshot->caught_resistance_count = caught_resistance;
+
+    int caught_agency = shared->caught_agency_positions_count;
+    if (caught_agency > MAX_CAUGHT_AGENCY) caught_agency = MAX_CAUGHT_AGENCY;
+    memcpy(snapshot_caught_agency(snapshot), shared->caught_agency_positions, sizeof(float[2]) * caught_agency);
+    snapshot->caught_agency_count = caught_agency;
+    shared_unlock(&shared->semaphore, LOCK_LEVEL_AGENCY);
+
+    snapshot_end_write(store, snapshot);
+}
+
+// Function to check if a member is suspected (wait-free, no lock needed)
 int is_member_suspected(SharedData *shared, int member_id) {
-    for (int i = 0; i < shared->suspected_spies_count; i++) {
-        if (shared->suspected_spies[i] == member_id)
-            return 1;
+    return member_set_contains(&shared->suspected_spies, member_id);
+}
+
+// Function to resolve a group handle in O(1) and lock the group; NULL when the group is gone or the handle stale
+ResistanceGroup *lock_group(SharedData *shared, int group_slot) {
+    ResistanceGroup *group = slot_map_get(&shared->groups, group_slot);
+    if (group == NULL) {
+        return NULL;
     }
-    return 0;
+    shared_lock(shared, &group->lock, LOCK_LEVEL_GROUP);
+
+    // The group may have been dissolved between the lookup and the lock; dissolving takes the lock
+    if (slot_map_get(&shared->groups, group_slot) != group) {
+        shared_unlock(&group->lock, LOCK_LEVEL_GROUP);
+        return NULL;
+    }
+    return group;
+}
+
+// Function to unlock a group locked with lock_group
+void unlock_group(ResistanceGroup *group) {
+    shared_unlock(&group->lock, LOCK_LEVEL_GROUP);
+}
+
+// Function to acquire a lock at a level of the lock order, recording any time spent waiting
+void shared_lock(SharedData *shared, sem_t *lock, int level) {
+    unsigned int bit = 1u << level;
+    if (held_lock_levels >= bit) {
+        fprintf(stderr, "Lock order violation: acquiring level %d while holding levels 0x%x.\n",
+                level, held_lock_levels);
+        abort();
+    }
+
+    __atomic_fetch_add(&shared->lock_acquisitions, 1, __ATOMIC_RELAXED);
+    if (sem_trywait(lock) == -1) {
+        struct timespec start, end;
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        while (sem_wait(lock) == -1) {
+            // Interrupted by a signal: keep waiting
+        }
+        clock_gettime(CLOCK_MONOTONIC, &end);
+        long waited = (end.tv_sec - start.tv_sec) * 1000000000L + (end.tv_nsec - start.tv_nsec);
+        __atomic_fetch_add(&shared->lock_contended, 1, __ATOMIC_RELAXED);
+        __atomic_fetch_add(&shared->lock_wait_ns, waited, __ATOMIC_RELAXED);
+    }
+    held_lock_levels |= bit;
+}
+
+// Function to release a lock acquired with shared_lock
+void shared_unlock(sem_t *lock, int level) {
+    held_lock_levels &= ~(1u << level);
+    sem_post(lock);
 }
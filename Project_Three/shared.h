@@ -3,27 +3,86 @@
 #define SHARED_H
 
 #include <semaphore.h>
-
-#define MAX_SUSPECTS 100
-#define MAX_SPYS 100
-#define MAX_GROUPS 1000
-#define MAX_AGENCY_MEMBERS 100
+#include "member_set.h"
+#include "slot_map.h"
+#include "snapshot.h"
+#include "dirty_set.h"
+#include "group_table.h"
+
+#define DEFAULT_MAX_GROUPS 1000              // Group slots when config has no max_groups
+#define DEFAULT_MAX_RESISTANCE_MEMBERS 10000 // Member slots when config has no max_resistance_members
+#define DEFAULT_MAX_AGENCY_MEMBERS 100       // Agent slots when config has no max_agency_members
 #define MAX_CAUGHT_RESISTANCE 1000
 #define MAX_CAUGHT_AGENCY 100
-
+#define ANALYSIS_PARTITIONS 64 // Slices of the group slots that agency members claim, one per bit of a dirty-set word
+#define DEFAULT_SHM_NAME "/simulation_shared_memory"
+#define SHM_NAME_LENGTH 64
+
+// Lock order. Acquire top to bottom, never upwards, and hold at most one group lock at a time:
+//   1. ResistanceGroup.lock  - the fields of one group
+//   2. semaphore             - agent positions and casualty position arrays
+// Counters, the member sets, the slot maps and the analysis partitions are atomic and need no lock.
+// shared_lock() checks the order on every acquisition and aborts on a violation.
+#define LOCK_LEVEL_GROUP 1
+#define LOCK_LEVEL_AGENCY 2
+
+// Phases of a resistance member task between timer deadlines
+typedef enum {
+    MEMBER_BEGIN = 0,  // Start of an iteration: arrest check, then the activity period
+    MEMBER_ACTIVE,     // Activity period over: share data and face targeting
+    MEMBER_RECOVERING  // Light injury recovery period over
+} MemberPhase;
+
+// Phases of an agency member between waits
+typedef enum {
+    AGENCY_JOIN = 0,   // Not yet placed on the map
+    AGENCY_BEGIN,      // Start of an iteration: the analysis period
+    AGENCY_ACTIVE,     // Analysis period over: face targeting, then analyze and move
+    AGENCY_RECOVERING  // Light injury recovery period over
+} AgencyPhase;
+
+// Resistance group record. Spy time, spy flag and position are columns of SharedData.group_table at the
+// same slot index, so scans over them do not drag the rest of the record through the cache.
 typedef struct {
     int group_id;
-    int has_spy;
     int is_military;
-    int spy_time; // Time a spy has spent in the group (seconds)
     int current_member_count;
-    
-    // Positional data for visualization
-    float x; // X-coordinate
-    float y; // Y-coordinate
+
+    int live_members; // Member records still holding this group's handle; the group is dissolved at 0
+
+    sem_t lock; // Protects this group's fields and its group_table columns (lock level 1); initialized once per slot
 } ResistanceGroup;
 
-// Structure to hold shared counters and flags
+// Resistance member record, owned by the member's task
+typedef struct {
+    int handle; // This record's handle in SharedData.members
+    int member_id;
+    int is_spy;
+    int group_id; // Associate member with a group
+    int group_slot; // Handle of the member's group, -1 when it was not stored
+    MemberPhase phase;
+} ResistanceMember;
+
+// Agency member record, owned by the member's thread or events
+typedef struct {
+    int handle; // This record's handle in SharedData.agents
+    int agency_id;
+    AgencyPhase phase;
+    long join_ms; // Clock reading when the member joined the agency
+
+    // Positional data for visualization (guarded by semaphore)
+    float x;
+    float y;
+} AgencyMember;
+
+// A slice of the group slots analyzed by one agency member at a time
+typedef struct {
+    int owner;     // Handle of the agency member analyzing the slice, -1 when unclaimed
+    long lease_ms; // When the owner last analyzed the slice; a lapsed lease lets another member take it over
+    int groups;    // Live groups in the slice, the load members balance
+} AnalysisPartition;
+
+// Structure to hold shared counters and flags (counters are updated with counter_add)
 typedef struct {
     // Counters for resistance members
     int killed_resistance;
@@ -49,20 +108,28 @@ typedef struct {
     // Data shared from resistance groups to agency
     int data_shared;
 
-    // Lists for managing spies
-    int spy_member_ids[MAX_SPYS];
-    int spy_member_ids_count;
+    // Sets for managing spies (lock-free membership queries)
+    MemberSet spy_members;     // Active spies, value = group handle
+    MemberSet suspected_spies; // Suspects awaiting a decision, value = group handle
+
+    // Entities, stored after this header in the same segment and sized from config
+    SlotMap groups;  // ResistanceGroup records
+    SlotMap members; // ResistanceMember records
+    SlotMap agents;  // AgencyMember records
 
-    int suspected_spies[MAX_SUSPECTS];
-    int suspected_spies_count;
+    // Group columns by slot: spy_time (non-zero exactly while the slot is in dirty_groups), has_spy, x and y
+    GroupTable group_table;
 
-    // Resistance groups
-    ResistanceGroup resistance_groups[MAX_GROUPS];
-    int resistance_groups_count;
+    // Group slots whose spy_time rose since an agent last analyzed and reset them. Marked and cleared
+    // under the group's lock together with spy_time, so a marked slot always belongs to a live group.
+    DirtySet dirty_groups;
 
-    // Agency members positional data for visualization
-    float agency_positions[MAX_AGENCY_MEMBERS][2]; // [x, y]
-    int agency_positions_count;
+    // Group slots split into partitions that agency members claim, so each group is analyzed by one member
+    // (see group_partition)
+    AnalysisPartition partitions[ANALYSIS_PARTITIONS];
+
+    // Observable state published at a fixed rate; the renderer and the termination check read only this
+    SnapshotStore snapshots;
 
     // Caught resistance members' positions
     float caught_resistance_positions[MAX_CAUGHT_RESISTANCE][2];
@@ -73,17 +140,58 @@ typedef struct {
     int caught_agency_positions_count;
 
     // Semaphores for synchronization
-    sem_t semaphore; // For general shared data
-    sem_t group_semaphore; // For group-specific data
+    sem_t semaphore; // Agent and casualty positions (lock level 2)
+
+    // Lock contention statistics, updated by shared_lock
+    long lock_acquisitions;
+    long lock_contended;
+    long lock_wait_ns;
+
+    // Name of the shared memory object, so concurrent runs can each use their own
+    char shm_name[SHM_NAME_LENGTH];
+    size_t segment_size; // Header plus entity storage
 } SharedData;
 
-// Function to initialize shared data (returns a pointer to shared memory)
-SharedData* init_shared_data();
+// Function to initialize shared data under the given name with room for the given entities
+// (0 picks the default capacity; returns a pointer to shared memory)
+SharedData* init_shared_data(const char *shm_name, int max_groups, int max_members, int max_agents);
 
 // Function to destroy shared data
 int destroy_shared_data(SharedData *data);
 
-// Function to check if a member is suspected
+// Function to publish a snapshot of the observable state for lock-free observers (one publisher at a time)
+void publish_snapshot(SharedData *shared, long now_ms);
+
+// Function to check if a member is suspected (wait-free, no lock needed)
 int is_member_suspected(SharedData *shared, int member_id);
 
+// Function to resolve a group handle in O(1) and lock the group; NULL when the group is gone or the handle stale
+ResistanceGroup *lock_group(SharedData *shared, int group_slot);
+
+// Function to unlock a group locked with lock_group
+void unlock_group(ResistanceGroup *group);
+
+// Function to acquire a lock at a level of the lock order, recording any time spent waiting
+void shared_lock(SharedData *shared, sem_t *lock, int level);
+
+// Function to release a lock acquired with shared_lock
+void shared_unlock(sem_t *lock, int level);
+
+// Function to add to a shared counter atomically; returns the new value
+static inline int counter_add(int *counter, int delta) {
+    return __atomic_add_fetch(counter, delta, __ATOMIC_RELAXED);
+}
+
+// Function to read a shared counter atomically
+static inline int counter_read(int *counter) {
+    return __atomic_load_n(counter, __ATOMIC_RELAXED);
+}
+
+// Function to find the analysis partition of a group slot index. Slots are dealt out to the partitions in
+// turn, so the low slots a small run fills spread over every partition, and bit p of each dirty-set word
+// belongs to partition p.
+static inline int group_partition(int index) {
+    return index % ANALYSIS_PARTITIONS;
+}
+
 #endif
@@ -6,730 +6,1265 @@
 #include <time.h>
 #include <signal.h>
 #include <string.h>
+#include <limits.h>
 #include <sys/wait.h>
 #include <sys/types.h>
 #include "config.h"
 #include "shared.h"
 #include "visualization.h"
+#include "task_pool.h"
+#include "event_engine.h"
+#include "run_summary.h"
+#include "log.h"
+#include "trace.h"
+
+#define SPY_ACTIVITY_SECONDS 3     // Time a spy spends gathering intelligence
+#define MEMBER_ACTIVITY_SECONDS 5  // Time a regular member spends in activities
+#define CIVILIAN_SPY_SECONDS 5     // Time between civilian spying activities
+#define AGENCY_ANALYSIS_SECONDS 7  // Time an agency member takes to analyze data
+#define AGENCY_MONITOR_SECONDS 5   // Interval between agency monitor checks
+#define PARTITION_LEASE_SECONDS (2 * AGENCY_ANALYSIS_SECONDS) // An owner that missed two analyses loses its partitions
+#define TERMINATION_CHECK_SECONDS 1 // Interval between termination checks in main
+#define SNAPSHOT_INTERVAL_MS 50     // Interval between observer snapshots (20 per second)
+#define POOL_REPORT_SECONDS 10      // Interval between task pool throughput reports
 
 // Global variable to control simulation running state
 volatile int simulation_running = 1;
 
+// Global flag: actors are driven by the discrete-event engine on a simulated clock
+int virtual_time = 0;
+
+// Global run options (--seed, --summary-fd, --log-binary, --trace)
+int seed_given = 0;
+unsigned int run_seed = 0;
+int summary_fd = -1;
+const char *log_binary_path = NULL;
+const char *trace_path = NULL;
+
 // Signal handler to gracefully terminate simulation
 void handle_sigint(int sig) {
     (void)sig; // Marking 'sig' as unused to prevent compiler warnings
     simulation_running = 0;
 }
 
-// Structure to pass arguments to resistance member threads
+// Global shared segment and configuration used by member and agent records (set in main before forking)
+SharedData *sim_shared = NULL;
+Config *sim_config = NULL;
+
+// Structure to pass arguments to resistance group manager
 typedef struct {
-    int member_id;
-    int is_spy;
+    Config config;
     SharedData *shared;
-    Config *config;
-    int group_id; // Associate member with a group
-} ResistanceMemberArgs;
+    int group_id; // ID of the next group to create
+    long pool_report_ms;  // When the task pool was last reported (0 = not yet)
+    TaskPoolStats pool;   // Task pool counters at that report
+} ResManagerArgs;
 
-// Structure to pass arguments to agency member threads
+// Structure to pass arguments to agency monitor thread
 typedef struct {
-    int agency_id;
     SharedData *shared;
     Config *config;
-} AgencyMemberArgs;
+    int agency_id_counter; // ID of the next replacement member
+    int started;           // First interval already waited
+} MonitorArgs;
 
-// Structure to pass arguments to resistance group manager
+// Structure to pass arguments to the civilian actor
 typedef struct {
-    Config config;
     SharedData *shared;
-} ResManagerArgs;
+    int spying; // A spying period is in progress
+} CivilianArgs;
 
-// Structure to pass arguments to agency monitor thread
+// Structure to pass arguments to the termination check
 typedef struct {
     SharedData *shared;
     Config *config;
-} MonitorArgs;
+    long start_ms;
+    int started; // First interval already waited
+} TerminationArgs;
 
 // Function declarations
 void *resistance_group_manager(void *args);
-void *resistance_member_thread(void *args);
+int resistance_member_step(void *args);
 void *agency_member_thread(void *args);
+int agency_member_step(void *args);
 void *agency_monitor_thread(void *args);
 
-// Function to simulate civilian spying
-void *civilian_process(void *args) {
-    SharedData *shared = (SharedData *)args;
-    srand(time(NULL) ^ (getpid() << 16)); // Seed randomness
+// Function to read the clock the simulation runs on, in milliseconds
+long sim_now_ms(void) {
+    if (virtual_time) {
+        return event_now_ms();
+    }
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec * 1000L + now.tv_nsec / 1000000L;
+}
 
-    while (simulation_running) {
-        printf("[Civilian] Spying on resistance groups...\n");
-        sleep(5); // Time between spying activities
+// Function to schedule a resistance member step on the task pool, or on the event queue in virtual time
+static int schedule_member(ResistanceMember *member) {
+    if (virtual_time) {
+        return event_schedule(resistance_member_step, member, 0);
+    }
+    return task_pool_submit(resistance_member_step, member, 0);
+}
 
+// Function to create a member record in shared memory and schedule its task; returns 0 on success
+static int spawn_member(SharedData *shared, int member_id, int is_spy, int group_id, int group_slot) {
+    int index = slot_map_reserve(&shared->members);
+    if (index < 0) {
+        log_warn("[Resistance] Member capacity (%d) reached; Member %d not created.",
+                 shared->members.capacity, member_id);
+        return -1;
+    }
+
+    ResistanceMember *member = slot_map_record(&shared->members, index);
+    member->member_id = member_id;
+    member->is_spy = is_spy;
+    member->group_id = group_id; // Assign group ID
+    member->group_slot = group_slot;
+    member->phase = MEMBER_BEGIN;
+    member->handle = slot_map_publish(&shared->members, index);
+
+    if (schedule_member(member) != 0) {
+        log_error("[Resistance] Failed to schedule Resistance Member %d.", member_id);
+        slot_map_release(&shared->members, member->handle);
+        return -1;
+    }
+    return 0;
+}
+
+// Function to drop one member from its group, dissolving the group and freeing its slot when no member is left
+static void leave_group(SharedData *shared, int group_slot) {
+    ResistanceGroup *group = lock_group(shared, group_slot);
+    if (group != NULL) {
+        group->current_member_count -= 1;
+        group->live_members -= 1;
+        if (group->live_members <= 0) {
+            group_spy_time(&shared->group_table)[slot_map_index(group_slot)] = 0;
+            dirty_set_clear(&shared->dirty_groups, slot_map_index(group_slot));
+            slot_map_release(&shared->groups, group_slot);
+            counter_add(&shared->partitions[group_partition(slot_map_index(group_slot))].groups, -1);
+            log_info("[Resistance] Group %d dissolved.", group->group_id);
+        }
+        unlock_group(group);
+    }
+}
+
+// Function to drive an actor's steps on the calling thread, sleeping in real time between them
+static void run_actor(TaskStep step, void *arg) {
+    int delay_ms;
+    while ((delay_ms = step(arg)) >= 0) {
+        struct timespec wait = { delay_ms / 1000, (delay_ms % 1000) * 1000000L };
+        while (nanosleep(&wait, &wait) == -1 && simulation_running) {
+            // Interrupted by a signal: sleep the remainder
+        }
+    }
+}
+
+// Function to run one step of the civilian actor
+int civilian_step(void *args) {
+    CivilianArgs *civilian = (CivilianArgs *)args;
+    SharedData *shared = civilian->shared;
+
+    if (civilian->spying) {
         // Share data with agency
-        sem_wait(&shared->semaphore);
-        shared->data_shared += 1; // Increment shared data counter
-        sem_post(&shared->semaphore);
+        counter_add(&shared->data_shared, 1); // Increment shared data counter
+    }
+
+    if (!simulation_running) {
+        return -1;
     }
+
+    log_debug("[Civilian] Spying on resistance groups...");
+    civilian->spying = 1;
+    return CIVILIAN_SPY_SECONDS * 1000; // Time between spying activities
+}
+
+// Function to seed this process's random stream; each real-time process draws from its own stream, so
+// runs with different seeds do not share the default stream in every process that forgot to seed
+static void seed_process(unsigned int stream) {
+    srand(seed_given ? run_seed ^ (stream * 0x9E3779B9u) : (unsigned int)(time(NULL) ^ (getpid() << 16)));
+}
+
+// Function to simulate civilian spying
+void *civilian_process(void *args) {
+    CivilianArgs civilian = { (SharedData *)args, 0 };
+    seed_process(0); // Seed randomness
+
+    run_actor(civilian_step, &civilian);
     return NULL;
 }
 
-// Function to manage resistance groups
-void *resistance_group_manager(void *args) {
+// Function to create one resistance group and schedule its members
+int resistance_manager_step(void *args) {
     ResManagerArgs *res_args = (ResManagerArgs *)args;
-    if (res_args == NULL) {
-        fprintf(stderr, "[Resistance Group Manager] Invalid arguments.\n");
-        pthread_exit(NULL);
-    }
-
-    Config config = res_args->config;
+    Config *config = &res_args->config;
     SharedData *shared = res_args->shared;
+    int group_id = res_args->group_id;
+
+    if (!simulation_running) {
+        return -1;
+    }
 
-    int group_id = 1;
+    // Create a new resistance group
+    int group_size = config->group_size_min + rand() % (config->group_size_max - config->group_size_min + 1);
+    int is_military = (rand() % 100) < config->military_group_percentage ? 1 : 0;
+    log_info("[Resistance] Creating a %s group (ID: %d) with %d members.", 
+             is_military ? "Military" : "Social", group_id, group_size);
+    trace_event(TRACE_GROUP_CREATED, group_id, 0, 0, group_size, is_military);
+
+    // Determine if group has a spy
+    int has_spy = (rand() % 100) < config->spy_infiltration_probability ? 1 : 0; // Based on config
+
+    // Assign random position to the group
+    float pos_x = (float)(rand() % 200 - 100); // X between -100 to +99
+    float pos_y = (float)(rand() % 200 - 100); // Y between -100 to +99
+
+    // Initialize group data in a free slot (dissolved groups' slots are reused)
+    int group_slot = -1;
+    int index = slot_map_reserve(&shared->groups);
+    if (index >= 0) {
+        ResistanceGroup *group = slot_map_record(&shared->groups, index);
+        shared_lock(shared, &group->lock, LOCK_LEVEL_GROUP);
+        group->group_id = group_id;
+        group->is_military = is_military;
+        group->current_member_count = group_size;
+        group->live_members = group_size;
+        group_has_spy(&shared->group_table)[index] = has_spy;
+        group_spy_time(&shared->group_table)[index] = 0;
+        group_x(&shared->group_table)[index] = pos_x;
+        group_y(&shared->group_table)[index] = pos_y;
+        shared_unlock(&group->lock, LOCK_LEVEL_GROUP);
+
+        // Make the group visible to lock-free readers
+        group_slot = slot_map_publish(&shared->groups, index);
+        counter_add(&shared->partitions[group_partition(index)].groups, 1);
+    } else {
+        log_warn("[Resistance Group Manager] Group capacity (%d) reached; Group %d is not stored.",
+                 shared->groups.capacity, group_id);
+    }
 
-    while (simulation_running) {
-        // Create a new resistance group
-        int group_size = config.group_size_min + rand() % (config.group_size_max - config.group_size_min + 1);
-        int is_military = (rand() % 100) < config.military_group_percentage ? 1 : 0;
-        printf("[Resistance] Creating a %s group (ID: %d) with %d members.\n", 
-               is_military ? "Military" : "Social", group_id, group_size);
-
-        // Determine if group has a spy
-        int has_spy = (rand() % 100) < config.spy_infiltration_probability ? 1 : 0; // Based on config
-
-        // Assign random position to the group
-        float pos_x = (float)(rand() % 200 - 100); // X between -100 to +99
-        float pos_y = (float)(rand() % 200 - 100); // Y between -100 to +99
-
-        // Initialize group data
-        sem_wait(&shared->group_semaphore);
-        if (shared->resistance_groups_count < MAX_GROUPS) {
-            shared->resistance_groups[shared->resistance_groups_count].group_id = group_id;
-            shared->resistance_groups[shared->resistance_groups_count].has_spy = has_spy;
-            shared->resistance_groups[shared->resistance_groups_count].is_military = is_military;
-            shared->resistance_groups[shared->resistance_groups_count].spy_time = 0;
-            shared->resistance_groups[shared->resistance_groups_count].current_member_count = group_size;
-            shared->resistance_groups[shared->resistance_groups_count].x = pos_x;
-            shared->resistance_groups[shared->resistance_groups_count].y = pos_y;
-            shared->resistance_groups_count++;
-        } else {
-            fprintf(stderr, "[Resistance Group Manager] Maximum number of groups reached.\n");
-        }
-        sem_post(&shared->group_semaphore);
-
-        // Create threads for each resistance group member
-        pthread_t *member_threads = malloc(sizeof(pthread_t) * group_size);
-        if (member_threads == NULL) {
-            perror("[Resistance] Failed to allocate memory for member threads");
-            pthread_exit(NULL);
-        }
-
-        ResistanceMemberArgs *member_args = malloc(sizeof(ResistanceMemberArgs) * group_size);
-        if (member_args == NULL) {
-            perror("[Resistance] Failed to allocate memory for member args");
-            free(member_threads);
-            pthread_exit(NULL);
-        }
-
-        for (int i = 0; i < group_size; i++) {
-            member_args[i].member_id = group_id * 1000 + (i + 1); // Unique ID
-            member_args[i].is_spy = (has_spy && i == 0) ? 1 : 0;
-            member_args[i].shared = shared;
-            member_args[i].config = &config;
-            member_args[i].group_id = group_id; // Assign group ID
-
-            if (member_args[i].is_spy) {
-                printf("[Resistance Member %d (Spy)] Spy infiltrated Group %d.\n", 
-                       member_args[i].member_id, group_id);
-                // Add to spy_member_ids
-                sem_wait(&shared->semaphore);
-                if (shared->spy_member_ids_count < MAX_SPYS) {
-                    shared->spy_member_ids[shared->spy_member_ids_count++] = member_args[i].member_id;
-                }
-                sem_post(&shared->semaphore);
-            }
+    // Create a task for each resistance group member
+    for (int i = 0; i < group_size; i++) {
+        int member_id = group_id * 1000 + (i + 1); // Unique ID
+        int is_spy = (has_spy && i == 0) ? 1 : 0;
 
-            // Allocate memory for each member's arguments
-            ResistanceMemberArgs *arg_copy = malloc(sizeof(ResistanceMemberArgs));
-            if (arg_copy == NULL) {
-                perror("[Resistance] Failed to allocate memory for member arg copy");
-                continue; // Skip creating this member
-            }
-            memcpy(arg_copy, &member_args[i], sizeof(ResistanceMemberArgs));
+        if (spawn_member(shared, member_id, is_spy, group_id, group_slot) != 0) {
+            leave_group(shared, group_slot);
+            continue; // Skip creating this member
+        }
 
-            pthread_t member_thread;
-            if (pthread_create(&member_thread, NULL, resistance_member_thread, arg_copy) != 0) {
-                perror("[Resistance] Failed to create Resistance Member thread");
-                free(arg_copy);
-                continue; // Skip creating this member
+        if (is_spy) {
+            log_info("[Resistance Member %d (Spy)] Spy infiltrated Group %d.", 
+                     member_id, group_id);
+            trace_event(TRACE_SPY_INFILTRATED, group_id, member_id, 0, 0, 0);
+            // Add to the spy set
+            if (member_set_add(&shared->spy_members, member_id, group_slot) < 0) {
+                log_warn("[Resistance] Spy set full (%d); Spy %d is not tracked.", MEMBER_SET_CAPACITY, member_id);
             }
+        }
+    }
 
-            // Detach the thread since we won't join it
-            pthread_detach(member_thread);
+    // Increment total resistance groups
+    counter_add(&shared->total_resistance_groups, 1);
+
+    if (!virtual_time) {
+        TaskPoolStats pool_stats;
+        task_pool_stats(&pool_stats);
+        log_debug("[Resistance Group Manager] %ld member tasks running on %d worker threads.",
+                  pool_stats.live_tasks, pool_stats.workers);
+
+        // Member steps and timers the workers got through since the previous report
+        long now_ms = sim_now_ms();
+        if (res_args->pool_report_ms == 0) {
+            res_args->pool_report_ms = now_ms;
+            res_args->pool = pool_stats;
+        } else if (now_ms - res_args->pool_report_ms >= POOL_REPORT_SECONDS * 1000) {
+            double seconds = (now_ms - res_args->pool_report_ms) / 1000.0;
+            log_info("[Resistance Group Manager] Task pool: %ld member tasks on %d workers, %.0f steps/s, %.0f timers/s.",
+                     pool_stats.live_tasks, pool_stats.workers,
+                     (pool_stats.steps_run - res_args->pool.steps_run) / seconds,
+                     (pool_stats.timers_fired - res_args->pool.timers_fired) / seconds);
+            res_args->pool_report_ms = now_ms;
+            res_args->pool = pool_stats;
         }
+    }
 
-        // Increment total resistance groups
-        sem_wait(&shared->semaphore);
-        shared->total_resistance_groups += 1;
-        sem_post(&shared->semaphore);
+    // Wait group_creation_interval before creating the next group
+    res_args->group_id++;
+    return config->group_creation_interval * 1000;
+}
 
-        // Sleep for group_creation_interval before creating the next group
-        sleep(config.group_creation_interval);
+// Function to manage resistance groups
+void *resistance_group_manager(void *args) {
+    ResManagerArgs *res_args = (ResManagerArgs *)args;
+    if (res_args == NULL) {
+        log_error("[Resistance Group Manager] Invalid arguments.");
+        pthread_exit(NULL);
+    }
 
-        free(member_threads);
-        free(member_args);
+    Config *config = &res_args->config;
+    SharedData *shared = res_args->shared;
 
-        group_id++;
+    // Members are task records run by a fixed pool of workers instead of one thread each
+    if (task_pool_start(config->task_pool_workers) != 0) {
+        log_error("[Resistance Group Manager] Failed to start the member task pool.");
+        pthread_exit(NULL);
     }
 
+    run_actor(resistance_manager_step, res_args);
+
     // Monitoring loop to replace killed or caught members
     while (simulation_running) {
         sleep(2); // Check every 2 seconds
 
-        sem_wait(&shared->group_semaphore);
-        for (int i = 0; i < shared->resistance_groups_count; i++) {
-            ResistanceGroup *group = &shared->resistance_groups[i];
-            if (group->current_member_count < config.group_size_max) {
-                int members_to_add = config.group_size_max - group->current_member_count;
+        int extent = slot_map_extent(&shared->groups);
+        for (int i = 0; i < extent; i++) {
+            int group_slot = slot_map_handle_at(&shared->groups, i);
+            ResistanceGroup *group = lock_group(shared, group_slot);
+            if (group == NULL) {
+                continue; // Free or dissolved slot
+            }
+            if (group->current_member_count < config->group_size_max) {
+                int members_to_add = config->group_size_max - group->current_member_count;
                 for (int j = 0; j < members_to_add; j++) {
                     int new_member_id = group->group_id * 1000 + (group->current_member_count + 1);
-                    ResistanceMemberArgs *new_member_args = malloc(sizeof(ResistanceMemberArgs));
-                    if (new_member_args == NULL) {
-                        perror("[Resistance Group Manager] Failed to allocate memory for new member args");
-                        continue;
-                    }
-                    new_member_args->member_id = new_member_id;
-                    new_member_args->is_spy = 0; // New members are not spies
-                    new_member_args->shared = shared;
-                    new_member_args->config = &config;
-                    new_member_args->group_id = group->group_id;
-
-                    pthread_t new_member_thread;
-                    if (pthread_create(&new_member_thread, NULL, resistance_member_thread, new_member_args) != 0) {
-                        perror("[Resistance Group Manager] Failed to create new Resistance Member thread");
-                        free(new_member_args);
-                        continue;
+                    // New members are not spies
+                    if (spawn_member(shared, new_member_id, 0, group->group_id, group_slot) != 0) {
+                        break;
                     }
 
-                    pthread_detach(new_member_thread);
-
                     group->current_member_count += 1;
-                    printf("[Resistance Group Manager] Replaced missing member in Group %d with Member %d.\n",
-                           group->group_id, new_member_id);
+                    group->live_members += 1;
+                    log_info("[Resistance Group Manager] Replaced missing member in Group %d with Member %d.",
+                             group->group_id, new_member_id);
                 }
             }
+            unlock_group(group);
         }
-        sem_post(&shared->group_semaphore);
     }
 
+    task_pool_stop();
     pthread_exit(NULL);
 }
 
-// Function to simulate resistance group member behavior
-void *resistance_member_thread(void *args) {
-    ResistanceMemberArgs *member = (ResistanceMemberArgs *)args;
-    if (member == NULL) {
-        fprintf(stderr, "[Resistance Member] Invalid arguments.\n");
-        pthread_exit(NULL);
+// Function to decrement a removed member's group count and record where it was removed
+static void record_member_casualty(ResistanceMember *member) {
+    SharedData *shared = sim_shared;
+
+    ResistanceGroup *group = lock_group(shared, member->group_slot);
+    if (group != NULL) {
+        group->current_member_count -= 1;
+        // Record position
+        shared_lock(shared, &shared->semaphore, LOCK_LEVEL_AGENCY);
+        if (shared->caught_resistance_positions_count < MAX_CAUGHT_RESISTANCE) {
+            int index = slot_map_index(member->group_slot);
+            shared->caught_resistance_positions[shared->caught_resistance_positions_count][0] = group_x(&shared->group_table)[index];
+            shared->caught_resistance_positions[shared->caught_resistance_positions_count][1] = group_y(&shared->group_table)[index];
+            shared->caught_resistance_positions_count++;
+        }
+        shared_unlock(&shared->semaphore, LOCK_LEVEL_AGENCY);
+        unlock_group(group);
     }
+}
 
-    SharedData *shared = member->shared;
-    Config *config = member->config;
+// Function to retire a resistance member: leave its group and free its record
+static int resistance_member_finish(ResistanceMember *member) {
+    SharedData *shared = sim_shared;
 
-    while (simulation_running) {
-        // Check if this spy has been suspected and arrested
-        if (member->is_spy && is_member_suspected(shared, member->member_id)) {
-            printf("[Resistance Member %d (Spy)] Arrested by the agency.\n", member->member_id);
-            sem_wait(&shared->semaphore);
-            shared->caught_resistance += 1;
-            // Remove from spy_member_ids
-            for (int i = 0; i < shared->spy_member_ids_count; i++) {
-                if (shared->spy_member_ids[i] == member->member_id) {
-                    for (int j = i; j < shared->spy_member_ids_count - 1; j++) {
-                        shared->spy_member_ids[j] = shared->spy_member_ids[j + 1];
-                    }
-                    shared->spy_member_ids_count--;
-                    break;
-                }
-            }
-            // Remove from suspected_spies
-            for (int i = 0; i < shared->suspected_spies_count; i++) {
-                if (shared->suspected_spies[i] == member->member_id) {
-                    for (int j = i; j < shared->suspected_spies_count - 1; j++) {
-                        shared->suspected_spies[j] = shared->suspected_spies[j + 1];
-                    }
-                    shared->suspected_spies_count--;
-                    break;
-                }
-            }
-            sem_post(&shared->semaphore);
+    leave_group(shared, member->group_slot);
+    if (member->is_spy) {
+        member_set_remove(&shared->spy_members, member->member_id); // A spy that left is no longer active
+    }
 
-            // Decrement group's member count and record position
-            sem_wait(&shared->group_semaphore);
-            for (int i = 0; i < shared->resistance_groups_count; i++) {
-                if (shared->resistance_groups[i].group_id == member->group_id) {
-                    shared->resistance_groups[i].current_member_count -= 1;
-                    // Record position
-                    if (shared->caught_resistance_positions_count < MAX_CAUGHT_RESISTANCE) {
-                        shared->caught_resistance_positions[shared->caught_resistance_positions_count][0] = shared->resistance_groups[i].x;
-                        shared->caught_resistance_positions[shared->caught_resistance_positions_count][1] = shared->resistance_groups[i].y;
-                        shared->caught_resistance_positions_count++;
-                    }
-                    break;
-                }
-            }
-            sem_post(&shared->group_semaphore);
-            break; // Exit thread
-        }
-
-        if (member->is_spy) {
-            // Spy behavior: gathers intelligence, affects targeting
-            printf("[Resistance Member %d (Spy)] Gathering intelligence in Group %d...\n", 
-                   member->member_id, member->group_id);
-            sleep(3); // Time spent gathering intelligence
-
-            // Increment spy_time for the group
-            sem_wait(&shared->group_semaphore);
-            for (int i = 0; i < shared->resistance_groups_count; i++) {
-                if (shared->resistance_groups[i].group_id == member->group_id) {
-                    shared->resistance_groups[i].spy_time += 3; // Increment by sleep time
-                    break;
-                }
-            }
-            sem_post(&shared->group_semaphore);
+    // Free the member's slot for reuse; the task is done
+    slot_map_release(&shared->members, member->handle);
+    return -1;
+}
 
-            // The spy contributes more data_shared, affecting targeting
-            sem_wait(&shared->semaphore);
-            shared->data_shared += 2; // Spies contribute more data
-            sem_post(&shared->semaphore);
-        } else {
-            // Regular member behavior
-            printf("[Resistance Member %d] Engaging in activities in Group %d...\n", 
-                   member->member_id, member->group_id);
-            sleep(5); // Time spent in activities
-
-            // Possibly share data
-            sem_wait(&shared->semaphore);
-            shared->data_shared += 1; // Regular members contribute some data
-            sem_post(&shared->semaphore);
-        }
-
-        // Simulate possible targeting by the enemy
-        double targeting_chance = 0.05; // Base chance
-
-        // Adjust targeting chance based on group type
-        sem_wait(&shared->group_semaphore);
-        int is_military = 0;
-        int spy_time = 0;
-        for (int i = 0; i < shared->resistance_groups_count; i++) {
-            if (shared->resistance_groups[i].group_id == member->group_id) {
-                is_military = shared->resistance_groups[i].is_military;
-                spy_time = shared->resistance_groups[i].spy_time;
-                break;
-            }
-        }
-        sem_post(&shared->group_semaphore);
+// Function to start a member's loop iteration: arrest check, then the activity period
+static int resistance_member_begin(ResistanceMember *member) {
+    SharedData *shared = sim_shared;
 
-        if (is_military) {
-            targeting_chance += 0.05; // Military groups have higher base targeting
+    if (!simulation_running) {
+        return resistance_member_finish(member);
+    }
+
+    // Check if this spy has been suspected and arrested
+    if (member->is_spy && is_member_suspected(shared, member->member_id)) {
+        log_info("[Resistance Member %d (Spy)] Arrested by the agency.", member->member_id);
+        trace_event(TRACE_SPY_ARRESTED, member->group_id, member->member_id, 0, 0, 0);
+        counter_add(&shared->caught_resistance, 1);
+        // Remove from the spy and suspect sets
+        member_set_remove(&shared->spy_members, member->member_id);
+        member_set_remove(&shared->suspected_spies, member->member_id);
+
+        // Decrement group's member count and record position
+        record_member_casualty(member);
+        return resistance_member_finish(member);
+    }
+
+    member->phase = MEMBER_ACTIVE;
+    if (member->is_spy) {
+        // Spy behavior: gathers intelligence, affects targeting
+        log_debug("[Resistance Member %d (Spy)] Gathering intelligence in Group %d...", 
+                  member->member_id, member->group_id);
+        return SPY_ACTIVITY_SECONDS * 1000; // Time spent gathering intelligence
+    }
+
+    // Regular member behavior
+    log_debug("[Resistance Member %d] Engaging in activities in Group %d...", 
+              member->member_id, member->group_id);
+    return MEMBER_ACTIVITY_SECONDS * 1000; // Time spent in activities
+}
+
+// Function to finish a member's activity period: share data and face possible targeting
+static int resistance_member_act(ResistanceMember *member) {
+    SharedData *shared = sim_shared;
+    Config *config = sim_config;
+
+    if (member->is_spy) {
+        // Increment spy_time for the group
+        ResistanceGroup *group = lock_group(shared, member->group_slot);
+        if (group != NULL) {
+            group_spy_time(&shared->group_table)[slot_map_index(member->group_slot)] += SPY_ACTIVITY_SECONDS; // Increment by activity time
+            dirty_set_mark(&shared->dirty_groups, slot_map_index(member->group_slot)); // Due for analysis
+            unlock_group(group);
         }
 
-        // Increase targeting chance based on spy_time
-        targeting_chance += (spy_time * 0.01); // Each unit of spy_time increases chance by 1%
+        // The spy contributes more data_shared, affecting targeting
+        counter_add(&shared->data_shared, 2); // Spies contribute more data
+    } else {
+        // Possibly share data
+        counter_add(&shared->data_shared, 1); // Regular members contribute some data
+    }
+
+    // Simulate possible targeting by the enemy
+    double targeting_chance = 0.05; // Base chance
+
+    // Adjust targeting chance based on group type
+    int is_military = 0;
+    int spy_time = 0;
+    ResistanceGroup *group = lock_group(shared, member->group_slot);
+    if (group != NULL) {
+        is_military = group->is_military;
+        spy_time = group_spy_time(&shared->group_table)[slot_map_index(member->group_slot)];
+        unlock_group(group);
+    }
+
+    if (is_military) {
+        targeting_chance += 0.05; // Military groups have higher base targeting
+    }
+
+    // Increase targeting chance based on spy_time
+    targeting_chance += (spy_time * 0.01); // Each unit of spy_time increases chance by 1%
+
+    if (member->is_spy) {
+        // Spies have lower chance or do not sustain injuries
+        if (((double)rand() / RAND_MAX) < targeting_chance) {
+            log_debug("[Resistance Member %d (Spy)] Targeted by the enemy but no serious injury.", 
+                      member->member_id);
+            trace_event(TRACE_MEMBER_TARGETED, member->group_id, member->member_id, 0, 0, 1);
+            // Spy is not injured or killed, just observed
+        }
+    } else if (((double)rand() / RAND_MAX) < targeting_chance) {
+        log_info("[Resistance Member %d] Targeted by the enemy!", member->member_id);
+        trace_event(TRACE_MEMBER_TARGETED, member->group_id, member->member_id, 0, 0, 0);
+        // Determine outcome
+        int outcome = rand() % 3; // 0: killed, 1: injured, 2: caught
+        if (outcome == 0) {
+            log_info("[Resistance Member %d] Killed by the enemy.", member->member_id);
+            trace_event(TRACE_MEMBER_KILLED, member->group_id, member->member_id, 0, 0, 0);
+            counter_add(&shared->killed_resistance, 1);
 
-        if (member->is_spy) {
-            // Spies have lower chance or do not sustain injuries
-            if (((double)rand() / RAND_MAX) < targeting_chance) {
-                printf("[Resistance Member %d (Spy)] Targeted by the enemy but no serious injury.\n", 
-                       member->member_id);
-                // Spy is not injured or killed, just observed
+            // Decrement group's member count and record position
+            record_member_casualty(member);
+            return resistance_member_finish(member);
+        } else if (outcome == 1) {
+            // Light or severe injury
+            double injury_chance = 0.7; // 70% chance of light injury
+            if (((double)rand() / RAND_MAX) < injury_chance) {
+                log_info("[Resistance Member %d] Lightly injured by the enemy.", member->member_id);
+                trace_event(TRACE_MEMBER_INJURED, member->group_id, member->member_id, 0, 1, 0);
+                counter_add(&shared->injured_resistance, 1);
+                // Recover after light injury period
+                member->phase = MEMBER_RECOVERING;
+                return config->recovery_light * 1000;
+            } else {
+                log_info("[Resistance Member %d] Severely injured by the enemy and exiting.", 
+                         member->member_id);
+                trace_event(TRACE_MEMBER_INJURED, member->group_id, member->member_id, 0, 2, 0);
+                counter_add(&shared->injured_resistance, 1);
+
+                // Decrement group's member count and record position
+                record_member_casualty(member);
+                return resistance_member_finish(member);
             }
         } else {
-            if (((double)rand() / RAND_MAX) < targeting_chance) {
-                printf("[Resistance Member %d] Targeted by the enemy!\n", member->member_id);
-                // Determine outcome
-                int outcome = rand() % 3; // 0: killed, 1: injured, 2: caught
-                if (outcome == 0) {
-                    printf("[Resistance Member %d] Killed by the enemy.\n", member->member_id);
-                    sem_wait(&shared->semaphore);
-                    shared->killed_resistance += 1;
-                    sem_post(&shared->semaphore);
-
-                    // Decrement group's member count and record position
-                    sem_wait(&shared->group_semaphore);
-                    for (int i = 0; i < shared->resistance_groups_count; i++) {
-                        if (shared->resistance_groups[i].group_id == member->group_id) {
-                            shared->resistance_groups[i].current_member_count -= 1;
-                            // Record position
-                            if (shared->caught_resistance_positions_count < MAX_CAUGHT_RESISTANCE) {
-                                shared->caught_resistance_positions[shared->caught_resistance_positions_count][0] = shared->resistance_groups[i].x;
-                                shared->caught_resistance_positions[shared->caught_resistance_positions_count][1] = shared->resistance_groups[i].y;
-                                shared->caught_resistance_positions_count++;
-                            }
-                            break;
-                        }
-                    }
-                    sem_post(&shared->group_semaphore);
-                    break; // Exit thread
-                } else if (outcome == 1) {
-                    // Light or severe injury
-                    double injury_chance = 0.7; // 70% chance of light injury
-                    if (((double)rand() / RAND_MAX) < injury_chance) {
-                        printf("[Resistance Member %d] Lightly injured by the enemy.\n", member->member_id);
-                        sem_wait(&shared->semaphore);
-                        shared->injured_resistance += 1;
-                        sem_post(&shared->semaphore);
-                        // Recover after light injury period
-                        sleep(config->recovery_light);
-                        printf("[Resistance Member %d] Recovered from light injury and rejoining.\n", 
-                               member->member_id);
-                        sem_wait(&shared->semaphore);
-                        shared->injured_resistance -= 1;
-                        sem_post(&shared->semaphore);
-                        // Continue the loop, rejoining the group
-                    } else {
-                        printf("[Resistance Member %d] Severely injured by the enemy and exiting.\n", 
-                               member->member_id);
-                        sem_wait(&shared->semaphore);
-                        shared->injured_resistance += 1;
-                        sem_post(&shared->semaphore);
-
-                        // Decrement group's member count and record position
-                        sem_wait(&shared->group_semaphore);
-                        for (int i = 0; i < shared->resistance_groups_count; i++) {
-                            if (shared->resistance_groups[i].group_id == member->group_id) {
-                                shared->resistance_groups[i].current_member_count -= 1;
-                                // Record position
-                                if (shared->caught_resistance_positions_count < MAX_CAUGHT_RESISTANCE) {
-                                    shared->caught_resistance_positions[shared->caught_resistance_positions_count][0] = shared->resistance_groups[i].x;
-                                    shared->caught_resistance_positions_count++;
-                                }
-                                break;
-                            }
-                        }
-                        sem_post(&shared->group_semaphore);
-                        break; // Exit thread
-                    }
-                } else {
-                    printf("[Resistance Member %d] Caught by the enemy.\n", member->member_id);
-                    sem_wait(&shared->semaphore);
-                    shared->caught_resistance += 1;
-                    sem_post(&shared->semaphore);
-
-                    // Decrement group's member count and record position
-                    sem_wait(&shared->group_semaphore);
-                    for (int i = 0; i < shared->resistance_groups_count; i++) {
-                        if (shared->resistance_groups[i].group_id == member->group_id) {
-                            shared->resistance_groups[i].current_member_count -= 1;
-                            // Record position
-                            if (shared->caught_resistance_positions_count < MAX_CAUGHT_RESISTANCE) {
-                                shared->caught_resistance_positions[shared->caught_resistance_positions_count][0] = shared->resistance_groups[i].x;
-                                shared->caught_resistance_positions_count++;
-                            }
-                            break;
-                        }
-                    }
-                    sem_post(&shared->group_semaphore);
-                    break; // Exit thread
-                }
-            }
+            log_info("[Resistance Member %d] Caught by the enemy.", member->member_id);
+            trace_event(TRACE_MEMBER_CAUGHT, member->group_id, member->member_id, 0, 0, 0);
+            counter_add(&shared->caught_resistance, 1);
+
+            // Decrement group's member count and record position
+            record_member_casualty(member);
+            return resistance_member_finish(member);
         }
     }
 
-    // If member exits normally, decrement group member count
-    sem_wait(&shared->group_semaphore);
-    for (int i = 0; i < shared->resistance_groups_count; i++) {
-        if (shared->resistance_groups[i].group_id == member->group_id) {
-            shared->resistance_groups[i].current_member_count -= 1;
-            break;
+    // Not removed: start the next iteration right away
+    return resistance_member_begin(member);
+}
+
+// Function to run one step of a resistance member task; returns ms until the next step or -1 when done
+int resistance_member_step(void *args) {
+    ResistanceMember *member = (ResistanceMember *)args;
+    if (member == NULL) {
+        log_error("[Resistance Member] Invalid arguments.");
+        return -1;
+    }
+
+    switch (member->phase) {
+    case MEMBER_ACTIVE:
+        return resistance_member_act(member);
+    case MEMBER_RECOVERING:
+        log_info("[Resistance Member %d] Recovered from light injury and rejoining.", 
+                 member->member_id);
+        trace_event(TRACE_MEMBER_RECOVERED, member->group_id, member->member_id, 0, 0, 0);
+        counter_add(&sim_shared->injured_resistance, -1);
+        // Continue the loop, rejoining the group
+        return resistance_member_begin(member);
+    case MEMBER_BEGIN:
+    default:
+        return resistance_member_begin(member);
+    }
+}
+
+// Function to retire an agency member and free its record
+static int agency_member_finish(AgencyMember *agency_member) {
+    // Hand the agent's partitions back so the remaining members and replacements pick them up
+    for (int p = 0; p < ANALYSIS_PARTITIONS; p++) {
+        int owner = agency_member->handle;
+        __atomic_compare_exchange_n(&sim_shared->partitions[p].owner, &owner, -1, 0, __ATOMIC_ACQ_REL, __ATOMIC_RELAXED);
+    }
+
+    // Free the agent's slot for reuse before exiting
+    slot_map_release(&sim_shared->agents, agency_member->handle);
+    return -1;
+}
+
+// Function to record where an agency member was removed from the map
+static void record_agency_casualty(SharedData *shared, AgencyMember *agency_member) {
+    shared_lock(shared, &shared->semaphore, LOCK_LEVEL_AGENCY);
+    if (shared->caught_agency_positions_count < MAX_CAUGHT_AGENCY) {
+        shared->caught_agency_positions[shared->caught_agency_positions_count][0] = agency_member->x;
+        shared->caught_agency_positions[shared->caught_agency_positions_count][1] = agency_member->y;
+        shared->caught_agency_positions_count++;
+    }
+    shared_unlock(&shared->semaphore, LOCK_LEVEL_AGENCY);
+}
+
+// Function to take over a partition from its current owner; returns 1 if this member now owns it
+static int take_partition(AnalysisPartition *partition, int owner, int handle, long now_ms) {
+    if (!__atomic_compare_exchange_n(&partition->owner, &owner, handle, 0, __ATOMIC_ACQ_REL, __ATOMIC_RELAXED)) {
+        return 0; // Another member took it first
+    }
+    __atomic_store_n(&partition->lease_ms, now_ms, __ATOMIC_RELEASE);
+    return 1;
+}
+
+// Function to sum the live groups in the partitions an owner holds (a mask, bit p for partition p)
+static int partition_load(SharedData *shared, unsigned long long partitions) {
+    int load = 0;
+    for (int p = 0; p < ANALYSIS_PARTITIONS; p++) {
+        if (partitions >> p & 1) {
+            load += counter_read(&shared->partitions[p].groups);
         }
     }
-    sem_post(&shared->group_semaphore);
+    return load;
+}
 
-    // Free the member arguments before exiting
-    free(member);
-    pthread_exit(NULL);
+// Function to find the partitions an agency member holds, as a mask with bit p for partition p
+static unsigned long long partitions_of(SharedData *shared, int handle) {
+    unsigned long long held = 0;
+    for (int p = 0; p < ANALYSIS_PARTITIONS; p++) {
+        if (__atomic_load_n(&shared->partitions[p].owner, __ATOMIC_ACQUIRE) == handle) {
+            held |= 1ULL << p;
+        }
+    }
+    return held;
 }
 
-// Function to simulate agency member behavior
-void *agency_member_thread(void *args) {
-    AgencyMemberArgs *agency_member = (AgencyMemberArgs *)args;
-    if (agency_member == NULL) {
-        fprintf(stderr, "[Agency Member] Invalid arguments.\n");
-        pthread_exit(NULL);
+// Function to bring the live groups in an agency member's partitions up to its fair share and renew their
+// leases. Orphaned partitions (unclaimed, owner gone, or owner busy past its lease) are taken first, empty
+// ones always as they cost nothing; then partitions are stolen from the member holding the most groups while
+// that evens the load. Returns the partitions now held as a mask, bit p for partition p.
+static unsigned long long claim_partitions(SharedData *shared, AgencyMember *agency_member, long now_ms) {
+    int handle = agency_member->handle;
+    int members = slot_map_count(&shared->agents);
+    if (members < 1) {
+        members = 1;
     }
+    int share = (partition_load(shared, ~0ULL) + members - 1) / members;
 
-    int agency_id = agency_member->agency_id;
-    SharedData *shared = agency_member->shared;
-    Config *config = agency_member->config;
+    unsigned long long owned = partitions_of(shared, handle);
+    for (int p = 0; p < ANALYSIS_PARTITIONS; p++) {
+        if (owned >> p & 1) {
+            __atomic_store_n(&shared->partitions[p].lease_ms, now_ms, __ATOMIC_RELEASE);
+        }
+    }
+    int held = partition_load(shared, owned);
+
+    // Orphaned partitions: unclaimed, owner gone, or owner busy past its lease
+    for (int p = 0; p < ANALYSIS_PARTITIONS; p++) {
+        AnalysisPartition *partition = &shared->partitions[p];
+        int owner = __atomic_load_n(&partition->owner, __ATOMIC_ACQUIRE);
+        int groups = counter_read(&partition->groups);
+        if (owned >> p & 1 || (groups > 0 && held >= share)) {
+            continue;
+        }
+        if (owner >= 0 && slot_map_get(&shared->agents, owner) != NULL &&
+            now_ms - __atomic_load_n(&partition->lease_ms, __ATOMIC_ACQUIRE) < PARTITION_LEASE_SECONDS * 1000L) {
+            continue; // Held by an active member
+        }
+        if (take_partition(partition, owner, handle, now_ms)) {
+            owned |= 1ULL << p;
+            held += groups;
+        }
+    }
 
-    // Assign initial position
-    sem_wait(&shared->semaphore);
-    if (agency_id -1 < MAX_AGENCY_MEMBERS) {
-        shared->agency_positions[agency_id -1][0] = (float)(rand() % 200 - 100); // X between -100 to +99
-        shared->agency_positions[agency_id -1][1] = (float)(rand() % 200 - 100); // Y between -100 to +99
-        shared->agency_positions_count++;
+    // Work stealing: take the largest partition of the busiest member that still leaves it above this one
+    while (held < share) {
+        int victim = -1;
+        int victim_held = 0;
+        int victim_groups = 0;
+        for (int p = 0; p < ANALYSIS_PARTITIONS; p++) {
+            int owner = __atomic_load_n(&shared->partitions[p].owner, __ATOMIC_ACQUIRE);
+            int groups = counter_read(&shared->partitions[p].groups);
+            if (owned >> p & 1 || owner < 0 || groups == 0) {
+                continue;
+            }
+            int owner_held = partition_load(shared, partitions_of(shared, owner));
+            if (held + groups >= owner_held) {
+                continue; // Moving it would not even the load
+            }
+            if (owner_held > victim_held || (owner_held == victim_held && groups > victim_groups)) {
+                victim = p;
+                victim_held = owner_held;
+                victim_groups = groups;
+            }
+        }
+        if (victim < 0) {
+            break; // Balanced
+        }
+        AnalysisPartition *partition = &shared->partitions[victim];
+        if (take_partition(partition, __atomic_load_n(&partition->owner, __ATOMIC_ACQUIRE), handle, now_ms)) {
+            owned |= 1ULL << victim;
+            held += victim_groups;
+        }
     }
-    sem_post(&shared->semaphore);
+    return owned;
+}
 
-    // Tracking the start time for the agency member
-    time_t join_time = time(NULL);
+// Function to find the first dirty group slot at or after from in the partitions a member owns; -1 when none is
+// left. Bit p of every dirty-set word belongs to partition p, so the owned mask skips other members' slots.
+static int next_dirty_group(SharedData *shared, unsigned long long owned, int from) {
+    return dirty_set_next_in(&shared->dirty_groups, from, owned);
+}
 
-    while (simulation_running) {
-        // Simulate analyzing data
-        printf("[Agency Member %d] Analyzing data for potential spies...\n", agency_id);
-        sleep(7); // Time taken to analyze data
-
-        // Simulate agency member being targeted based on time in agency
-        time_t current_time = time(NULL);
-        double time_in_agency = difftime(current_time, join_time);
-        double target_chance = time_in_agency / config->agency_time_limit; // Linear increase
-
-        if (((double)rand() / RAND_MAX) < target_chance * 0.1) { // Adjusted target chance
-            // Agency member is targeted
-            printf("[Agency Member %d] Targeted by the enemy!\n", agency_id);
-            // Determine outcome
-            int outcome = rand() % 3; // 0: killed, 1: injured, 2: caught
-            if (outcome == 0) {
-                printf("[Agency Member %d] Killed by the enemy.\n", agency_id);
-                sem_wait(&shared->semaphore);
-                shared->killed_agency += 1;
-                shared->current_agency_members -= 1;
-                sem_post(&shared->semaphore);
+// Function to copy the positions of the live agency members; returns NULL (count 0) when memory runs out
+static float (*copy_agent_positions(SharedData *shared, int *count))[2] {
+    int extent = slot_map_extent(&shared->agents);
+    float (*positions)[2] = malloc(sizeof(float[2]) * (extent > 0 ? extent : 1));
+    *count = 0;
+    if (positions == NULL) {
+        perror("[Agency] Failed to allocate agent positions");
+        return NULL;
+    }
+    shared_lock(shared, &shared->semaphore, LOCK_LEVEL_AGENCY);
+    for (int i = 0; i < extent; i++) {
+        if (slot_map_handle_at(&shared->agents, i) < 0) {
+            continue; // Free slot
+        }
+        AgencyMember *agency_member = slot_map_record(&shared->agents, i);
+        positions[*count][0] = agency_member->x;
+        positions[*count][1] = agency_member->y;
+        (*count)++;
+    }
+    shared_unlock(&shared->semaphore, LOCK_LEVEL_AGENCY);
+    return positions;
+}
 
-                // Record position
-                sem_wait(&shared->semaphore);
-                if (agency_id -1 < shared->agency_positions_count && shared->caught_agency_positions_count < MAX_CAUGHT_AGENCY) {
-                    shared->caught_agency_positions[shared->caught_agency_positions_count][0] = shared->agency_positions[agency_id -1][0];
-                    shared->caught_agency_positions[shared->caught_agency_positions_count][1] = shared->agency_positions[agency_id -1][1];
-                    shared->caught_agency_positions_count++;
-                }
-                sem_post(&shared->semaphore);
-                break; // Exit thread
-            } else if (outcome == 1) {
-                // Light or severe injury
-                double injury_chance = 0.7; // 70% chance of light injury
-                if (((double)rand() / RAND_MAX) < injury_chance) {
-                    printf("[Agency Member %d] Lightly injured by the enemy.\n", agency_id);
-                    sem_wait(&shared->semaphore);
-                    shared->injured_agency += 1;
-                    sem_post(&shared->semaphore);
-                    // Recover after light injury period
-                    sleep(config->recovery_light);
-                    printf("[Agency Member %d] Recovered from light injury and resuming duties.\n", agency_id);
-                    sem_wait(&shared->semaphore);
-                    shared->injured_agency -= 1;
-                    sem_post(&shared->semaphore);
-                } else {
-                    printf("[Agency Member %d] Severely injured by the enemy and exiting.\n", agency_id);
-                    sem_wait(&shared->semaphore);
-                    shared->injured_agency += 1;
-                    shared->current_agency_members -= 1;
-                    sem_post(&shared->semaphore);
-
-                    // Record position
-                    sem_wait(&shared->semaphore);
-                    if (agency_id -1 < shared->agency_positions_count && shared->caught_agency_positions_count < MAX_CAUGHT_AGENCY) {
-                        shared->caught_agency_positions[shared->caught_agency_positions_count][0] = shared->agency_positions[agency_id -1][0];
-                        shared->caught_agency_positions[shared->caught_agency_positions_count][1] = shared->agency_positions[agency_id -1][1];
-                        shared->caught_agency_positions_count++;
-                    }
-                    sem_post(&shared->semaphore);
-                    break; // Exit thread
-                }
-            } else {
-                printf("[Agency Member %d] Caught by the enemy.\n", agency_id);
-                sem_wait(&shared->semaphore);
-                shared->killed_agency += 1; // Treat caught as killed
-                shared->current_agency_members -= 1;
-                sem_post(&shared->semaphore);
+// Function to check whether the locked group at a slot lies within the detection radius of any agency member
+// (radius <= 0 reaches everywhere)
+static int in_detection_range(SharedData *shared, int index, float (*agents)[2], int agent_count, float radius) {
+    if (radius <= 0.0f) {
+        return 1;
+    }
+    float x = group_x(&shared->group_table)[index];
+    float y = group_y(&shared->group_table)[index];
+    for (int a = 0; a < agent_count; a++) {
+        float dx = x - agents[a][0];
+        float dy = y - agents[a][1];
+        if (dx * dx + dy * dy <= radius * radius) {
+            return 1;
+        }
+    }
+    return 0;
+}
 
-                // Record position
-                sem_wait(&shared->semaphore);
-                if (agency_id -1 < shared->agency_positions_count && shared->caught_agency_positions_count < MAX_CAUGHT_AGENCY) {
-                    shared->caught_agency_positions[shared->caught_agency_positions_count][0] = shared->agency_positions[agency_id -1][0];
-                    shared->caught_agency_positions[shared->caught_agency_positions_count][1] = shared->agency_positions[agency_id -1][1];
-                    shared->caught_agency_positions_count++;
-                }
-                sem_post(&shared->semaphore);
-                break; // Exit thread
+// Function to find the smallest spy time whose suspicion (spy time / agency time limit) exceeds the threshold,
+// so scoring compares integers; never below 1, as only groups with spy activity are scored
+static int suspicion_spy_time(Config *config) {
+    double limit = config->agency_time_limit;
+    if (limit <= 0.0) {
+        return 1;
+    }
+    double estimate = config->suspicion_threshold * limit;
+    if (estimate >= INT_MAX) {
+        return INT_MAX; // No spy time can reach the threshold
+    }
+    int spy_time = estimate > 1.0 ? (int)estimate : 1;
+    while (spy_time > 1 && (double)(spy_time - 1) / limit > config->suspicion_threshold) {
+        spy_time--;
+    }
+    while (spy_time < INT_MAX && !((double)spy_time / limit > config->suspicion_threshold)) {
+        spy_time++;
+    }
+    return spy_time;
+}
+
+// Function to analyze shared data for spies, decide on suspects and move the agency member
+static void agency_member_analyze(AgencyMember *agency_member) {
+    int agency_id = agency_member->agency_id;
+    SharedData *shared = sim_shared;
+    Config *config = sim_config;
+
+    // Each member analyzes only the partitions it holds, so more members split the work instead of repeating it
+    unsigned long long owned = claim_partitions(shared, agency_member, sim_now_ms());
+
+    // Only groups near an agency member are analyzed
+    float radius = (float)config->detection_radius;
+    int agent_count = 0;
+    float (*agents)[2] = NULL;
+    if (radius > 0.0f) {
+        agents = copy_agent_positions(shared, &agent_count);
+    }
+
+    // Analyze shared data to detect spies based on per-group data. Only the dirty groups of this member's
+    // partitions within the live extent are scored, a dirty-set word at a time against the spy time and spy
+    // flag columns (dense words in one vectorized sweep); only the groups listed are locked and checked.
+    int min_spy_time = suspicion_spy_time(config);
+    int *spy_times = group_spy_time(&shared->group_table);
+    int *has_spy = group_has_spy(&shared->group_table);
+    int extent = slot_map_extent(&shared->groups);
+    int candidates[64];
+    int total_suspected = 0;
+    int dirty;
+    for (int first = 0; (dirty = next_dirty_group(shared, owned, first)) != -1 && dirty < extent; first += 64) {
+        first = dirty - dirty % 64; // The dirty-set word holding it
+        unsigned long long lanes = dirty_set_word(&shared->dirty_groups, first) & owned;
+        if (extent - first < 64) {
+            lanes &= (1ULL << (extent - first)) - 1;
+        }
+        int count = group_table_candidates_in(&shared->group_table, first, lanes, min_spy_time, candidates);
+        for (int c = 0; c < count; c++) {
+            int i = candidates[c];
+            int group_slot = slot_map_handle_at(&shared->groups, i);
+            ResistanceGroup *group = lock_group(shared, group_slot);
+            if (group == NULL) {
+                continue; // Free or dissolved slot
             }
+            // The sweep read without locks: confirm the score under the lock
+            if (!in_detection_range(shared, i, agents, agent_count, radius) ||
+                spy_times[i] < min_spy_time || !has_spy[i]) {
+                unlock_group(group);
+                continue;
+            }
+            int group_id = group->group_id;
+            unlock_group(group);
+
+            // Identify the spy in the group
+            int spy_id = group_id * 1000 + 1; // Assuming first member is spy
+            // Add to suspected_spies if not already, with the suspect's group handle
+            int added = member_set_add(&shared->suspected_spies, spy_id, group_slot);
+            if (added == 1) {
+                counter_add(&shared->total_arrests, 1);
+                log_info("[Agency Member %d] Suspected Spy ID %d added to arrests.", 
+                         agency_id, spy_id);
+                trace_event(TRACE_SUSPECT_ADDED, group_id, spy_id, agency_id, 0, 0);
+            } else if (added < 0) {
+                log_warn("[Agency Member %d] Suspect set full (%d); Spy ID %d not suspected.",
+                         agency_id, MEMBER_SET_CAPACITY, spy_id);
+                continue;
+            }
+            total_suspected++;
         }
+    }
 
-        // Analyze shared data to detect spies based on per-group data
-        sem_wait(&shared->group_semaphore);
-        int total_suspected = 0;
-        for (int i = 0; i < shared->resistance_groups_count; i++) {
-            ResistanceGroup group = shared->resistance_groups[i];
-            double group_suspicion = (double)group.spy_time / config->agency_time_limit;
-
-            if (group_suspicion > config->suspicion_threshold && group.has_spy) {
-                // Identify the spy in the group
-                int spy_id = group.group_id * 1000 + 1; // Assuming first member is spy
-                sem_wait(&shared->semaphore);
-                // Add to suspected_spies if not already
-                int already_suspected = 0;
-                for (int j = 0; j < shared->suspected_spies_count; j++) {
-                    if (shared->suspected_spies[j] == spy_id) {
-                        already_suspected = 1;
-                        break;
-                    }
-                }
-                if (!already_suspected && shared->suspected_spies_count < MAX_SUSPECTS) {
-                    shared->suspected_spies[shared->suspected_spies_count++] = spy_id;
-                    shared->total_arrests += 1;
-                    printf("[Agency Member %d] Suspected Spy ID %d added to arrests.\n", 
-                           agency_id, spy_id);
-                }
-                sem_post(&shared->semaphore);
-                total_suspected++;
+    // Decide to release or imprison the suspects whose group lies in this member's partitions, walking a copy
+    // of the members present; suspects added after the copy wait for the next analysis.
+    // A partition may change hands mid-decision; only the member whose removal succeeds counts it.
+    int suspect_count = member_set_count(&shared->suspected_spies);
+    int *suspect_ids = suspect_count > 0 ? malloc(sizeof(int) * 2 * suspect_count) : NULL;
+    int *group_slots = suspect_ids != NULL ? suspect_ids + suspect_count : NULL;
+    if (suspect_ids != NULL) {
+        suspect_count = member_set_snapshot(&shared->suspected_spies, suspect_ids, group_slots, suspect_count);
+    } else {
+        suspect_count = 0; // Nothing suspected, or no memory for the copy: decided next time
+    }
+    for (int s = 0; s < suspect_count; s++) {
+        int suspect_id = suspect_ids[s];
+        int group_slot = group_slots[s];
+        if (!(owned >> group_partition(group_slot >= 0 ? slot_map_index(group_slot) : 0) & 1)) {
+            continue; // Decided by the partition's owner
+        }
+        // Calculate updated suspicion level for the suspect's group
+        double suspicion = 0.0;
+        int group_id = 0; // Unknown once the group dissolved
+
+        ResistanceGroup *group = lock_group(shared, group_slot);
+        if (group != NULL) {
+            suspicion = (double)spy_times[slot_map_index(group_slot)] / config->agency_time_limit;
+            group_id = group->group_id;
+            unlock_group(group);
+        }
+
+        if (suspicion < config->arrest_release_threshold) {
+            // Remove suspect from suspected_spies
+            if (member_set_remove(&shared->suspected_spies, suspect_id)) {
+                log_info("[Agency Member %d] Releasing Suspect ID %d.", agency_id, suspect_id);
+                trace_event(TRACE_SUSPECT_RELEASED, group_id, suspect_id, agency_id, 0, 0);
+                counter_add(&shared->total_released, 1);
             }
+        } else if (suspicion > config->arrest_imprison_threshold) {
+            // Remove from suspected_spies and the spy set
+            if (member_set_remove(&shared->suspected_spies, suspect_id)) {
+                log_info("[Agency Member %d] Imprisoning Suspect ID %d.", agency_id, suspect_id);
+                trace_event(TRACE_SUSPECT_IMPRISONED, group_id, suspect_id, agency_id, 0, 0);
+                counter_add(&shared->total_imprisoned, 1);
+                member_set_remove(&shared->spy_members, suspect_id);
+            }
+        } else {
+            // Middle suspicion, decide based on additional logic or default action
+            log_debug("[Agency Member %d] Maintaining Suspect ID %d status.", agency_id, suspect_id);
         }
-        sem_post(&shared->group_semaphore);
-
-        // Decide to release or imprison suspected spies based on thresholds
-        sem_wait(&shared->semaphore);
-        for (int i = 0; i < shared->suspected_spies_count; ) {
-            int suspect_id = shared->suspected_spies[i];
-            // Calculate updated suspicion level for the suspect's group
-            int group_id = suspect_id / 1000;
-            double suspicion = 0.0;
-
-            sem_wait(&shared->group_semaphore);
-            for (int j = 0; j < shared->resistance_groups_count; j++) {
-                if (shared->resistance_groups[j].group_id == group_id) {
-                    suspicion = (double)shared->resistance_groups[j].spy_time / config->agency_time_limit;
-                    break;
-                }
+    }
+    free(suspect_ids);
+
+    // Reset spy_time of the analyzed groups after processing; clearing the mark under the same lock means
+    // spy activity after the reset marks the group again for the next analysis
+    for (int i = next_dirty_group(shared, owned, 0); i != -1; i = next_dirty_group(shared, owned, i + 1)) {
+        ResistanceGroup *group = lock_group(shared, slot_map_handle_at(&shared->groups, i));
+        if (group != NULL) {
+            if (in_detection_range(shared, i, agents, agent_count, radius)) {
+                spy_times[i] = 0;
+                dirty_set_clear(&shared->dirty_groups, i);
             }
-            sem_post(&shared->group_semaphore);
-
-            if (suspicion < config->arrest_release_threshold) {
-                printf("[Agency Member %d] Releasing Suspect ID %d.\n", agency_id, suspect_id);
-                shared->total_released += 1;
-                // Remove suspect from suspected_spies
-                for (int j = i; j < shared->suspected_spies_count - 1; j++) {
-                    shared->suspected_spies[j] = shared->suspected_spies[j + 1];
-                }
-                shared->suspected_spies_count--;
-                // Do not increment i, as the current index now has a new suspect
-            } else if (suspicion > config->arrest_imprison_threshold) {
-                printf("[Agency Member %d] Imprisoning Suspect ID %d.\n", agency_id, suspect_id);
-                shared->total_imprisoned += 1;
-                // Remove from suspected_spies
-                for (int j = i; j < shared->suspected_spies_count - 1; j++) {
-                    shared->suspected_spies[j] = shared->suspected_spies[j + 1];
-                }
-                shared->suspected_spies_count--;
-                // Remove from spy_member_ids
-                for (int j = 0; j < shared->spy_member_ids_count; j++) {
-                    if (shared->spy_member_ids[j] == suspect_id) {
-                        for (int k = j; k < shared->spy_member_ids_count - 1; k++) {
-                            shared->spy_member_ids[k] = shared->spy_member_ids[k + 1];
-                        }
-                        shared->spy_member_ids_count--;
-                        break;
-                    }
-                }
-                // Do not increment i, as the current index now has a new suspect
+            unlock_group(group);
+        }
+    }
+    free(agents);
+
+    // Simulate movement
+    float dx = ((float)(rand() % 21) - 10) / 10.0f; // -1.0 to +1.0
+    float dy = ((float)(rand() % 21) - 10) / 10.0f; // -1.0 to +1.0
+
+    shared_lock(shared, &shared->semaphore, LOCK_LEVEL_AGENCY);
+    agency_member->x += dx;
+    agency_member->y += dy;
+
+    // Ensure positions stay within -100 to +100
+    if (agency_member->x < -100.0f) agency_member->x = -100.0f;
+    if (agency_member->x > 100.0f) agency_member->x = 100.0f;
+    if (agency_member->y < -100.0f) agency_member->y = -100.0f;
+    if (agency_member->y > 100.0f) agency_member->y = 100.0f;
+    shared_unlock(&shared->semaphore, LOCK_LEVEL_AGENCY);
+}
+
+// Function to start an agency member's loop iteration: the analysis period
+static int agency_member_begin(AgencyMember *agency_member) {
+    if (!simulation_running) {
+        return agency_member_finish(agency_member);
+    }
+
+    // Simulate analyzing data
+    log_debug("[Agency Member %d] Analyzing data for potential spies...", agency_member->agency_id);
+    agency_member->phase = AGENCY_ACTIVE;
+    return AGENCY_ANALYSIS_SECONDS * 1000; // Time taken to analyze data
+}
+
+// Function to finish an agency member's analysis period: face targeting, then analyze and move
+static int agency_member_act(AgencyMember *agency_member) {
+    int agency_id = agency_member->agency_id;
+    SharedData *shared = sim_shared;
+    Config *config = sim_config;
+
+    // Simulate agency member being targeted based on time in agency
+    double time_in_agency = (sim_now_ms() - agency_member->join_ms) / 1000.0;
+    double target_chance = time_in_agency / config->agency_time_limit; // Linear increase
+
+    if (((double)rand() / RAND_MAX) < target_chance * 0.1) { // Adjusted target chance
+        // Agency member is targeted
+        log_info("[Agency Member %d] Targeted by the enemy!", agency_id);
+        // Determine outcome
+        int outcome = rand() % 3; // 0: killed, 1: injured, 2: caught
+        if (outcome == 0) {
+            log_info("[Agency Member %d] Killed by the enemy.", agency_id);
+            trace_event(TRACE_AGENT_KILLED, 0, 0, agency_id, 0, 0);
+            counter_add(&shared->killed_agency, 1);
+            counter_add(&shared->current_agency_members, -1);
+
+            // Record position
+            record_agency_casualty(shared, agency_member);
+            return agency_member_finish(agency_member);
+        } else if (outcome == 1) {
+            // Light or severe injury
+            double injury_chance = 0.7; // 70% chance of light injury
+            if (((double)rand() / RAND_MAX) < injury_chance) {
+                log_info("[Agency Member %d] Lightly injured by the enemy.", agency_id);
+                trace_event(TRACE_AGENT_INJURED, 0, 0, agency_id, 1, 0);
+                counter_add(&shared->injured_agency, 1);
+                // Recover after light injury period
+                agency_member->phase = AGENCY_RECOVERING;
+                return config->recovery_light * 1000;
             } else {
-                // Middle suspicion, decide based on additional logic or default action
-                printf("[Agency Member %d] Maintaining Suspect ID %d status.\n", agency_id, suspect_id);
-                i++; // Move to next suspect
+                log_info("[Agency Member %d] Severely injured by the enemy and exiting.", agency_id);
+                trace_event(TRACE_AGENT_INJURED, 0, 0, agency_id, 2, 0);
+                counter_add(&shared->injured_agency, 1);
+                counter_add(&shared->current_agency_members, -1);
+
+                // Record position
+                record_agency_casualty(shared, agency_member);
+                return agency_member_finish(agency_member);
             }
+        } else {
+            log_info("[Agency Member %d] Caught by the enemy.", agency_id);
+            trace_event(TRACE_AGENT_CAUGHT, 0, 0, agency_id, 0, 0);
+            counter_add(&shared->killed_agency, 1); // Treat caught as killed
+            counter_add(&shared->current_agency_members, -1);
+
+            // Record position
+            record_agency_casualty(shared, agency_member);
+            return agency_member_finish(agency_member);
         }
-        sem_post(&shared->semaphore);
+    }
 
-        // Reset spy_time after processing
-        sem_wait(&shared->group_semaphore);
-        for (int i = 0; i < shared->resistance_groups_count; i++) {
-            shared->resistance_groups[i].spy_time = 0;
-        }
-        sem_post(&shared->group_semaphore);
+    agency_member_analyze(agency_member);
+    return agency_member_begin(agency_member);
+}
 
-        // Simulate movement
-        float dx = ((float)(rand() % 21) - 10) / 10.0f; // -1.0 to +1.0
-        float dy = ((float)(rand() % 21) - 10) / 10.0f; // -1.0 to +1.0
+// Function to run one step of an agency member; returns ms until the next step or -1 when done
+int agency_member_step(void *args) {
+    AgencyMember *agency_member = (AgencyMember *)args;
+    if (agency_member == NULL) {
+        log_error("[Agency Member] Invalid arguments.");
+        return -1;
+    }
 
-        sem_wait(&shared->semaphore);
-        if (agency_id -1 < MAX_AGENCY_MEMBERS) {
-            shared->agency_positions[agency_id -1][0] += dx;
-            shared->agency_positions[agency_id -1][1] += dy;
+    int agency_id = agency_member->agency_id;
+    SharedData *shared = sim_shared;
+
+    switch (agency_member->phase) {
+    case AGENCY_JOIN:
+        // Assign initial position
+        shared_lock(shared, &shared->semaphore, LOCK_LEVEL_AGENCY);
+        agency_member->x = (float)(rand() % 200 - 100); // X between -100 to +99
+        agency_member->y = (float)(rand() % 200 - 100); // Y between -100 to +99
+        shared_unlock(&shared->semaphore, LOCK_LEVEL_AGENCY);
+
+        // Tracking the start time for the agency member
+        agency_member->join_ms = sim_now_ms();
+        return agency_member_begin(agency_member);
+    case AGENCY_ACTIVE:
+        return agency_member_act(agency_member);
+    case AGENCY_RECOVERING:
+        log_info("[Agency Member %d] Recovered from light injury and resuming duties.", agency_id);
+        trace_event(TRACE_AGENT_RECOVERED, 0, 0, agency_id, 0, 0);
+        counter_add(&shared->injured_agency, -1);
+        agency_member_analyze(agency_member);
+        return agency_member_begin(agency_member);
+    case AGENCY_BEGIN:
+    default:
+        return agency_member_begin(agency_member);
+    }
+}
 
-            // Ensure positions stay within -100 to +100
-            if (shared->agency_positions[agency_id -1][0] < -100.0f) shared->agency_positions[agency_id -1][0] = -100.0f;
-            if (shared->agency_positions[agency_id -1][0] > 100.0f) shared->agency_positions[agency_id -1][0] = 100.0f;
-            if (shared->agency_positions[agency_id -1][1] < -100.0f) shared->agency_positions[agency_id -1][1] = -100.0f;
-            if (shared->agency_positions[agency_id -1][1] > 100.0f) shared->agency_positions[agency_id -1][1] = 100.0f;
+// Function to simulate agency member behavior
+void *agency_member_thread(void *args) {
+    run_actor(agency_member_step, args);
+    pthread_exit(NULL);
+}
+
+// Function to create an agent record in shared memory and start the agent as a thread, or as events in virtual time
+static int spawn_agency_member(SharedData *shared, int agency_id) {
+    int index = slot_map_reserve(&shared->agents);
+    if (index < 0) {
+        log_warn("[Agency] Agent capacity (%d) reached; Agency Member %d not created.",
+                 shared->agents.capacity, agency_id);
+        return -1;
+    }
+
+    AgencyMember *agency_member = slot_map_record(&shared->agents, index);
+    agency_member->agency_id = agency_id;
+    agency_member->phase = AGENCY_JOIN;
+    agency_member->join_ms = 0;
+    agency_member->x = 0.0f;
+    agency_member->y = 0.0f;
+    agency_member->handle = slot_map_publish(&shared->agents, index);
+
+    int started;
+    if (virtual_time) {
+        started = event_schedule(agency_member_step, agency_member, 0);
+    } else {
+        pthread_t member_thread;
+        started = pthread_create(&member_thread, NULL, agency_member_thread, agency_member) == 0 ? 0 : -1;
+        if (started == 0) {
+            // Detach the thread since we won't join it
+            pthread_detach(member_thread);
         }
-        sem_post(&shared->semaphore);
     }
 
-    // Free the agency member arguments before exiting
-    free(agency_member);
-    pthread_exit(NULL);
+    if (started != 0) {
+        log_error("[Agency] Failed to start Agency Member %d.", agency_id);
+        slot_map_release(&shared->agents, agency_member->handle);
+    }
+    return started;
+}
+
+// Function to run one agency monitor check: replace a missing agency member
+int agency_monitor_step(void *args) {
+    MonitorArgs *mon_args = (MonitorArgs *)args;
+    SharedData *shared = mon_args->shared;
+    Config *config = mon_args->config;
+
+    if (!simulation_running) {
+        return -1;
+    }
+    if (!mon_args->started) {
+        mon_args->started = 1;
+        return AGENCY_MONITOR_SECONDS * 1000; // Check every 5 seconds
+    }
+
+    int current_members = counter_read(&shared->current_agency_members);
+
+    if (current_members < config->agency_members) {
+        // Spawn new agency member
+        log_info("[Agency Monitor] Agency member missing. Spawning new member %d.", mon_args->agency_id_counter);
+
+        // The replacement takes a freed agent slot; ids keep counting up
+        if (spawn_agency_member(shared, mon_args->agency_id_counter) != 0) {
+            return AGENCY_MONITOR_SECONDS * 1000; // Retry at the next check
+        }
+
+        // Update agency member count
+        counter_add(&shared->current_agency_members, 1);
+
+        mon_args->agency_id_counter++;
+    }
+    return AGENCY_MONITOR_SECONDS * 1000;
 }
 
 // Function to monitor and replace agency members
 void *agency_monitor_thread(void *args) {
     MonitorArgs *mon_args = (MonitorArgs *)args;
     if (mon_args == NULL) {
-        fprintf(stderr, "[Agency Monitor] Invalid arguments.\n");
+        log_error("[Agency Monitor] Invalid arguments.");
         pthread_exit(NULL);
     }
 
-    SharedData *shared = mon_args->shared;
-    Config *config = mon_args->config;
+    run_actor(agency_monitor_step, mon_args);
 
-    int agency_id_counter = config->agency_members + 1;
-
-    while (simulation_running) {
-        sleep(5); // Check every 5 seconds
+    // Free monitor_args before exiting
+    free(mon_args);
+    pthread_exit(NULL);
+}
 
-        sem_wait(&shared->semaphore);
-        int current_members = shared->current_agency_members;
-        sem_post(&shared->semaphore);
+// Function to create the initial agency members
+static void create_agency_members(SharedData *shared, Config *config) {
+    for (int i = 0; i < config->agency_members; i++) {
+        spawn_agency_member(shared, i + 1); // A member that fails to start is skipped
+    }
+}
 
-        if (current_members < config->agency_members) {
-            // Spawn new agency member
-            printf("[Agency Monitor] Agency member missing. Spawning new member %d.\n", agency_id_counter);
+// Function to check the termination conditions against the latest snapshot; returns 1 when the simulation should end
+static int check_termination(TerminationArgs *term) {
+    Config *config = term->config;
+    SnapshotCounters counters;
+    if (snapshot_read_counters(&term->shared->snapshots, &counters) != 0) {
+        return 0; // Nothing published yet
+    }
 
-            // Allocate memory for new member args
-            AgencyMemberArgs *new_member_args = malloc(sizeof(AgencyMemberArgs));
-            if (new_member_args == NULL) {
-                perror("[Agency Monitor] Failed to allocate memory for new agency member args");
-                continue;
-            }
-            new_member_args->agency_id = agency_id_counter;
-            new_member_args->shared = shared;
-            new_member_args->config = config;
-
-            pthread_t new_member_thread;
-            if (pthread_create(&new_member_thread, NULL, agency_member_thread, new_member_args) != 0) {
-                perror("[Agency Monitor] Failed to create new Agency Member thread");
-                free(new_member_args);
-                continue;
-            }
+    int terminate = 0;
+    int killed_resistance = counters.killed_resistance;
+    int injured_resistance = counters.injured_resistance;
+    if (killed_resistance >= config->max_killed) {
+        log_info("[Main] Maximum killed resistance members reached (%d). Terminating simulation.", killed_resistance);
+        terminate = 1;
+    }
+    if (injured_resistance >= config->max_injured) {
+        log_info("[Main] Maximum injured resistance members reached (%d). Terminating simulation.", injured_resistance);
+        terminate = 1;
+    }
 
-            // Detach the new thread as it will run independently
-            pthread_detach(new_member_thread);
+    // Check if agency time limit is reached
+    if ((sim_now_ms() - term->start_ms) / 1000.0 >= config->agency_time_limit) {
+        log_info("[Main] Agency time limit reached (%d seconds). Checking agency members' status.", config->agency_time_limit);
+        if ((counters.killed_agency + counters.caught_agency) >= config->agency_members) {
+            log_info("[Main] All agency members have been killed or caught. Terminating simulation.");
+            terminate = 1;
+        }
+    }
 
-            // Update agency member count
-            sem_wait(&shared->semaphore);
-            shared->current_agency_members += 1;
-            sem_post(&shared->semaphore);
+    if (terminate) {
+        simulation_running = 0;
+    }
+    return terminate;
+}
 
-            agency_id_counter++;
+// Function to run the termination check as a recurring event; in virtual time it is the only observer,
+// so it publishes the snapshot it checks
+int termination_step(void *args) {
+    TerminationArgs *term = (TerminationArgs *)args;
+    if (term->started) {
+        publish_snapshot(term->shared, sim_now_ms());
+        if (check_termination(term)) {
+            return -1;
         }
     }
+    term->started = 1;
+    return TERMINATION_CHECK_SECONDS * 1000;
+}
 
-    // Free monitor_args before exiting
-    free(mon_args);
-    pthread_exit(NULL);
+// Thread function to publish observer snapshots at a fixed rate until the simulation ends
+void *snapshot_publisher_thread(void *args) {
+    SharedData *shared = (SharedData *)args;
+    struct timespec interval = { 0, SNAPSHOT_INTERVAL_MS * 1000000L };
+    while (simulation_running) {
+        publish_snapshot(shared, sim_now_ms());
+        nanosleep(&interval, NULL); // An interrupting signal only shortens one interval
+    }
+    return NULL;
+}
+
+// Function to write the end state of the run to the --summary-fd descriptor
+static void write_run_summary(SharedData *shared, long start_ms) {
+    if (summary_fd < 0) {
+        return;
+    }
+
+    RunSummary summary;
+    memset(&summary, 0, sizeof(summary));
+    summary.seed = run_seed;
+    summary.killed_resistance = counter_read(&shared->killed_resistance);
+    summary.injured_resistance = counter_read(&shared->injured_resistance);
+    summary.caught_resistance = counter_read(&shared->caught_resistance);
+    summary.killed_agency = counter_read(&shared->killed_agency);
+    summary.injured_agency = counter_read(&shared->injured_agency);
+    summary.caught_agency = counter_read(&shared->caught_agency);
+    summary.total_arrests = counter_read(&shared->total_arrests);
+    summary.total_imprisoned = counter_read(&shared->total_imprisoned);
+    summary.total_released = counter_read(&shared->total_released);
+    summary.total_resistance_groups = counter_read(&shared->total_resistance_groups);
+    summary.end_seconds = (sim_now_ms() - start_ms) / 1000.0;
+
+    if (write(summary_fd, &summary, sizeof(summary)) != (ssize_t)sizeof(summary)) {
+        perror("Failed to write run summary");
+    }
+    close(summary_fd);
+}
+
+// Function to report how much time threads spent waiting for shared locks
+static void report_lock_stats(SharedData *shared) {
+    long acquisitions = __atomic_load_n(&shared->lock_acquisitions, __ATOMIC_RELAXED);
+    long contended = __atomic_load_n(&shared->lock_contended, __ATOMIC_RELAXED);
+    long wait_ns = __atomic_load_n(&shared->lock_wait_ns, __ATOMIC_RELAXED);
+    log_info("[Main] Locks: %ld acquisitions, %ld contended, %.3f ms total wait.",
+             acquisitions, contended, wait_ns / 1e6);
+}
+
+// Function to report how many messages every process logged and how many were dropped
+static void report_log_stats(void) {
+    long logged, dropped;
+    log_flush();
+    log_totals(&logged, &dropped);
+    log_info("[Main] Log: %ld messages logged, %ld dropped.", logged, dropped);
+}
+
+// Function to report how much of the event trace every process used
+static void report_trace_stats(void) {
+    if (trace_path == NULL) {
+        return;
+    }
+    long chunks, dropped;
+    trace_totals(&chunks, &dropped);
+    log_info("[Main] Trace: %s, %ld chunks of %d events, %ld events dropped.", trace_path, chunks,
+             TRACE_CHUNK_RECORDS, dropped);
+}
+
+// Function to run the whole simulation in one process on the simulated clock
+static int run_virtual_time(Config *config, SharedData *shared) {
+    if (event_engine_init() != 0) {
+        return -1;
+    }
+    seed_process(0); // One process, one stream
+
+    log_info("[Main] Running in virtual time.");
+    struct timespec wall_start, wall_end;
+    clock_gettime(CLOCK_MONOTONIC, &wall_start);
+
+    // Same actors as the real-time processes, in the same start order
+    CivilianArgs civilian = { shared, 0 };
+    ResManagerArgs res_args = { *config, shared, 1, 0, { 0 } };
+    MonitorArgs monitor = { shared, config, config->agency_members + 1, 0 };
+    TerminationArgs term = { shared, config, 0, 0 };
+
+    event_schedule(civilian_step, &civilian, 0);
+    event_schedule(resistance_manager_step, &res_args, 0);
+    create_agency_members(shared, config);
+    event_schedule(agency_monitor_step, &monitor, 0);
+    event_schedule(termination_step, &term, 0);
+
+    long events_run = event_engine_run(&simulation_running);
+
+    clock_gettime(CLOCK_MONOTONIC, &wall_end);
+    write_run_summary(shared, term.start_ms);
+    double wall_seconds = (wall_end.tv_sec - wall_start.tv_sec) + (wall_end.tv_nsec - wall_start.tv_nsec) / 1e9;
+    log_info("[Main] Virtual run ended at %.1f simulated seconds after %ld events (%.2f wall seconds).",
+             event_now_ms() / 1000.0, events_run, wall_seconds);
+
+    // Outstanding member and agent records are released with the shared segment
+    event_engine_destroy();
+    return 0;
 }
 
 // Main function
 int main(int argc, char *argv[]) {
-    if (argc < 2) {
-        printf("Usage: %s config.txt\n", argv[0]);
+    const char *config_path = NULL;
+    const char *shm_name = DEFAULT_SHM_NAME;
+    const char *overrides[argc];
+    int override_count = 0;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--virtual-time") == 0) {
+            virtual_time = 1;
+        } else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+            run_seed = (unsigned int)strtoul(argv[++i], NULL, 10);
+            seed_given = 1;
+        } else if (strcmp(argv[i], "--set") == 0 && i + 1 < argc) {
+            overrides[override_count++] = argv[++i];
+        } else if (strcmp(argv[i], "--shm-name") == 0 && i + 1 < argc) {
+            shm_name = argv[++i];
+        } else if (strcmp(argv[i], "--summary-fd") == 0 && i + 1 < argc) {
+            summary_fd = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--log-binary") == 0 && i + 1 < argc) {
+            log_binary_path = argv[++i];
+        } else if (strcmp(argv[i], "--trace") == 0 && i + 1 < argc) {
+            trace_path = argv[++i];
+        } else if (config_path == NULL) {
+            config_path = argv[i];
+        }
+    }
+    if (config_path == NULL) {
+        printf("Usage: %s config.txt [--virtual-time] [--seed N] [--set key=value]... [--shm-name NAME] [--summary-fd FD]\n"
+               "          [--log-binary FILE] [--trace FILE]\n", argv[0]);
         exit(EXIT_FAILURE);
     }
 
@@ -738,22 +1273,55 @@ int main(int argc, char *argv[]) {
 
     // Parse configuration
     Config config;
-    if (parse_config(argv[1], &config) != 0) {
+    if (parse_config(config_path, &config) != 0) {
         fprintf(stderr, "Failed to parse configuration file.\n");
         exit(EXIT_FAILURE);
     }
+    for (int i = 0; i < override_count; i++) {
+        if (apply_config_override(&config, overrides[i]) != 0) {
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    // Start logging before any other thread or process exists; children inherit the buffers' setup
+    if (log_init(config.log_level, log_binary_path) != 0) {
+        fprintf(stderr, "Failed to start logging.\n");
+        exit(EXIT_FAILURE);
+    }
+    if (virtual_time) {
+        log_set_clock(event_now_ms); // Stamp messages with simulated time
+        log_wait_when_full(1);       // The event loop outruns the writer; nothing waits on it
+    }
+    if (trace_path != NULL && trace_open(trace_path, virtual_time ? event_now_ms : NULL) != 0) {
+        exit(EXIT_FAILURE);
+    }
 
     // Initialize shared data
-    SharedData *shared = init_shared_data();
+    SharedData *shared = init_shared_data(shm_name, config.max_groups, config.max_resistance_members,
+                                          config.max_agency_members);
     if (shared == NULL) {
-        fprintf(stderr, "Failed to initialize shared data.\n");
+        log_error("Failed to initialize shared data.");
         exit(EXIT_FAILURE);
     }
+    sim_shared = shared;
+    sim_config = &config;
 
     // Initialize agency members count
-    sem_wait(&shared->semaphore);
-    shared->current_agency_members = config.agency_members;
-    sem_post(&shared->semaphore);
+    counter_add(&shared->current_agency_members, config.agency_members);
+
+    // Virtual time drives every actor from one event queue, without processes or a window
+    if (virtual_time) {
+        int status = run_virtual_time(&config, shared);
+        report_lock_stats(shared);
+        report_trace_stats();
+        report_log_stats();
+        destroy_shared_data(shared);
+        log_info("[Main] Simulation terminated.");
+        return status == 0 ? 0 : EXIT_FAILURE;
+    }
+
+    // Observers start from a snapshot of the initial state
+    publish_snapshot(shared, sim_now_ms());
 
     // Fork processes for Civilians, Resistance Groups, Agency, and Visualization
     pid_t pid_civilian, pid_resistance, pid_agency, pid_visualization;
@@ -766,6 +1334,9 @@ int main(int argc, char *argv[]) {
     }
     if (pid_civilian == 0) {
         // Child process: Civilians
+        log_after_fork();
+        trace_after_fork();
+        log_exit_on_signal(SIGTERM); // The parent ends children with SIGTERM: write their last messages first
         civilian_process(shared);
         exit(EXIT_SUCCESS);
     }
@@ -779,7 +1350,11 @@ int main(int argc, char *argv[]) {
     }
     if (pid_resistance == 0) {
         // Child process: Resistance Groups
-        ResManagerArgs res_args = { config, shared };
+        log_after_fork();
+        trace_after_fork();
+        log_exit_on_signal(SIGTERM);
+        seed_process(1);
+        ResManagerArgs res_args = { config, shared, 1, 0, { 0 } };
         resistance_group_manager(&res_args);
         exit(EXIT_SUCCESS);
     }
@@ -794,27 +1369,12 @@ int main(int argc, char *argv[]) {
     }
     if (pid_agency == 0) {
         // Child process: Counter Espionage Agency
+        log_after_fork();
+        trace_after_fork();
+        log_exit_on_signal(SIGTERM);
+        seed_process(2);
         // Create agency member threads
-        for (int i = 0; i < config.agency_members; i++) {
-            AgencyMemberArgs *member_args = malloc(sizeof(AgencyMemberArgs));
-            if (member_args == NULL) {
-                perror("[Agency] Failed to allocate memory for agency member args");
-                continue; // Skip creating this member
-            }
-            member_args->agency_id = i + 1;
-            member_args->shared = shared;
-            member_args->config = &config;
-
-            pthread_t member_thread;
-            if (pthread_create(&member_thread, NULL, agency_member_thread, member_args) != 0) {
-                perror("[Agency] Failed to create Agency Member thread");
-                free(member_args);
-                continue; // Skip creating this member
-            }
-
-            // Detach the thread since we won't join it
-            pthread_detach(member_thread);
-        }
+        create_agency_members(shared, &config);
 
         // Allocate memory for monitor thread arguments
         MonitorArgs *monitor_args = malloc(sizeof(MonitorArgs));
@@ -824,6 +1384,8 @@ int main(int argc, char *argv[]) {
         }
         monitor_args->shared = shared;
         monitor_args->config = &config;
+        monitor_args->agency_id_counter = config.agency_members + 1;
+        monitor_args->started = 0;
 
         // Create an agency monitor thread to replace agency members if needed
         pthread_t monitor_thread;
@@ -856,43 +1418,33 @@ int main(int argc, char *argv[]) {
     }
     if (pid_visualization == 0) {
         // Child process: Visualization
+        log_after_fork();
+        trace_after_fork();
+        log_exit_on_signal(SIGTERM);
         // Initialize OpenGL and start rendering
         init_opengl(argc, argv); // Pass argc and argv here
         render(shared);
         exit(EXIT_SUCCESS);
     }
 
+    // Parent process publishes snapshots for the observers (started after the last fork)
+    pthread_t publisher_thread;
+    int publisher_started = pthread_create(&publisher_thread, NULL, snapshot_publisher_thread, shared) == 0;
+    if (!publisher_started) {
+        perror("Failed to create Snapshot Publisher thread");
+        simulation_running = 0;
+    }
+
     // Parent process monitors termination conditions
-    time_t start_time = time(NULL);
+    TerminationArgs term = { shared, &config, sim_now_ms(), 1 };
     while (simulation_running) {
-        sleep(1);
+        sleep(TERMINATION_CHECK_SECONDS);
 
         // Check termination conditions
-        sem_wait(&shared->semaphore);
-        int terminate = 0;
-        if (shared->killed_resistance >= config.max_killed) {
-            printf("[Main] Maximum killed resistance members reached (%d). Terminating simulation.\n", shared->killed_resistance);
-            terminate = 1;
-        }
-        if (shared->injured_resistance >= config.max_injured) {
-            printf("[Main] Maximum injured resistance members reached (%d). Terminating simulation.\n", shared->injured_resistance);
-            terminate = 1;
-        }
-
-        // Check if agency time limit is reached
-        time_t current_time = time(NULL);
-        if (difftime(current_time, start_time) >= config.agency_time_limit) {
-            printf("[Main] Agency time limit reached (%d seconds). Checking agency members' status.\n", config.agency_time_limit);
-            if ((shared->killed_agency + shared->caught_agency) >= config.agency_members) {
-                printf("[Main] All agency members have been killed or caught. Terminating simulation.\n");
-                terminate = 1;
-            }
-        }
-
-        if (terminate) {
-            simulation_running = 0;
-        }
-        sem_post(&shared->semaphore);
+        check_termination(&term);
+    }
+    if (publisher_started) {
+        pthread_join(publisher_thread, NULL);
     }
 
     // Terminate child processes
@@ -907,9 +1459,14 @@ int main(int argc, char *argv[]) {
     waitpid(pid_agency, NULL, 0);
     waitpid(pid_visualization, NULL, 0);
 
+    write_run_summary(shared, term.start_ms);
+    report_lock_stats(shared);
+    report_trace_stats();
+    report_log_stats();
+
     // Destroy shared data
     destroy_shared_data(shared);
 
-    printf("[Main] Simulation terminated.\n");
+    log_info("[Main] Simulation terminated.");
     return 0;
 }
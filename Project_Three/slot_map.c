@@ -0,0 +1,167 @@
+// slot_map.c
+#include "slot_map.h"
+
+// Function to round a size up to 16 bytes so every array and record stays aligned
+static size_t align16(size_t size) {
+    return (size + 15) & ~(size_t)15;
+}
+
+// Function to address the generation array
+static unsigned int *generations(SlotMap *map) {
+    return (unsigned int *)((char *)map + map->generations_offset);
+}
+
+// Function to address the free-list links
+static int *next_free(SlotMap *map) {
+    return (int *)((char *)map + map->next_free_offset);
+}
+
+// Function to compute the storage a map of the given capacity needs in the shared segment
+size_t slot_map_storage_size(int capacity, int record_size) {
+    return align16(sizeof(unsigned int) * capacity)
+         + align16(sizeof(int) * capacity)
+         + align16(record_size) * capacity;
+}
+
+// Function to initialize a map over storage in the same segment as the map
+void slot_map_init(SlotMap *map, void *storage, int capacity, int record_size) {
+    if (capacity > SLOT_MAP_MAX_CAPACITY) {
+        capacity = SLOT_MAP_MAX_CAPACITY;
+    }
+    map->capacity = capacity;
+    map->record_size = (int)align16(record_size);
+    map->count = 0;
+    map->extent = 0;
+    map->changes = 0;
+    map->generations_offset = (char *)storage - (char *)map;
+    map->next_free_offset = map->generations_offset + align16(sizeof(unsigned int) * capacity);
+    map->records_offset = map->next_free_offset + align16(sizeof(int) * capacity);
+
+    // Every slot starts free at generation 0, stacked so that slot 0 is handed out first
+    unsigned int *gens = generations(map);
+    int *links = next_free(map);
+    for (int i = 0; i < capacity; i++) {
+        gens[i] = 0;
+        links[i] = i + 1 < capacity ? i + 1 : -1;
+    }
+    map->free_head = capacity > 0 ? 1 : 0;
+}
+
+// Function to take a free slot for a new record; returns its index, or -1 when the map is full
+int slot_map_reserve(SlotMap *map) {
+    int *links = next_free(map);
+    unsigned long long head = __atomic_load_n(&map->free_head, __ATOMIC_ACQUIRE);
+    int index;
+    while (1) {
+        index = (int)(head & 0xFFFFFFFFu) - 1;
+        if (index < 0) {
+            return -1;
+        }
+        // The tag changes on every push and pop, so a slot popped and pushed back meanwhile fails the exchange
+        int next = __atomic_load_n(&links[index], __ATOMIC_RELAXED);
+        unsigned long long tag = (head >> 32) + 1;
+        unsigned long long replacement = (tag << 32) | (unsigned int)(next + 1);
+        if (__atomic_compare_exchange_n(&map->free_head, &head, replacement, 0, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+            break;
+        }
+    }
+
+    int extent = __atomic_load_n(&map->extent, __ATOMIC_RELAXED);
+    while (extent <= index &&
+           !__atomic_compare_exchange_n(&map->extent, &extent, index + 1, 0, __ATOMIC_RELEASE, __ATOMIC_RELAXED)) {
+        // Another reserve raised the extent: retry against its value
+    }
+    return index;
+}
+
+// Function to make a reserved slot live once its record is initialized; returns the slot's handle
+int slot_map_publish(SlotMap *map, int index) {
+    unsigned int generation = __atomic_load_n(&generations(map)[index], __ATOMIC_RELAXED) + 1; // Now odd: live
+    __atomic_store_n(&generations(map)[index], generation, __ATOMIC_RELEASE);
+    __atomic_fetch_add(&map->count, 1, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&map->changes, 1, __ATOMIC_RELEASE);
+    return (int)((generation & SLOT_GENERATION_MASK) << SLOT_INDEX_BITS) | index;
+}
+
+// Function to release a live slot; returns 1 if released, 0 if the handle was already stale
+int slot_map_release(SlotMap *map, int handle) {
+    if (handle < 0) {
+        return 0;
+    }
+    int index = slot_map_index(handle);
+    unsigned int wanted = (unsigned int)handle >> SLOT_INDEX_BITS;
+    if (index >= map->capacity) {
+        return 0;
+    }
+
+    // Only one caller can move the slot from the handle's generation to the next one
+    unsigned int *generation = &generations(map)[index];
+    unsigned int current = __atomic_load_n(generation, __ATOMIC_ACQUIRE);
+    do {
+        if ((current & 1) == 0 || (current & SLOT_GENERATION_MASK) != wanted) {
+            return 0;
+        }
+    } while (!__atomic_compare_exchange_n(generation, &current, current + 1, 0, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE));
+    __atomic_fetch_sub(&map->count, 1, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&map->changes, 1, __ATOMIC_RELEASE);
+
+    // Push the slot back on the free stack
+    int *links = next_free(map);
+    unsigned long long head = __atomic_load_n(&map->free_head, __ATOMIC_ACQUIRE);
+    unsigned long long replacement;
+    do {
+        __atomic_store_n(&links[index], (int)(head & 0xFFFFFFFFu) - 1, __ATOMIC_RELAXED);
+        replacement = (((head >> 32) + 1) << 32) | (unsigned int)(index + 1);
+    } while (!__atomic_compare_exchange_n(&map->free_head, &head, replacement, 0, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE));
+    return 1;
+}
+
+// Function to resolve a handle; returns NULL when it is invalid or stale
+void *slot_map_get(SlotMap *map, int handle) {
+    if (handle < 0) {
+        return NULL;
+    }
+    int index = slot_map_index(handle);
+    if (index >= map->capacity) {
+        return NULL;
+    }
+    unsigned int current = __atomic_load_n(&generations(map)[index], __ATOMIC_ACQUIRE);
+    if ((current & 1) == 0 || (current & SLOT_GENERATION_MASK) != ((unsigned int)handle >> SLOT_INDEX_BITS)) {
+        return NULL;
+    }
+    return slot_map_record(map, index);
+}
+
+// Function to address the record at a slot index, live or not
+void *slot_map_record(SlotMap *map, int index) {
+    return (char *)map + map->records_offset + (long)index * map->record_size;
+}
+
+// Function to extract the slot index from a handle
+int slot_map_index(int handle) {
+    return handle & (SLOT_MAP_MAX_CAPACITY - 1);
+}
+
+// Function to read the handle of the live slot at an index, or -1 when the slot is free
+int slot_map_handle_at(SlotMap *map, int index) {
+    unsigned int current = __atomic_load_n(&generations(map)[index], __ATOMIC_ACQUIRE);
+    if ((current & 1) == 0) {
+        return -1;
+    }
+    return (int)((current & SLOT_GENERATION_MASK) << SLOT_INDEX_BITS) | index;
+}
+
+// Function to read the number of live slots
+int slot_map_count(SlotMap *map) {
+    return __atomic_load_n(&map->count, __ATOMIC_RELAXED);
+}
+
+// Function to read the number of slots ever reserved (live slots all lie below it)
+int slot_map_extent(SlotMap *map) {
+    return __atomic_load_n(&map->extent, __ATOMIC_ACQUIRE);
+}
+
+// Function to read the change counter; readers that cache per-slot data rescan only when it moved
+int slot_map_changes(SlotMap *map) {
+    return __atomic_load_n(&map->changes, __ATOMIC_ACQUIRE);
+}
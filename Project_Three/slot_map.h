@@ -0,0 +1,64 @@
+// slot_map.h
+#ifndef SLOT_MAP_H
+#define SLOT_MAP_H
+
+#include <stddef.h>
+
+#define SLOT_INDEX_BITS 18                          // Low bits of a handle: the slot index
+#define SLOT_MAP_MAX_CAPACITY (1 << SLOT_INDEX_BITS) // Largest capacity a handle can address
+#define SLOT_GENERATION_MASK 0x1FFF                 // High bits of a handle: the slot's generation (13 bits)
+
+// Generational slot map of fixed-size records living in shared memory.
+// A handle is (generation << SLOT_INDEX_BITS) | index. A slot's generation is odd while the slot is live and
+// is bumped on every publish and release, so a handle to a released or reused slot no longer resolves.
+// Free slots form a lock-free stack, so released slots are reused first and the footprint never grows.
+// The arrays live in the same segment as the map and are addressed by offset, so every process can use them.
+typedef struct {
+    int capacity;
+    int record_size;
+    int count;                    // Live slots
+    int extent;                   // Slots ever reserved; iteration can stop here
+    int changes;                  // Bumped on every publish and release
+    unsigned long long free_head; // (tag << 32) | (index + 1) of the top free slot, 0 when none is free
+    long generations_offset;      // Offsets of the arrays from this map
+    long next_free_offset;
+    long records_offset;
+} SlotMap;
+
+// Function to compute the storage a map of the given capacity needs in the shared segment
+size_t slot_map_storage_size(int capacity, int record_size);
+
+// Function to initialize a map over storage in the same segment as the map
+void slot_map_init(SlotMap *map, void *storage, int capacity, int record_size);
+
+// Function to take a free slot for a new record; returns its index, or -1 when the map is full
+int slot_map_reserve(SlotMap *map);
+
+// Function to make a reserved slot live once its record is initialized; returns the slot's handle
+int slot_map_publish(SlotMap *map, int index);
+
+// Function to release a live slot; returns 1 if released, 0 if the handle was already stale
+int slot_map_release(SlotMap *map, int handle);
+
+// Function to resolve a handle; returns NULL when it is invalid or stale
+void *slot_map_get(SlotMap *map, int handle);
+
+// Function to address the record at a slot index, live or not
+void *slot_map_record(SlotMap *map, int index);
+
+// Function to extract the slot index from a handle
+int slot_map_index(int handle);
+
+// Function to read the handle of the live slot at an index, or -1 when the slot is free
+int slot_map_handle_at(SlotMap *map, int index);
+
+// Function to read the number of live slots
+int slot_map_count(SlotMap *map);
+
+// Function to read the number of slots ever reserved (live slots all lie below it)
+int slot_map_extent(SlotMap *map);
+
+// Function to read the change counter; readers that cache per-slot data rescan only when it moved
+int slot_map_changes(SlotMap *map);
+
+#endif
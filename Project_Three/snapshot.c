@@ -0,0 +1,120 @@
+// snapshot.c
+#include "snapshot.h"
+#include <string.h>
+
+// Function to round a size up to 16 bytes so every buffer and array stays aligned
+static size_t align16(size_t size) {
+    return (size + 15) & ~(size_t)15;
+}
+
+// Function to compute the size of one buffer: the header followed by its arrays
+static size_t buffer_size(int groups, int agents, int caught_resistance, int caught_agency) {
+    return align16(sizeof(Snapshot))
+         + align16(sizeof(SnapshotGroup) * groups)
+         + align16(sizeof(float[2]) * agents)
+         + align16(sizeof(float[2]) * caught_resistance)
+         + align16(sizeof(float[2]) * caught_agency);
+}
+
+// Function to address a buffer of the store
+static Snapshot *buffer_at(SnapshotStore *store, int index) {
+    return (Snapshot *)((char *)store + store->buffers_offset + (long)index * store->buffer_size);
+}
+
+// Function to compute the storage a store with the given capacities needs in the shared segment
+size_t snapshot_storage_size(int groups, int agents, int caught_resistance, int caught_agency) {
+    return buffer_size(groups, agents, caught_resistance, caught_agency) * SNAPSHOT_BUFFERS;
+}
+
+// Function to initialize a store over storage in the same segment as the store
+void snapshot_init(SnapshotStore *store, void *storage, int groups, int agents, int caught_resistance, int caught_agency) {
+    store->latest = -1;
+    store->group_capacity = groups;
+    store->agent_capacity = agents;
+    store->caught_resistance_capacity = caught_resistance;
+    store->caught_agency_capacity = caught_agency;
+    store->buffers_offset = (char *)storage - (char *)store;
+    store->buffer_size = (long)buffer_size(groups, agents, caught_resistance, caught_agency);
+
+    for (int i = 0; i < SNAPSHOT_BUFFERS; i++) {
+        Snapshot *snapshot = buffer_at(store, i);
+        memset(snapshot, 0, sizeof(Snapshot));
+        snapshot->group_changes = -1; // No group slot copied yet
+        snapshot->groups_offset = align16(sizeof(Snapshot));
+        snapshot->agents_offset = snapshot->groups_offset + align16(sizeof(SnapshotGroup) * groups);
+        snapshot->caught_resistance_offset = snapshot->agents_offset + align16(sizeof(float[2]) * agents);
+        snapshot->caught_agency_offset = snapshot->caught_resistance_offset + align16(sizeof(float[2]) * caught_resistance);
+    }
+}
+
+// Function to start writing the next snapshot (single publisher); returns the buffer to fill
+Snapshot *snapshot_begin_write(SnapshotStore *store) {
+    int latest = __atomic_load_n(&store->latest, __ATOMIC_RELAXED);
+    Snapshot *snapshot = buffer_at(store, (latest + 1) % SNAPSHOT_BUFFERS);
+
+    // Odd sequence: readers that started on this buffer will see it moved and retry
+    __atomic_store_n(&snapshot->sequence, snapshot->sequence + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    return snapshot;
+}
+
+// Function to finish a snapshot started with snapshot_begin_write and make it the newest
+void snapshot_end_write(SnapshotStore *store, Snapshot *snapshot) {
+    __atomic_store_n(&snapshot->sequence, snapshot->sequence + 1, __ATOMIC_RELEASE);
+    int index = (int)(((char *)snapshot - ((char *)store + store->buffers_offset)) / store->buffer_size);
+    __atomic_store_n(&store->latest, index, __ATOMIC_RELEASE);
+}
+
+// Function to start reading the newest snapshot; returns NULL before the first publication
+const Snapshot *snapshot_acquire(SnapshotStore *store, unsigned int *sequence) {
+    while (1) {
+        int latest = __atomic_load_n(&store->latest, __ATOMIC_ACQUIRE);
+        if (latest < 0) {
+            return NULL;
+        }
+        Snapshot *snapshot = buffer_at(store, latest);
+        *sequence = __atomic_load_n(&snapshot->sequence, __ATOMIC_ACQUIRE);
+        if ((*sequence & 1) == 0) {
+            return snapshot;
+        }
+        // The publisher lapped this reader and is rewriting the buffer: take the newer one
+    }
+}
+
+// Function to check that nothing read from a snapshot since snapshot_acquire was overwritten
+int snapshot_validate(const Snapshot *snapshot, unsigned int sequence) {
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    return __atomic_load_n(&snapshot->sequence, __ATOMIC_RELAXED) == sequence;
+}
+
+// Function to copy the newest counters; returns 0 on success, -1 before the first publication
+int snapshot_read_counters(SnapshotStore *store, SnapshotCounters *counters) {
+    while (1) {
+        unsigned int sequence;
+        const Snapshot *snapshot = snapshot_acquire(store, &sequence);
+        if (snapshot == NULL) {
+            return -1;
+        }
+        memcpy(counters, &snapshot->counters, sizeof(*counters));
+        if (snapshot_validate(snapshot, sequence)) {
+            return 0;
+        }
+    }
+}
+
+// Functions to address a snapshot's arrays
+SnapshotGroup *snapshot_groups(const Snapshot *snapshot) {
+    return (SnapshotGroup *)((char *)snapshot + snapshot->groups_offset);
+}
+
+float (*snapshot_agents(const Snapshot *snapshot))[2] {
+    return (float (*)[2])((char *)snapshot + snapshot->agents_offset);
+}
+
+float (*snapshot_caught_resistance(const Snapshot *snapshot))[2] {
+    return (float (*)[2])((char *)snapshot + snapshot->caught_resistance_offset);
+}
+
+float (*snapshot_caught_agency(const Snapshot *snapshot))[2] {
+    return (float (*)[2])((char *)snapshot + snapshot->caught_agency_offset);
+}
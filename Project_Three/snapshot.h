@@ -0,0 +1,97 @@
+// snapshot.h
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include <stddef.h>
+
+#define SNAPSHOT_BUFFERS 3 // The newest snapshot, the one readers may still hold, and the one being written
+
+// Kind of a group as drawn
+typedef enum {
+    SNAPSHOT_GROUP_SOCIAL = 0,
+    SNAPSHOT_GROUP_MILITARY,
+    SNAPSHOT_GROUP_SPY
+} SnapshotGroupKind;
+
+// Group slot as seen at publication time
+typedef struct {
+    int handle; // Handle of the group in the slot, -1 when the slot was free
+    int kind;   // SnapshotGroupKind
+    float x;
+    float y;
+} SnapshotGroup;
+
+// Counters observers watch (the scoreboard and the termination check)
+typedef struct {
+    int killed_resistance;
+    int injured_resistance;
+    int caught_resistance;
+    int killed_agency;
+    int injured_agency;
+    int caught_agency;
+    int total_arrests;
+    int total_imprisoned;
+    int total_released;
+    int total_resistance_groups;
+    int current_agency_members;
+    int live_groups;
+} SnapshotCounters;
+
+// One published copy of the observable state. The sequence is odd while the publisher rewrites the buffer.
+typedef struct {
+    unsigned int sequence;
+    long published_ms;
+    SnapshotCounters counters;
+    int group_extent;  // Group slots copied
+    int group_changes; // Group map change counter the group slots were copied at
+    int agent_count;
+    int caught_resistance_count;
+    int caught_agency_count;
+    long groups_offset; // Offsets of the arrays from this snapshot
+    long agents_offset;
+    long caught_resistance_offset;
+    long caught_agency_offset;
+} Snapshot;
+
+// Triple buffer of snapshots in shared memory with one publisher and any number of readers.
+// The publisher always rewrites the buffer after the newest one, so a reader holding the newest
+// buffer is only disturbed if two more snapshots are published while it reads. Readers never lock:
+// they note the sequence, read, and check the sequence is unchanged (a seqlock per buffer).
+typedef struct {
+    int latest; // Index of the newest complete snapshot, -1 before the first
+    int group_capacity;
+    int agent_capacity;
+    int caught_resistance_capacity;
+    int caught_agency_capacity;
+    long buffers_offset; // Offset of the first buffer from this store
+    long buffer_size;
+} SnapshotStore;
+
+// Function to compute the storage a store with the given capacities needs in the shared segment
+size_t snapshot_storage_size(int groups, int agents, int caught_resistance, int caught_agency);
+
+// Function to initialize a store over storage in the same segment as the store
+void snapshot_init(SnapshotStore *store, void *storage, int groups, int agents, int caught_resistance, int caught_agency);
+
+// Function to start writing the next snapshot (single publisher); returns the buffer to fill
+Snapshot *snapshot_begin_write(SnapshotStore *store);
+
+// Function to finish a snapshot started with snapshot_begin_write and make it the newest
+void snapshot_end_write(SnapshotStore *store, Snapshot *snapshot);
+
+// Function to start reading the newest snapshot; returns NULL before the first publication
+const Snapshot *snapshot_acquire(SnapshotStore *store, unsigned int *sequence);
+
+// Function to check that nothing read from a snapshot since snapshot_acquire was overwritten
+int snapshot_validate(const Snapshot *snapshot, unsigned int sequence);
+
+// Function to copy the newest counters; returns 0 on success, -1 before the first publication
+int snapshot_read_counters(SnapshotStore *store, SnapshotCounters *counters);
+
+// Functions to address a snapshot's arrays
+SnapshotGroup *snapshot_groups(const Snapshot *snapshot);
+float (*snapshot_agents(const Snapshot *snapshot))[2];
+float (*snapshot_caught_resistance(const Snapshot *snapshot))[2];
+float (*snapshot_caught_agency(const Snapshot *snapshot))[2];
+
+#endif
@@ -0,0 +1,247 @@
+// task_pool.c
+#include "task_pool.h"
+#include "log.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <time.h>
+#include <unistd.h>
+
+// Global pool state (one pool per process)
+static pthread_t *worker_threads = NULL;
+static int worker_count = 0;
+static pthread_t timer_thread;
+static volatile int pool_running = 0;
+
+// Ready queue shared by the workers
+static Task *ready_head = NULL;
+static Task *ready_tail = NULL;
+static pthread_mutex_t ready_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t ready_cond = PTHREAD_COND_INITIALIZER;
+
+// Timer wheel: tasks waiting for a deadline, hashed by expiry tick
+static Task *wheel[TIMER_WHEEL_SLOTS];
+static long current_tick = 0;
+static pthread_mutex_t wheel_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+// Counters
+static long live_tasks = 0;
+static long steps_run = 0;
+static long timers_fired = 0;
+
+// Function to append a list of tasks to the ready queue
+static void push_ready(Task *first, Task *last, long count) {
+    pthread_mutex_lock(&ready_mutex);
+    if (ready_tail == NULL) {
+        ready_head = first;
+    } else {
+        ready_tail->next = first;
+    }
+    ready_tail = last;
+    if (count == 1) {
+        pthread_cond_signal(&ready_cond);
+    } else {
+        pthread_cond_broadcast(&ready_cond);
+    }
+    pthread_mutex_unlock(&ready_mutex);
+}
+
+// Function to put a task on the wheel, or straight on the ready queue when it is already due
+static void schedule_task(Task *task, int delay_ms) {
+    task->next = NULL;
+    if (delay_ms <= 0) {
+        push_ready(task, task, 1);
+        return;
+    }
+
+    long ticks = (delay_ms + TIMER_TICK_MS - 1) / TIMER_TICK_MS;
+    pthread_mutex_lock(&wheel_mutex);
+    task->expiry_tick = current_tick + ticks;
+    int slot = task->expiry_tick % TIMER_WHEEL_SLOTS;
+    task->next = wheel[slot];
+    wheel[slot] = task;
+    pthread_mutex_unlock(&wheel_mutex);
+}
+
+// Function to advance the wheel one tick per TIMER_TICK_MS and release due tasks
+static void *timer_thread_main(void *args) {
+    (void)args;
+    struct timespec next;
+    clock_gettime(CLOCK_MONOTONIC, &next);
+
+    while (pool_running) {
+        next.tv_nsec += TIMER_TICK_MS * 1000000L;
+        while (next.tv_nsec >= 1000000000L) {
+            next.tv_nsec -= 1000000000L;
+            next.tv_sec += 1;
+        }
+        clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next, NULL);
+
+        // Collect every task in this slot whose deadline has come; later revolutions stay put
+        Task *first = NULL;
+        Task *last = NULL;
+        long count = 0;
+        pthread_mutex_lock(&wheel_mutex);
+        current_tick++;
+        Task **link = &wheel[current_tick % TIMER_WHEEL_SLOTS];
+        while (*link != NULL) {
+            Task *task = *link;
+            if (task->expiry_tick <= current_tick) {
+                *link = task->next;
+                task->next = NULL;
+                if (last == NULL) {
+                    first = task;
+                } else {
+                    last->next = task;
+                }
+                last = task;
+                count++;
+            } else {
+                link = &task->next;
+            }
+        }
+        timers_fired += count;
+        pthread_mutex_unlock(&wheel_mutex);
+
+        if (count > 0) {
+            push_ready(first, last, count);
+        }
+    }
+    return NULL;
+}
+
+// Function run by each worker: take a ready task, run one step, re-arm or retire it
+static void *worker_thread_main(void *args) {
+    (void)args;
+    while (1) {
+        pthread_mutex_lock(&ready_mutex);
+        while (ready_head == NULL && pool_running) {
+            pthread_cond_wait(&ready_cond, &ready_mutex);
+        }
+        if (!pool_running) {
+            pthread_mutex_unlock(&ready_mutex);
+            break;
+        }
+        Task *task = ready_head;
+        ready_head = task->next;
+        if (ready_head == NULL) {
+            ready_tail = NULL;
+        }
+        pthread_mutex_unlock(&ready_mutex);
+
+        int delay_ms = task->step(task->arg);
+        __sync_fetch_and_add(&steps_run, 1);
+
+        if (delay_ms < 0) {
+            __sync_fetch_and_sub(&live_tasks, 1);
+            free(task);
+        } else {
+            schedule_task(task, delay_ms);
+        }
+    }
+    return NULL;
+}
+
+// Function to start the worker pool and timer wheel (workers <= 0 means one per core)
+int task_pool_start(int workers) {
+    if (workers <= 0) {
+        long cores = sysconf(_SC_NPROCESSORS_ONLN);
+        workers = cores > 0 ? (int)cores : 1;
+    }
+
+    worker_threads = malloc(sizeof(pthread_t) * workers);
+    if (worker_threads == NULL) {
+        perror("[Task Pool] Failed to allocate worker threads");
+        return -1;
+    }
+
+    memset(wheel, 0, sizeof(wheel));
+    current_tick = 0;
+    pool_running = 1;
+
+    if (pthread_create(&timer_thread, NULL, timer_thread_main, NULL) != 0) {
+        perror("[Task Pool] Failed to create timer thread");
+        pool_running = 0;
+        free(worker_threads);
+        worker_threads = NULL;
+        return -1;
+    }
+
+    for (worker_count = 0; worker_count < workers; worker_count++) {
+        if (pthread_create(&worker_threads[worker_count], NULL, worker_thread_main, NULL) != 0) {
+            perror("[Task Pool] Failed to create worker thread");
+            break;
+        }
+    }
+    if (worker_count == 0) {
+        task_pool_stop();
+        return -1;
+    }
+
+    log_info("[Task Pool] Started %d worker threads with a %d ms timer wheel.", worker_count, TIMER_TICK_MS);
+    return 0;
+}
+
+// Function to submit a task whose first step runs after delay_ms
+int task_pool_submit(TaskStep step, void *arg, int delay_ms) {
+    Task *task = malloc(sizeof(Task));
+    if (task == NULL) {
+        perror("[Task Pool] Failed to allocate task");
+        return -1;
+    }
+    task->step = step;
+    task->arg = arg;
+    task->expiry_tick = 0;
+    task->next = NULL;
+
+    __sync_fetch_and_add(&live_tasks, 1);
+    schedule_task(task, delay_ms);
+    return 0;
+}
+
+// Function to read the pool counters
+void task_pool_stats(TaskPoolStats *stats) {
+    stats->workers = worker_count;
+    stats->live_tasks = __sync_fetch_and_add(&live_tasks, 0);
+    stats->steps_run = __sync_fetch_and_add(&steps_run, 0);
+    pthread_mutex_lock(&wheel_mutex);
+    stats->timers_fired = timers_fired;
+    pthread_mutex_unlock(&wheel_mutex);
+}
+
+// Function to stop the workers and the timer thread
+void task_pool_stop(void) {
+    if (!pool_running) {
+        return;
+    }
+
+    pthread_mutex_lock(&ready_mutex);
+    pool_running = 0;
+    pthread_cond_broadcast(&ready_cond);
+    pthread_mutex_unlock(&ready_mutex);
+
+    for (int i = 0; i < worker_count; i++) {
+        pthread_join(worker_threads[i], NULL);
+    }
+    pthread_join(timer_thread, NULL);
+
+    free(worker_threads);
+    worker_threads = NULL;
+    worker_count = 0;
+
+    // Release task records still queued or waiting on the wheel
+    while (ready_head != NULL) {
+        Task *task = ready_head;
+        ready_head = task->next;
+        free(task);
+    }
+    ready_tail = NULL;
+    for (int i = 0; i < TIMER_WHEEL_SLOTS; i++) {
+        while (wheel[i] != NULL) {
+            Task *task = wheel[i];
+            wheel[i] = task->next;
+            free(task);
+        }
+    }
+}
@@ -0,0 +1,39 @@
+// task_pool.h
+#ifndef TASK_POOL_H
+#define TASK_POOL_H
+
+#define TIMER_TICK_MS 100    // Resolution of the timer wheel
+#define TIMER_WHEEL_SLOTS 512 // Slots in the wheel (51.2 seconds per revolution)
+
+// One step of a task; returns milliseconds until the next step, or -1 when the task is finished
+typedef int (*TaskStep)(void *arg);
+
+// Lightweight task record scheduled on the worker pool
+typedef struct Task {
+    TaskStep step;
+    void *arg;
+    long expiry_tick;  // Wheel tick at which the task becomes runnable
+    struct Task *next;
+} Task;
+
+// Counters describing the pool
+typedef struct {
+    int workers;
+    long live_tasks;   // Submitted tasks not yet finished
+    long steps_run;    // Steps executed by workers
+    long timers_fired; // Tasks moved from the wheel to the ready queue
+} TaskPoolStats;
+
+// Function to start the worker pool and timer wheel (workers <= 0 means one per core)
+int task_pool_start(int workers);
+
+// Function to submit a task whose first step runs after delay_ms
+int task_pool_submit(TaskStep step, void *arg, int delay_ms);
+
+// Function to read the pool counters
+void task_pool_stats(TaskPoolStats *stats);
+
+// Function to stop the workers and the timer thread
+void task_pool_stop(void);
+
+#endif
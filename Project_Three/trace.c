@@ -0,0 +1,182 @@
+// trace.c
+#define _GNU_SOURCE // F_OFD_SETLKW
+#include "trace.h"
+#include <errno.h>
+#include <limits.h>
+#include <stdio.h>
+#include <string.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#define TRACE_CHUNK_BYTES (TRACE_CHUNK_RECORDS * (long)sizeof(TraceRecord))
+
+// Chunk a thread is filling, mapped straight from the trace file
+typedef struct {
+    TraceRecord *records;
+    int used;
+} TraceChunk;
+
+static int trace_fd = -1;
+static char trace_file[PATH_MAX]; // Path of the trace, reopened to take the growth lock
+static TraceFileHeader *header = NULL; // Shared mapping of the file header (NULL when tracing is off)
+static int64_t origin_ns = 0;
+static long (*clock_ms_hook)(void) = NULL;
+static pthread_key_t chunk_key;
+static __thread TraceChunk chunk = { NULL, 0 };
+
+// Function to read the clock events are stamped with
+static int64_t now_ns(void) {
+    if (clock_ms_hook != NULL) {
+        return (int64_t)clock_ms_hook() * 1000000;
+    }
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (int64_t)now.tv_sec * 1000000000 + now.tv_nsec - origin_ns;
+}
+
+// Function to name an event type
+const char *trace_event_name(int type) {
+    static const char *names[TRACE_EVENT_COUNT] = {
+        "none", "group_created", "spy_infiltrated", "member_targeted", "member_injured", "member_recovered",
+        "member_killed", "member_caught", "spy_arrested", "suspect_added", "suspect_released",
+        "suspect_imprisoned", "agent_injured", "agent_recovered", "agent_killed", "agent_caught"
+    };
+    return type > TRACE_NONE && type < TRACE_EVENT_COUNT ? names[type] : names[TRACE_NONE];
+}
+
+// Function to unmap a thread's chunk when the thread exits (its records are already in the file)
+static void release_chunk(void *records) {
+    munmap(records, TRACE_CHUNK_BYTES);
+}
+
+// Function to grow the file to at least size bytes without allocating disk blocks; returns 0 on success.
+// A grower must never shrink the file under a chunk another thread already maps, so growers check and
+// extend the size under an open file description lock on a descriptor of their own (the shared descriptor
+// would not exclude forked processes, nor threads). The lock goes away with the descriptor, even on a crash.
+static int grow_file(off_t size) {
+    int fd = open(trace_file, O_RDWR);
+    if (fd < 0) {
+        return -1;
+    }
+    struct flock lock = { .l_type = F_WRLCK, .l_whence = SEEK_SET, .l_start = 0, .l_len = 1 };
+    int result = -1;
+    while (fcntl(fd, F_OFD_SETLKW, &lock) == -1) {
+        if (errno != EINTR) {
+            close(fd);
+            return -1;
+        }
+    }
+    struct stat status;
+    if (fstat(fd, &status) == 0) {
+        result = status.st_size >= size || ftruncate(fd, size) == 0 ? 0 : -1;
+    }
+    close(fd);
+    return result;
+}
+
+// Function to claim the next chunk of the file for the calling thread; returns 0 on success
+static int claim_chunk(void) {
+    if (chunk.records != NULL) {
+        munmap(chunk.records, TRACE_CHUNK_BYTES);
+        chunk.records = NULL;
+        pthread_setspecific(chunk_key, NULL);
+    }
+
+    long index = __atomic_fetch_add(&header->chunks_claimed, 1, __ATOMIC_RELAXED);
+    off_t offset = TRACE_HEADER_BYTES + index * TRACE_CHUNK_BYTES;
+    // Sparse: a thread that logs a few events and exits costs the pages it wrote, not the whole chunk
+    if (grow_file(offset + TRACE_CHUNK_BYTES) != 0) {
+        return -1;
+    }
+    void *records = mmap(NULL, TRACE_CHUNK_BYTES, PROT_READ | PROT_WRITE, MAP_SHARED, trace_fd, offset);
+    if (records == MAP_FAILED) {
+        return -1;
+    }
+    chunk.records = records;
+    chunk.used = 0;
+    pthread_setspecific(chunk_key, records);
+    return 0;
+}
+
+// Function to start tracing to path (before any other thread or fork)
+int trace_open(const char *path, long (*clock_ms)(void)) {
+    if (snprintf(trace_file, sizeof(trace_file), "%s", path) >= (int)sizeof(trace_file)) {
+        fprintf(stderr, "[Trace] Trace path is too long.\n");
+        return -1;
+    }
+    trace_fd = open(path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (trace_fd < 0) {
+        perror("[Trace] Failed to open trace file");
+        return -1;
+    }
+    if (ftruncate(trace_fd, TRACE_HEADER_BYTES) != 0) {
+        perror("[Trace] Failed to size trace file");
+        close(trace_fd);
+        return -1;
+    }
+    void *mapping = mmap(NULL, TRACE_HEADER_BYTES, PROT_READ | PROT_WRITE, MAP_SHARED, trace_fd, 0);
+    if (mapping == MAP_FAILED) {
+        perror("[Trace] Failed to map trace header");
+        close(trace_fd);
+        return -1;
+    }
+    if (pthread_key_create(&chunk_key, release_chunk) != 0) {
+        perror("[Trace] Failed to create the chunk key");
+        munmap(mapping, TRACE_HEADER_BYTES);
+        close(trace_fd);
+        return -1;
+    }
+
+    TraceFileHeader *file_header = mapping;
+    file_header->magic = TRACE_MAGIC;
+    file_header->version = TRACE_VERSION;
+    file_header->record_size = sizeof(TraceRecord);
+    file_header->chunk_records = TRACE_CHUNK_RECORDS;
+    file_header->simulated_clock = clock_ms != NULL;
+
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    origin_ns = (int64_t)now.tv_sec * 1000000000 + now.tv_nsec;
+    clock_ms_hook = clock_ms;
+    header = file_header;
+    return 0;
+}
+
+// Function to give a forked child's thread its own chunk instead of the one it shares with the parent
+void trace_after_fork(void) {
+    if (chunk.records != NULL) {
+        munmap(chunk.records, TRACE_CHUNK_BYTES); // Only this process's view; the parent keeps filling it
+        chunk.records = NULL;
+        pthread_setspecific(chunk_key, NULL);
+    }
+}
+
+// Function to record an event; does nothing when tracing is off
+void trace_event(int type, int group_id, int member_id, int agent_id, int value, int detail) {
+    if (header == NULL) {
+        return;
+    }
+    if ((chunk.records == NULL || chunk.used == TRACE_CHUNK_RECORDS) && claim_chunk() != 0) {
+        __atomic_add_fetch(&header->dropped, 1, __ATOMIC_RELAXED);
+        return;
+    }
+
+    TraceRecord *record = &chunk.records[chunk.used++];
+    record->time_ns = now_ns();
+    record->detail = (uint16_t)detail;
+    record->group_id = group_id;
+    record->member_id = member_id;
+    record->agent_id = agent_id;
+    record->value = value;
+    __atomic_store_n(&record->type, (uint16_t)type, __ATOMIC_RELEASE); // Last: a slot with a type is complete
+}
+
+// Function to read how many chunks were claimed and how many events were dropped by every process
+void trace_totals(long *chunks, long *dropped) {
+    *chunks = header != NULL ? __atomic_load_n(&header->chunks_claimed, __ATOMIC_RELAXED) : 0;
+    *dropped = header != NULL ? __atomic_load_n(&header->dropped, __ATOMIC_RELAXED) : 0;
+}
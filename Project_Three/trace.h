@@ -0,0 +1,74 @@
+// trace.h
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <stdint.h>
+
+#define TRACE_MAGIC 0x43525453 // "STRC"
+#define TRACE_VERSION 1
+#define TRACE_HEADER_BYTES 4096    // The header owns the first page of the file
+#define TRACE_CHUNK_RECORDS 2048   // Records per chunk a thread claims (64 KiB)
+
+// Domain events recorded in the trace
+typedef enum {
+    TRACE_NONE = 0,           // Unused slot at the end of a chunk
+    TRACE_GROUP_CREATED,      // group_id; value = size, detail = 1 for a military group
+    TRACE_SPY_INFILTRATED,    // group_id, member_id
+    TRACE_MEMBER_TARGETED,    // group_id, member_id; detail = 1 for a spy (spies are not harmed)
+    TRACE_MEMBER_INJURED,     // group_id, member_id; value = 1 light (recovers), 2 severe (exits)
+    TRACE_MEMBER_RECOVERED,   // group_id, member_id
+    TRACE_MEMBER_KILLED,      // group_id, member_id
+    TRACE_MEMBER_CAUGHT,      // group_id, member_id (caught by the enemy)
+    TRACE_SPY_ARRESTED,       // group_id, member_id (a suspected spy taken by the agency)
+    TRACE_SUSPECT_ADDED,      // group_id, member_id = suspect, agent_id
+    TRACE_SUSPECT_RELEASED,   // group_id, member_id = suspect, agent_id
+    TRACE_SUSPECT_IMPRISONED, // group_id, member_id = suspect, agent_id
+    TRACE_AGENT_INJURED,      // agent_id; value = 1 light (recovers), 2 severe (exits)
+    TRACE_AGENT_RECOVERED,    // agent_id
+    TRACE_AGENT_KILLED,       // agent_id
+    TRACE_AGENT_CAUGHT,       // agent_id
+    TRACE_EVENT_COUNT
+} TraceEventType;
+
+// Fixed-size record (32 bytes)
+typedef struct {
+    int64_t time_ns;   // Nanoseconds since trace_open (simulated time in virtual-time runs)
+    uint16_t type;     // TraceEventType
+    uint16_t detail;
+    int32_t group_id;
+    int32_t member_id;
+    int32_t agent_id;
+    int32_t value;
+    uint32_t reserved;
+} TraceRecord;
+
+// File header, mapped by every process of the run. Chunks of TRACE_CHUNK_RECORDS records follow it
+// in the order threads claimed them; each chunk is written by one thread only.
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t record_size;
+    uint32_t chunk_records;
+    uint32_t simulated_clock; // 1 when times are simulated (virtual time)
+    uint32_t reserved;
+    int64_t chunks_claimed;
+    int64_t dropped;          // Events lost because no chunk could be claimed
+} TraceFileHeader;
+
+// Function to start tracing to path (before any other thread or fork); clock_ms stamps events in
+// milliseconds instead of the monotonic clock when it is not NULL. Returns 0 on success, -1 on failure.
+int trace_open(const char *path, long (*clock_ms)(void));
+
+// Function to give a forked child's thread its own chunk instead of the one it shares with the parent
+void trace_after_fork(void);
+
+// Function to record an event; does nothing when tracing is off
+void trace_event(int type, int group_id, int member_id, int agent_id, int value, int detail);
+
+// Function to read how many chunks were claimed and how many events were dropped by every process
+void trace_totals(long *chunks, long *dropped);
+
+// Function to name an event type
+const char *trace_event_name(int type);
+
+#endif
@@ -0,0 +1,327 @@
+// trace_analyze.c
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include "trace.h"
+
+#define DEFAULT_BUCKET_SECONDS 10 // Width of a casualty timeline row
+
+// Casualty columns of the timeline
+typedef enum {
+    CASUALTY_MEMBER_KILLED = 0,
+    CASUALTY_MEMBER_INJURED,
+    CASUALTY_MEMBER_CAUGHT,
+    CASUALTY_SPY_ARRESTED,
+    CASUALTY_AGENT_KILLED,
+    CASUALTY_AGENT_INJURED,
+    CASUALTY_AGENT_CAUGHT,
+    CASUALTY_COUNT
+} Casualty;
+
+static const char *casualty_names[CASUALTY_COUNT] = {
+    "res_killed", "res_injured", "res_caught", "spy_arrested", "agent_killed", "agent_injured", "agent_caught"
+};
+
+// What the trace says about a member named as a spy or a suspect
+typedef struct {
+    int member_id;       // 0 for a free table slot
+    int infiltrated;     // The member entered as a spy
+    int active;          // A spy not yet arrested or imprisoned
+    int64_t infiltrated_ns;
+    int64_t detected_ns; // First time the spy was named a suspect, -1 when never
+    int suspected_falsely; // The suspect naming that is still open named a member who was not an active spy
+} MemberState;
+
+// Records in time order, with their position in the file to keep each thread's order on ties
+typedef struct {
+    TraceRecord record;
+    long position;
+} OrderedRecord;
+
+static MemberState *members = NULL;
+static long member_capacity = 0;
+
+// Function to print usage
+static void usage(const char *program) {
+    fprintf(stderr, "Usage: %s simulation.trace [--bucket SECONDS] [--csv]\n", program);
+}
+
+// Function to find a member's state, creating it on first use (the table is sized for every record)
+static MemberState *member_state(int member_id) {
+    long slot = ((unsigned int)member_id * 2654435761u) & (member_capacity - 1);
+    while (members[slot].member_id != 0 && members[slot].member_id != member_id) {
+        slot = (slot + 1) & (member_capacity - 1);
+    }
+    if (members[slot].member_id == 0) {
+        members[slot].member_id = member_id;
+        members[slot].detected_ns = -1;
+    }
+    return &members[slot];
+}
+
+// Function to order records by time, then by position in the file
+static int compare_records(const void *a, const void *b) {
+    const OrderedRecord *record_a = a;
+    const OrderedRecord *record_b = b;
+    if (record_a->record.time_ns != record_b->record.time_ns) {
+        return record_a->record.time_ns < record_b->record.time_ns ? -1 : 1;
+    }
+    return (record_a->position > record_b->position) - (record_a->position < record_b->position);
+}
+
+// Function to order detection times
+static int compare_times(const void *a, const void *b) {
+    int64_t time_a = *(const int64_t *)a;
+    int64_t time_b = *(const int64_t *)b;
+    return (time_a > time_b) - (time_a < time_b);
+}
+
+// Function to pick a percentile of sorted values (nearest rank)
+static double percentile_seconds(const int64_t *sorted, long count, double percent) {
+    long rank = (long)(percent / 100.0 * count + 0.999999);
+    if (rank < 1) {
+        rank = 1;
+    }
+    return sorted[rank - 1] / 1e9;
+}
+
+// Function to read the records of a trace; returns the number read, or -1 on failure
+static long read_trace(const char *path, OrderedRecord **records_out, TraceFileHeader *header) {
+    FILE *file = fopen(path, "rb");
+    if (file == NULL) {
+        perror("[Analyze] Failed to open trace");
+        return -1;
+    }
+    if (fread(header, sizeof(*header), 1, file) != 1 || header->magic != TRACE_MAGIC) {
+        fprintf(stderr, "[Analyze] %s is not a simulation trace.\n", path);
+        fclose(file);
+        return -1;
+    }
+    if (header->version != TRACE_VERSION || header->record_size != sizeof(TraceRecord)) {
+        fprintf(stderr, "[Analyze] Trace version %u with %u-byte records is not supported.\n",
+                header->version, header->record_size);
+        fclose(file);
+        return -1;
+    }
+
+    long capacity = 1024;
+    long count = 0;
+    OrderedRecord *records = malloc(sizeof(OrderedRecord) * capacity);
+    TraceRecord batch[TRACE_CHUNK_RECORDS];
+    long position = 0;
+    size_t read;
+    if (records == NULL || fseek(file, TRACE_HEADER_BYTES, SEEK_SET) != 0) {
+        perror("[Analyze] Failed to read trace");
+        free(records);
+        fclose(file);
+        return -1;
+    }
+    while ((read = fread(batch, sizeof(TraceRecord), TRACE_CHUNK_RECORDS, file)) > 0) {
+        for (size_t i = 0; i < read; i++, position++) {
+            if (batch[i].type == TRACE_NONE || batch[i].type >= TRACE_EVENT_COUNT) {
+                continue; // Unused end of a chunk
+            }
+            if (count == capacity) {
+                OrderedRecord *grown = realloc(records, sizeof(OrderedRecord) * capacity * 2);
+                if (grown == NULL) {
+                    perror("[Analyze] Failed to allocate records");
+                    free(records);
+                    fclose(file);
+                    return -1;
+                }
+                records = grown;
+                capacity *= 2;
+            }
+            records[count].record = batch[i];
+            records[count].position = position;
+            count++;
+        }
+    }
+    fclose(file);
+    *records_out = records;
+    return count;
+}
+
+// Main function
+int main(int argc, char *argv[]) {
+    const char *path = NULL;
+    double bucket_seconds = DEFAULT_BUCKET_SECONDS;
+    int csv = 0;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--bucket") == 0 && i + 1 < argc) {
+            bucket_seconds = atof(argv[++i]);
+        } else if (strcmp(argv[i], "--csv") == 0) {
+            csv = 1;
+        } else if (argv[i][0] != '-' && path == NULL) {
+            path = argv[i];
+        } else {
+            usage(argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+    if (path == NULL || bucket_seconds <= 0) {
+        usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    TraceFileHeader header;
+    OrderedRecord *records = NULL;
+    long count = read_trace(path, &records, &header);
+    if (count < 0) {
+        return EXIT_FAILURE;
+    }
+    qsort(records, count, sizeof(OrderedRecord), compare_records);
+    int64_t end_ns = count > 0 ? records[count - 1].record.time_ns : 0;
+
+    member_capacity = 16;
+    while (member_capacity < 2 * count) {
+        member_capacity *= 2;
+    }
+    long buckets = (long)(end_ns / 1e9 / bucket_seconds) + 1;
+    members = calloc(member_capacity, sizeof(MemberState));
+    long (*timeline)[CASUALTY_COUNT] = calloc(buckets, sizeof(*timeline));
+    int64_t *detections = malloc(sizeof(int64_t) * (count > 0 ? count : 1));
+    if (members == NULL || timeline == NULL || detections == NULL) {
+        perror("[Analyze] Failed to allocate analysis tables");
+        return EXIT_FAILURE;
+    }
+
+    // Replay the run in time order
+    long by_type[TRACE_EVENT_COUNT] = { 0 };
+    long spies = 0, detected = 0;
+    long suspects = 0, false_suspects = 0;
+    long released = 0, false_released = 0;
+    long imprisoned = 0, false_imprisoned = 0;
+    for (long i = 0; i < count; i++) {
+        const TraceRecord *record = &records[i].record;
+        long bucket = (long)(record->time_ns / 1e9 / bucket_seconds);
+        MemberState *member = NULL;
+        by_type[record->type]++;
+
+        switch (record->type) {
+        case TRACE_SPY_INFILTRATED:
+            member = member_state(record->member_id);
+            member->infiltrated = 1;
+            member->active = 1;
+            member->infiltrated_ns = record->time_ns;
+            spies++;
+            break;
+        case TRACE_SUSPECT_ADDED:
+            member = member_state(record->member_id);
+            suspects++;
+            member->suspected_falsely = !member->active;
+            if (member->suspected_falsely) {
+                false_suspects++;
+            } else if (member->detected_ns < 0) {
+                member->detected_ns = record->time_ns;
+                detections[detected++] = record->time_ns - member->infiltrated_ns;
+            }
+            break;
+        case TRACE_SUSPECT_RELEASED:
+            member = member_state(record->member_id);
+            released++;
+            false_released += member->suspected_falsely;
+            break;
+        case TRACE_SUSPECT_IMPRISONED:
+            member = member_state(record->member_id);
+            imprisoned++;
+            false_imprisoned += member->suspected_falsely;
+            member->active = 0;
+            break;
+        case TRACE_SPY_ARRESTED:
+            member_state(record->member_id)->active = 0;
+            timeline[bucket][CASUALTY_SPY_ARRESTED]++;
+            break;
+        case TRACE_MEMBER_KILLED:
+            timeline[bucket][CASUALTY_MEMBER_KILLED]++;
+            break;
+        case TRACE_MEMBER_INJURED:
+            timeline[bucket][CASUALTY_MEMBER_INJURED]++;
+            break;
+        case TRACE_MEMBER_CAUGHT:
+            timeline[bucket][CASUALTY_MEMBER_CAUGHT]++;
+            break;
+        case TRACE_AGENT_KILLED:
+            timeline[bucket][CASUALTY_AGENT_KILLED]++;
+            break;
+        case TRACE_AGENT_INJURED:
+            timeline[bucket][CASUALTY_AGENT_INJURED]++;
+            break;
+        case TRACE_AGENT_CAUGHT:
+            timeline[bucket][CASUALTY_AGENT_CAUGHT]++;
+            break;
+        default:
+            break;
+        }
+    }
+
+    if (csv) {
+        // The casualty timeline alone, one row per bucket
+        printf("start_seconds");
+        for (int c = 0; c < CASUALTY_COUNT; c++) {
+            printf(",%s", casualty_names[c]);
+        }
+        printf("\n");
+        for (long b = 0; b < buckets; b++) {
+            printf("%.1f", b * bucket_seconds);
+            for (int c = 0; c < CASUALTY_COUNT; c++) {
+                printf(",%ld", timeline[b][c]);
+            }
+            printf("\n");
+        }
+    } else {
+        printf("[Analyze] %ld events over %.1f %s seconds in %ld chunks (%ld events dropped while tracing).\n",
+               count, end_ns / 1e9, header.simulated_clock ? "simulated" : "wall", (long)header.chunks_claimed,
+               (long)header.dropped);
+        for (int t = TRACE_NONE + 1; t < TRACE_EVENT_COUNT; t++) {
+            printf("  %-20s %8ld\n", trace_event_name(t), by_type[t]);
+        }
+
+        printf("\nSpy time to detection: %ld spies, %ld detected, %ld never suspected.\n",
+               spies, detected, spies - detected);
+        if (detected > 0) {
+            qsort(detections, detected, sizeof(int64_t), compare_times);
+            double total = 0;
+            for (long i = 0; i < detected; i++) {
+                total += detections[i] / 1e9;
+            }
+            printf("  mean %.1f s, median %.1f s, p90 %.1f s, max %.1f s\n", total / detected,
+                   percentile_seconds(detections, detected, 50), percentile_seconds(detections, detected, 90),
+                   detections[detected - 1] / 1e9);
+        }
+
+        // A suspect is false when the member named is not a spy at large (never infiltrated, or
+        // already arrested or imprisoned); a release or imprisonment inherits that from the naming
+        printf("\nFalse arrests: %ld of %ld suspects (%.1f%%).\n", false_suspects, suspects,
+               suspects > 0 ? 100.0 * false_suspects / suspects : 0.0);
+        printf("  released %ld (%ld false), imprisoned %ld (%ld false)\n", released, false_released,
+               imprisoned, false_imprisoned);
+
+        printf("\nCasualty timeline (%.0f s buckets):\n%8s", bucket_seconds, "start");
+        for (int c = 0; c < CASUALTY_COUNT; c++) {
+            printf(" %13s", casualty_names[c]);
+        }
+        printf("\n");
+        long totals[CASUALTY_COUNT] = { 0 };
+        for (long b = 0; b < buckets; b++) {
+            printf("%8.1f", b * bucket_seconds);
+            for (int c = 0; c < CASUALTY_COUNT; c++) {
+                printf(" %13ld", timeline[b][c]);
+                totals[c] += timeline[b][c];
+            }
+            printf("\n");
+        }
+        printf("%8s", "total");
+        for (int c = 0; c < CASUALTY_COUNT; c++) {
+            printf(" %13ld", totals[c]);
+        }
+        printf("\n");
+    }
+
+    free(detections);
+    free(timeline);
+    free(members);
+    free(records);
+    return 0;
+}
@@ -1,12 +1,37 @@
 // visualization.c
+#define GL_GLEXT_PROTOTYPES
 #include "visualization.h"
 #include <GL/glut.h>
+#include <GL/glext.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <stddef.h>
 #include <unistd.h>
 #include <string.h>
+#include <time.h>
 #include <math.h> // Included for cosf and sinf
 
+#define FRAME_INTERVAL_MS 16 // Redraw pacing: about 60 frames per second
+#define CIRCLE_SEGMENTS 20   // Rim segments of a group's circle
+#define MESH_VERTICES 128    // Unit meshes plus the background grid lines
+#define SNAPSHOT_READ_ATTEMPTS 3 // Snapshot reads per frame before drawing what was read anyway
+
+// Shapes drawn with one instanced call each
+enum { SHAPE_GROUP = 0, SHAPE_AGENT, SHAPE_CAUGHT_RESISTANCE, SHAPE_CAUGHT_AGENCY, SHAPE_COUNT };
+
+// Vertex attribute locations of the instancing shader
+enum { ATTRIB_VERTEX = 0, ATTRIB_OFFSET, ATTRIB_SIZE, ATTRIB_COLOR };
+
+// One drawn entity: where, how large and which color
+typedef struct {
+    float x;
+    float y;
+    float size;
+    float r;
+    float g;
+    float b;
+} Instance;
+
 // Global pointer to shared data for access in callbacks
 SharedData *global_shared_data = NULL;
 
@@ -21,6 +46,40 @@ float scoreboard_width_ratio = 0.3f;
 // Fonts
 void *font = GLUT_BITMAP_HELVETICA_18;
 
+// Instances per shape, kept across frames and built only from the published snapshots, never from the live
+// simulation state. Groups are indexed by slot and rebuilt only when the slot's handle changes (a group's
+// position and type never change once published); the other shapes are few and are refilled every frame.
+// Only the dirty range of each array is uploaded.
+static Instance *frame_instances[SHAPE_COUNT];
+static int frame_counts[SHAPE_COUNT];
+static int frame_capacity[SHAPE_COUNT];
+static int dirty_first[SHAPE_COUNT]; // Instances changed since the last upload (none when first > last)
+static int dirty_last[SHAPE_COUNT];
+static int *group_handles = NULL;    // Handle each group instance was built from (-1 free, -2 not built)
+static int group_changes = -1;       // Group map change counter the group instances were built at
+static int group_retry = 0;          // A slot was overwritten while it was read and must be rebuilt next frame
+static SnapshotCounters frame_counters; // Scoreboard counters of the snapshot drawn
+
+// Unit meshes (triangle fans) and background grid lines, uploaded once
+static float mesh_vertices[MESH_VERTICES][2];
+static int mesh_first[SHAPE_COUNT];
+static int mesh_count[SHAPE_COUNT];
+static int grid_first;
+static int grid_count;
+
+// GL objects; instance_program stays 0 when drawing without instancing
+static GLuint instance_program = 0;
+static GLuint mesh_buffer = 0;
+static GLuint instance_buffers[SHAPE_COUNT];
+static int buffer_capacity[SHAPE_COUNT];
+
+// Frame timing shown on the scoreboard
+static double last_frame_ms = 0.0; // CPU time spent building and drawing the last frame
+static double frames_per_second = 0.0;
+static int frames_this_second = 0;
+static double second_start_ms = 0.0;
+static double next_frame_ms = 0.0;
+
 // Function to draw text on the screen
 void draw_text(float x, float y, const char *text, float r, float g, float b) {
     glColor3f(r, g, b);
@@ -30,30 +89,379 @@ void draw_text(float x, float y, const char *text, float r, float g, float b) {
     }
 }
 
-// Function to draw a circle representing a resistance group
-void draw_circle(float x, float y, float radius, float r, float g, float b) {
-    glColor3f(r, g, b);
-    glBegin(GL_TRIANGLE_FAN);
-        glVertex2f(x, y); // Center of circle
-        int num_segments = 20;
-        for(int i = 0; i <= num_segments; i++) { 
-            float angle = 2.0f * M_PI * i / num_segments;
-            float dx = radius * cosf(angle);
-            float dy = radius * sinf(angle);
-            glVertex2f(x + dx, y + dy);
+// Function to read the monotonic clock in milliseconds
+static double now_ms(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec * 1000.0 + now.tv_nsec / 1e6;
+}
+
+// Function to make room for count instances of a shape; returns 0 when memory runs out
+static int reserve_instances(int shape, int count) {
+    if (count <= frame_capacity[shape]) {
+        return 1;
+    }
+    int capacity = frame_capacity[shape] > 0 ? frame_capacity[shape] : 1024;
+    while (capacity < count) {
+        capacity *= 2;
+    }
+    Instance *grown = realloc(frame_instances[shape], sizeof(Instance) * capacity);
+    if (grown == NULL) {
+        return 0;
+    }
+    frame_instances[shape] = grown;
+
+    if (shape == SHAPE_GROUP) {
+        int *handles = realloc(group_handles, sizeof(int) * capacity);
+        if (handles == NULL) {
+            return 0;
         }
-    glEnd();
+        for (int i = frame_capacity[shape]; i < capacity; i++) {
+            handles[i] = -2;
+        }
+        group_handles = handles;
+    }
+    frame_capacity[shape] = capacity;
+    return 1;
 }
 
-// Function to draw an agency member as a distinct shape (e.g., diamond)
-void draw_agency_member(float x, float y, float size, float r, float g, float b) {
-    glColor3f(r, g, b);
-    glBegin(GL_POLYGON);
-        glVertex2f(x, y + size);
-        glVertex2f(x + size, y);
-        glVertex2f(x, y - size);
-        glVertex2f(x - size, y);
-    glEnd();
+// Function to widen a shape's dirty range to include one instance
+static void mark_dirty(int shape, int i) {
+    if (dirty_first[shape] > dirty_last[shape]) {
+        dirty_first[shape] = i;
+        dirty_last[shape] = i;
+    } else if (i < dirty_first[shape]) {
+        dirty_first[shape] = i;
+    } else if (i > dirty_last[shape]) {
+        dirty_last[shape] = i;
+    }
+}
+
+// Function to set the color of an instance
+static void set_color(Instance *instance, float r, float g, float b) {
+    instance->r = r;
+    instance->g = g;
+    instance->b = b;
+}
+
+// Function to append one instance of a shape refilled every frame
+static void add_instance(int shape, float x, float y, float size, float r, float g, float b) {
+    if (!reserve_instances(shape, frame_counts[shape] + 1)) {
+        return; // Drop the instance; the next frame tries again
+    }
+    mark_dirty(shape, frame_counts[shape]);
+    Instance *instance = &frame_instances[shape][frame_counts[shape]++];
+    instance->x = x;
+    instance->y = y;
+    instance->size = size;
+    set_color(instance, r, g, b);
+}
+
+// Function to rebuild the instances of group slots whose handle changed since the last frame
+static void update_group_instances(const Snapshot *snapshot, unsigned int sequence) {
+    // No group appeared or dissolved since the last scan: every instance is current
+    if (snapshot->group_changes == group_changes && !group_retry) {
+        return;
+    }
+
+    int group_extent = snapshot->group_extent;
+    if (!reserve_instances(SHAPE_GROUP, group_extent)) {
+        return;
+    }
+    group_changes = snapshot->group_changes;
+    group_retry = 0;
+
+    const SnapshotGroup *groups = snapshot_groups(snapshot);
+    int built = group_extent; // Slots whose instance is current, drawn this frame
+    for (int i = 0; i < group_extent; i++) {
+        int handle = groups[i].handle;
+        if (handle == group_handles[i]) {
+            continue; // Same group (or still free) as last frame
+        }
+
+        Instance *instance = &frame_instances[SHAPE_GROUP][i];
+        if (handle < 0) {
+            instance->size = 0.0f; // Free or dissolved slot: drawn with no area
+        } else {
+            instance->x = groups[i].x;
+            instance->y = groups[i].y;
+            instance->size = 5.0f;
+            if (groups[i].kind == SNAPSHOT_GROUP_SPY) {
+                set_color(instance, 1.0f, 0.0f, 0.0f); // Red for groups with spies
+            } else if (groups[i].kind == SNAPSHOT_GROUP_MILITARY) {
+                set_color(instance, 0.0f, 0.0f, 1.0f); // Blue for military groups
+            } else {
+                set_color(instance, 0.0f, 1.0f, 0.0f); // Green for social groups
+            }
+        }
+        mark_dirty(SHAPE_GROUP, i);
+
+        // The publisher lapped this frame: the slot may be torn, so hide it and rebuild it and the rest next
+        // frame. Slots past it that no frame built yet hold nothing to draw, so the count stops at this slot
+        // or at what the last frame drew.
+        if (!snapshot_validate(snapshot, sequence)) {
+            instance->size = 0.0f;
+            group_handles[i] = -2;
+            group_retry = 1;
+            built = frame_counts[SHAPE_GROUP] > i + 1 ? frame_counts[SHAPE_GROUP] : i + 1;
+            break;
+        }
+        group_handles[i] = handle;
+    }
+    frame_counts[SHAPE_GROUP] = built;
+}
+
+// Function to bring this frame's instance arrays up to date with the newest snapshot (never locks)
+static void build_frame(SharedData *shared) {
+    for (int attempt = 0; attempt < SNAPSHOT_READ_ATTEMPTS; attempt++) {
+        unsigned int sequence;
+        const Snapshot *snapshot = snapshot_acquire(&shared->snapshots, &sequence);
+        if (snapshot == NULL) {
+            return; // Nothing published yet
+        }
+
+        update_group_instances(snapshot, sequence);
+        frame_counts[SHAPE_AGENT] = 0;
+        frame_counts[SHAPE_CAUGHT_RESISTANCE] = 0;
+        frame_counts[SHAPE_CAUGHT_AGENCY] = 0;
+
+        float (*agents)[2] = snapshot_agents(snapshot);
+        for (int i = 0; i < snapshot->agent_count; i++) {
+            add_instance(SHAPE_AGENT, agents[i][0], agents[i][1], 3.0f, 1.0f, 1.0f, 0.0f); // Yellow diamonds
+        }
+        float (*caught_resistance)[2] = snapshot_caught_resistance(snapshot);
+        for (int i = 0; i < snapshot->caught_resistance_count; i++) {
+            add_instance(SHAPE_CAUGHT_RESISTANCE, caught_resistance[i][0], caught_resistance[i][1],
+                         1.0f, 0.5f, 0.0f, 0.5f); // Purple squares
+        }
+        float (*caught_agency)[2] = snapshot_caught_agency(snapshot);
+        for (int i = 0; i < snapshot->caught_agency_count; i++) {
+            add_instance(SHAPE_CAUGHT_AGENCY, caught_agency[i][0], caught_agency[i][1],
+                         1.0f, 1.0f, 0.0f, 1.0f); // Magenta triangles
+        }
+        frame_counters = snapshot->counters;
+
+        if (snapshot_validate(snapshot, sequence)) {
+            return;
+        }
+        // Overwritten while read: take the newer snapshot
+    }
+}
+
+// Function to fill the unit meshes every instance of a shape is drawn from (as triangle fans)
+static void build_meshes(void) {
+    int vertex = 0;
+
+    // Circle for resistance groups: center, then the rim closed back on its first point
+    mesh_first[SHAPE_GROUP] = vertex;
+    mesh_vertices[vertex][0] = 0.0f;
+    mesh_vertices[vertex++][1] = 0.0f;
+    for (int i = 0; i <= CIRCLE_SEGMENTS; i++) {
+        float angle = 2.0f * M_PI * i / CIRCLE_SEGMENTS;
+        mesh_vertices[vertex][0] = cosf(angle);
+        mesh_vertices[vertex++][1] = sinf(angle);
+    }
+    mesh_count[SHAPE_GROUP] = vertex - mesh_first[SHAPE_GROUP];
+
+    // Diamond for agency members, square for caught resistance members, triangle for caught agency members
+    static const float diamond[4][2] = { { 0, 1 }, { 1, 0 }, { 0, -1 }, { -1, 0 } };
+    static const float square[4][2] = { { -1, -1 }, { 1, -1 }, { 1, 1 }, { -1, 1 } };
+    static const float triangle[3][2] = { { 0, 1 }, { -1, -1 }, { 1, -1 } };
+    const float (*shapes[3])[2] = { diamond, square, triangle };
+    const int shape_ids[3] = { SHAPE_AGENT, SHAPE_CAUGHT_RESISTANCE, SHAPE_CAUGHT_AGENCY };
+    const int corners[3] = { 4, 4, 3 };
+    for (int s = 0; s < 3; s++) {
+        mesh_first[shape_ids[s]] = vertex;
+        for (int i = 0; i < corners[s]; i++) {
+            mesh_vertices[vertex][0] = shapes[s][i][0];
+            mesh_vertices[vertex++][1] = shapes[s][i][1];
+        }
+        mesh_count[shape_ids[s]] = corners[s];
+    }
+
+    // Background grid lines, drawn once per frame without instancing
+    grid_first = vertex;
+    for (int i = -100; i <= 100; i += 10) {
+        float line[4][2] = { { i, -100.0f }, { i, 100.0f }, { -100.0f, i }, { 100.0f, i } };
+        for (int j = 0; j < 4; j++) {
+            mesh_vertices[vertex][0] = line[j][0];
+            mesh_vertices[vertex++][1] = line[j][1];
+        }
+    }
+    grid_count = vertex - grid_first;
+}
+
+// Function to compile one shader stage; returns 0 on failure
+static GLuint compile_shader(GLenum type, const char *source) {
+    GLuint shader = glCreateShader(type);
+    glShaderSource(shader, 1, &source, NULL);
+    glCompileShader(shader);
+
+    GLint compiled = GL_FALSE;
+    glGetShaderiv(shader, GL_COMPILE_STATUS, &compiled);
+    if (compiled != GL_TRUE) {
+        char log[512];
+        glGetShaderInfoLog(shader, sizeof(log), NULL, log);
+        fprintf(stderr, "[Visualization] Shader compilation failed: %s\n", log);
+        glDeleteShader(shader);
+        return 0;
+    }
+    return shader;
+}
+
+// Function to set up the instancing shader and buffers; returns 0 when instancing is unavailable
+static int init_instancing(void) {
+    int major = 0;
+    int minor = 0;
+    const char *version = (const char *)glGetString(GL_VERSION);
+    if (version == NULL || sscanf(version, "%d.%d", &major, &minor) != 2 || major * 10 + minor < 33) {
+        fprintf(stderr, "[Visualization] OpenGL %s lacks instanced arrays (3.3 needed); drawing without instancing.\n",
+                version != NULL ? version : "(unknown)");
+        return 0;
+    }
+
+    // Each vertex is a unit mesh point scaled and moved by its instance, on the -100..100 map
+    static const char *vertex_source =
+        "#version 130\n"
+        "in vec2 vertex;\n"
+        "in vec2 offset;\n"
+        "in float size;\n"
+        "in vec3 color;\n"
+        "out vec3 instance_color;\n"
+        "void main() {\n"
+        "    gl_Position = vec4((offset + vertex * size) / 100.0, 0.0, 1.0);\n"
+        "    instance_color = color;\n"
+        "}\n";
+    static const char *fragment_source =
+        "#version 130\n"
+        "in vec3 instance_color;\n"
+        "void main() {\n"
+        "    gl_FragColor = vec4(instance_color, 1.0);\n"
+        "}\n";
+
+    GLuint vertex_shader = compile_shader(GL_VERTEX_SHADER, vertex_source);
+    GLuint fragment_shader = compile_shader(GL_FRAGMENT_SHADER, fragment_source);
+    if (vertex_shader == 0 || fragment_shader == 0) {
+        return 0;
+    }
+    instance_program = glCreateProgram();
+    glAttachShader(instance_program, vertex_shader);
+    glAttachShader(instance_program, fragment_shader);
+    glBindAttribLocation(instance_program, ATTRIB_VERTEX, "vertex");
+    glBindAttribLocation(instance_program, ATTRIB_OFFSET, "offset");
+    glBindAttribLocation(instance_program, ATTRIB_SIZE, "size");
+    glBindAttribLocation(instance_program, ATTRIB_COLOR, "color");
+    glLinkProgram(instance_program);
+    glDeleteShader(vertex_shader);
+    glDeleteShader(fragment_shader);
+
+    GLint linked = GL_FALSE;
+    glGetProgramiv(instance_program, GL_LINK_STATUS, &linked);
+    if (linked != GL_TRUE) {
+        fprintf(stderr, "[Visualization] Shader program failed to link; drawing without instancing.\n");
+        glDeleteProgram(instance_program);
+        instance_program = 0;
+        return 0;
+    }
+
+    // Meshes are uploaded once; instance buffers persist and are refilled every frame
+    glGenBuffers(1, &mesh_buffer);
+    glBindBuffer(GL_ARRAY_BUFFER, mesh_buffer);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(mesh_vertices), mesh_vertices, GL_STATIC_DRAW);
+    glGenBuffers(SHAPE_COUNT, instance_buffers);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    return 1;
+}
+
+// Function to upload a shape's instances and draw them all with one call
+static void draw_instances(int shape) {
+    int count = frame_counts[shape];
+    if (count == 0) {
+        return;
+    }
+
+    glBindBuffer(GL_ARRAY_BUFFER, instance_buffers[shape]);
+    if (count > buffer_capacity[shape]) {
+        // Grow the persistent buffer to the array's capacity and upload everything once
+        buffer_capacity[shape] = frame_capacity[shape];
+        glBufferData(GL_ARRAY_BUFFER, sizeof(Instance) * buffer_capacity[shape], NULL, GL_DYNAMIC_DRAW);
+        dirty_first[shape] = 0;
+        dirty_last[shape] = count - 1;
+    }
+    if (dirty_first[shape] <= dirty_last[shape]) {
+        glBufferSubData(GL_ARRAY_BUFFER, sizeof(Instance) * dirty_first[shape],
+                        sizeof(Instance) * (dirty_last[shape] - dirty_first[shape] + 1),
+                        &frame_instances[shape][dirty_first[shape]]);
+        dirty_first[shape] = 1;
+        dirty_last[shape] = 0;
+    }
+    glVertexAttribPointer(ATTRIB_OFFSET, 2, GL_FLOAT, GL_FALSE, sizeof(Instance), (void *)offsetof(Instance, x));
+    glVertexAttribPointer(ATTRIB_SIZE, 1, GL_FLOAT, GL_FALSE, sizeof(Instance), (void *)offsetof(Instance, size));
+    glVertexAttribPointer(ATTRIB_COLOR, 3, GL_FLOAT, GL_FALSE, sizeof(Instance), (void *)offsetof(Instance, r));
+
+    glDrawArraysInstanced(GL_TRIANGLE_FAN, mesh_first[shape], mesh_count[shape], count);
+}
+
+// Function to draw the map (grid and every entity) from this frame's instance arrays
+static void draw_map(void) {
+    if (instance_program == 0) {
+        // Fallback without instancing: the same meshes and instances in immediate mode
+        glColor3f(0.2f, 0.2f, 0.2f); // Dark gray grid lines
+        glLineWidth(0.5f);
+        glBegin(GL_LINES);
+        for (int v = grid_first; v < grid_first + grid_count; v++) {
+            glVertex2f(mesh_vertices[v][0], mesh_vertices[v][1]);
+        }
+        glEnd();
+        for (int shape = 0; shape < SHAPE_COUNT; shape++) {
+            for (int i = 0; i < frame_counts[shape]; i++) {
+                Instance *instance = &frame_instances[shape][i];
+                if (instance->size == 0.0f) {
+                    continue; // Free group slot
+                }
+                glColor3f(instance->r, instance->g, instance->b);
+                glBegin(GL_TRIANGLE_FAN);
+                for (int v = mesh_first[shape]; v < mesh_first[shape] + mesh_count[shape]; v++) {
+                    glVertex2f(instance->x + mesh_vertices[v][0] * instance->size,
+                               instance->y + mesh_vertices[v][1] * instance->size);
+                }
+                glEnd();
+            }
+        }
+        return;
+    }
+
+    glUseProgram(instance_program);
+    glBindBuffer(GL_ARRAY_BUFFER, mesh_buffer);
+    glEnableVertexAttribArray(ATTRIB_VERTEX);
+    glVertexAttribPointer(ATTRIB_VERTEX, 2, GL_FLOAT, GL_FALSE, 0, NULL);
+
+    // Grid lines use constant instance attributes
+    glVertexAttrib2f(ATTRIB_OFFSET, 0.0f, 0.0f);
+    glVertexAttrib1f(ATTRIB_SIZE, 1.0f);
+    glVertexAttrib3f(ATTRIB_COLOR, 0.2f, 0.2f, 0.2f); // Dark gray grid lines
+    glLineWidth(0.5f);
+    glDrawArrays(GL_LINES, grid_first, grid_count);
+
+    // Entities: per-instance attributes advance once per instance
+    glEnableVertexAttribArray(ATTRIB_OFFSET);
+    glEnableVertexAttribArray(ATTRIB_SIZE);
+    glEnableVertexAttribArray(ATTRIB_COLOR);
+    glVertexAttribDivisor(ATTRIB_OFFSET, 1);
+    glVertexAttribDivisor(ATTRIB_SIZE, 1);
+    glVertexAttribDivisor(ATTRIB_COLOR, 1);
+    for (int shape = 0; shape < SHAPE_COUNT; shape++) {
+        draw_instances(shape);
+    }
+    glVertexAttribDivisor(ATTRIB_OFFSET, 0);
+    glVertexAttribDivisor(ATTRIB_SIZE, 0);
+    glVertexAttribDivisor(ATTRIB_COLOR, 0);
+    glDisableVertexAttribArray(ATTRIB_OFFSET);
+    glDisableVertexAttribArray(ATTRIB_SIZE);
+    glDisableVertexAttribArray(ATTRIB_COLOR);
+    glDisableVertexAttribArray(ATTRIB_VERTEX);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glUseProgram(0);
 }
 
 // Display callback for GLUT
@@ -61,6 +469,7 @@ void display_callback() {
     if (global_shared_data == NULL) {
         return;
     }
+    double frame_start = now_ms();
 
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
     glLoadIdentity();
@@ -75,69 +484,9 @@ void display_callback() {
     gluOrtho2D(-100.0, 100.0, -100.0, 100.0); // Expanded coordinate system
     glMatrixMode(GL_MODELVIEW);
 
-    // Draw background grid
-    glColor3f(0.2f, 0.2f, 0.2f); // Dark gray grid lines
-    glLineWidth(0.5f);
-    glBegin(GL_LINES);
-        for(int i = -100; i <= 100; i += 10) {
-            // Vertical lines
-            glVertex2f(i, -100.0f);
-            glVertex2f(i, 100.0f);
-            // Horizontal lines
-            glVertex2f(-100.0f, i);
-            glVertex2f(100.0f, i);
-        }
-    glEnd();
-
-    // Draw Resistance Groups
-    sem_wait(&global_shared_data->group_semaphore);
-    for (int i = 0; i < global_shared_data->resistance_groups_count; i++) {
-        ResistanceGroup group = global_shared_data->resistance_groups[i];
-        if (group.has_spy) {
-            draw_circle(group.x, group.y, 5.0f, 1.0f, 0.0f, 0.0f); // Red for groups with spies
-        } else if (group.is_military) {
-            draw_circle(group.x, group.y, 5.0f, 0.0f, 0.0f, 1.0f); // Blue for military groups
-        } else {
-            draw_circle(group.x, group.y, 5.0f, 0.0f, 1.0f, 0.0f); // Green for social groups
-        }
-    }
-    sem_post(&global_shared_data->group_semaphore);
-
-    // Draw Agency Members
-    sem_wait(&global_shared_data->semaphore);
-    for (int i = 0; i < global_shared_data->current_agency_members && i < MAX_AGENCY_MEMBERS; i++) {
-        float x = global_shared_data->agency_positions[i][0];
-        float y = global_shared_data->agency_positions[i][1];
-        draw_agency_member(x, y, 3.0f, 1.0f, 1.0f, 0.0f); // Yellow diamonds
-    }
-    sem_post(&global_shared_data->semaphore);
-
-    // Draw Caught Resistance Members
-    sem_wait(&global_shared_data->semaphore);
-    for (int i = 0; i < global_shared_data->caught_resistance_positions_count && i < MAX_CAUGHT_RESISTANCE; i++) {
-        float x = global_shared_data->caught_resistance_positions[i][0];
-        float y = global_shared_data->caught_resistance_positions[i][1];
-        glColor3f(0.5f, 0.0f, 0.5f); // Purple
-        glBegin(GL_QUADS);
-            glVertex2f(x - 1.0f, y - 1.0f);
-            glVertex2f(x + 1.0f, y - 1.0f);
-            glVertex2f(x + 1.0f, y + 1.0f);
-            glVertex2f(x - 1.0f, y + 1.0f);
-        glEnd();
-    }
-
-    // Draw Caught Agency Members
-    for (int i = 0; i < global_shared_data->caught_agency_positions_count && i < MAX_CAUGHT_AGENCY; i++) {
-        float x = global_shared_data->caught_agency_positions[i][0];
-        float y = global_shared_data->caught_agency_positions[i][1];
-        glColor3f(1.0f, 0.0f, 1.0f); // Magenta
-        glBegin(GL_TRIANGLES);
-            glVertex2f(x, y + 1.0f);
-            glVertex2f(x - 1.0f, y - 1.0f);
-            glVertex2f(x + 1.0f, y - 1.0f);
-        glEnd();
-    }
-    sem_post(&global_shared_data->semaphore);
+    // Take the newest snapshot, then draw grid, groups, agents and casualties from it
+    build_frame(global_shared_data);
+    draw_map();
 
     // Reset to default viewport for scoreboard (right 30%)
     int sb_x = sim_width;
@@ -174,16 +523,15 @@ void display_callback() {
     start_y -= line_height;
     char buffer[256];
     
-    sem_wait(&global_shared_data->semaphore);
-    sprintf(buffer, "Killed: %d", global_shared_data->killed_resistance);
+    sprintf(buffer, "Killed: %d", frame_counters.killed_resistance);
     draw_text(start_x + 20.0f, start_y, buffer, 1.0f, 0.0f, 0.0f);
     start_y -= line_height;
 
-    sprintf(buffer, "Injured: %d", global_shared_data->injured_resistance);
+    sprintf(buffer, "Injured: %d", frame_counters.injured_resistance);
     draw_text(start_x + 20.0f, start_y, buffer, 1.0f, 0.5f, 0.0f);
     start_y -= line_height;
 
-    sprintf(buffer, "Caught: %d", global_shared_data->caught_resistance);
+    sprintf(buffer, "Caught: %d", frame_counters.caught_resistance);
     draw_text(start_x + 20.0f, start_y, buffer, 1.0f, 0.5f, 0.0f);
     start_y -= (line_height * 1.5f);
 
@@ -191,15 +539,15 @@ void display_callback() {
     draw_text(start_x, start_y, "Agency Statistics:", 1.0f, 1.0f, 0.0f);
     start_y -= line_height;
     
-    sprintf(buffer, "Killed: %d", global_shared_data->killed_agency);
+    sprintf(buffer, "Killed: %d", frame_counters.killed_agency);
     draw_text(start_x + 20.0f, start_y, buffer, 1.0f, 0.0f, 1.0f);
     start_y -= line_height;
 
-    sprintf(buffer, "Injured: %d", global_shared_data->injured_agency);
+    sprintf(buffer, "Injured: %d", frame_counters.injured_agency);
     draw_text(start_x + 20.0f, start_y, buffer, 1.0f, 0.5f, 1.0f);
     start_y -= line_height;
 
-    sprintf(buffer, "Caught: %d", global_shared_data->caught_agency);
+    sprintf(buffer, "Caught: %d", frame_counters.caught_agency);
     draw_text(start_x + 20.0f, start_y, buffer, 1.0f, 0.5f, 1.0f);
     start_y -= (line_height * 1.5f);
 
@@ -207,32 +555,59 @@ void display_callback() {
     draw_text(start_x, start_y, "Arrests:", 0.0f, 0.0f, 1.0f);
     start_y -= line_height;
     
-    sprintf(buffer, "Total Arrests: %d", global_shared_data->total_arrests);
+    sprintf(buffer, "Total Arrests: %d", frame_counters.total_arrests);
     draw_text(start_x + 20.0f, start_y, buffer, 0.0f, 1.0f, 1.0f);
     start_y -= line_height;
 
-    sprintf(buffer, "Total Imprisoned: %d", global_shared_data->total_imprisoned);
+    sprintf(buffer, "Total Imprisoned: %d", frame_counters.total_imprisoned);
     draw_text(start_x + 20.0f, start_y, buffer, 0.0f, 1.0f, 1.0f);
     start_y -= line_height;
 
-    sprintf(buffer, "Total Released: %d", global_shared_data->total_released);
+    sprintf(buffer, "Total Released: %d", frame_counters.total_released);
     draw_text(start_x + 20.0f, start_y, buffer, 0.0f, 1.0f, 1.0f);
-    sem_post(&global_shared_data->semaphore);
 
     // Additional Statistics (optional)
     start_y -= (line_height * 1.5f);
-    sem_wait(&global_shared_data->semaphore);
-    sprintf(buffer, "Total Resistance Groups: %d", global_shared_data->total_resistance_groups);
+    sprintf(buffer, "Total Resistance Groups: %d", frame_counters.total_resistance_groups);
     draw_text(start_x, start_y, buffer, 1.0f, 1.0f, 1.0f);
-    sem_post(&global_shared_data->semaphore);
+
+    // Frame statistics
+    int entities = frame_counters.live_groups;
+    for (int shape = SHAPE_AGENT; shape < SHAPE_COUNT; shape++) {
+        entities += frame_counts[shape];
+    }
+    start_y -= line_height;
+    sprintf(buffer, "Frame: %.2f ms, %.0f fps", last_frame_ms, frames_per_second);
+    draw_text(start_x, start_y, buffer, 0.7f, 0.7f, 0.7f);
+    start_y -= line_height;
+    sprintf(buffer, "Entities drawn: %d", entities);
+    draw_text(start_x, start_y, buffer, 0.7f, 0.7f, 0.7f);
 
     // Refresh the window
+    double frame_end = now_ms();
+    last_frame_ms = frame_end - frame_start;
     glutSwapBuffers();
+
+    frames_this_second++;
+    if (frame_end - second_start_ms >= 1000.0) {
+        frames_per_second = frames_this_second * 1000.0 / (frame_end - second_start_ms);
+        frames_this_second = 0;
+        second_start_ms = frame_end;
+    }
 }
 
-// Idle callback for GLUT
-void idle_callback() {
+// Timer callback for GLUT: redraw at a fixed pace instead of as fast as possible
+void frame_timer(int value) {
+    (void)value;
     glutPostRedisplay();
+
+    // Aim at the next frame boundary; after a stall, restart the pace instead of catching up
+    double now = now_ms();
+    next_frame_ms += FRAME_INTERVAL_MS;
+    if (next_frame_ms < now) {
+        next_frame_ms = now;
+    }
+    glutTimerFunc((unsigned int)(next_frame_ms - now), frame_timer, 0);
 }
 
 // Function to initialize OpenGL
@@ -250,9 +625,15 @@ int init_opengl(int argc, char **argv) {
 
     glClearColor(0.05f, 0.05f, 0.05f, 1.0f); // Slightly lighter black background
 
+    // Shapes and grid lines are built once; entities are drawn as instances of them
+    build_meshes();
+    init_instancing();
+
     // Register callbacks
     glutDisplayFunc(display_callback);
-    glutIdleFunc(idle_callback);
+    next_frame_ms = now_ms();
+    second_start_ms = next_frame_ms;
+    glutTimerFunc(FRAME_INTERVAL_MS, frame_timer, 0);
 
     return 0;
 }
@@ -1,13 +1,34 @@
 // calculator.c
 #include "shared_memory.h"
 #include "config.h"
+#include "journal.h"
+#include "file_io.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <unistd.h>
+#include <fcntl.h>
 #include <time.h>
 #include <sys/stat.h>
 #include <signal.h>
+#include <dirent.h>
+
+#define STREAM_POLL_US 20000 // How often a streaming read checks for new rows
+#define CATCHUP_CHECK_LINES 256 // Lines parsed between preemption checks in the catch-up lane
+
+// Per-file column statistics
+typedef struct {
+    int num_columns;
+    int header_done;
+    float sum[MAX_COLUMNS];
+    int count[MAX_COLUMNS];
+} ColumnStats;
+
+// Shared state
+SharedMemory *shared_data = NULL;
+sem_t *sem = NULL;
+Config config;
+int calculator_id = 0;
 
 // Function prototypes
 void handle_signal(int sig);
@@ -19,13 +40,374 @@ void handle_signal(int sig) {
     exit(0);
 }
 
+// Function to build the path of a file in one of the home directories
+void csv_path(char *path, size_t size, const char *dir, int file_index) {
+    snprintf(path, size, "%s/%d%s", dir, file_index, compress_extension(config.compression));
+}
+
+// CPU time used by this process in milliseconds
+long cpu_ms() {
+    struct timespec now;
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &now);
+    return (long)now.tv_sec * 1000 + now.tv_nsec / 1000000;
+}
+
+// Milliseconds since the epoch
+long now_ms() {
+    struct timespec now;
+    clock_gettime(CLOCK_REALTIME, &now);
+    return (long)now.tv_sec * 1000 + now.tv_nsec / 1000000;
+}
+
+// Function to claim the waiting file with the earliest deadline. Returns its index or -1;
+// *arrival_ms receives its arrival time, or -1 if unknown.
+int claim_next_file(long *arrival_ms) {
+    sem_wait(sem);
+    int file_index = file_earliest_deadline(shared_data);
+    if (file_index != -1) {
+        *arrival_ms = file_arrival_ms(shared_data, file_index);
+        file_try_claim(shared_data, file_index, calculator_id);
+        sem_post(sem);
+        return file_index;
+    }
+
+    // Fall back to files that never entered the claim table (e.g. requeued by journal recovery)
+    for (int i = 0; i < shared_data->files_generated; i++) {
+        char filepath[MAX_FILENAME];
+        csv_path(filepath, sizeof(filepath), "./home", i);
+        struct stat st;
+        if (stat(filepath, &st) == 0 && file_try_claim(shared_data, i, calculator_id) == 0) {
+            *arrival_ms = (long)st.st_mtime * 1000;
+            sem_post(sem);
+            return i;
+        }
+    }
+    sem_post(sem);
+    return -1;
+}
+
+// Function to fold one CSV line into the column statistics (the first line is the header)
+void parse_csv_line(char *line, ColumnStats *stats) {
+    if (!stats->header_done) {
+        // Read header to determine number of columns
+        char *token = strtok(line, ",");
+        while (token != NULL && stats->num_columns < MAX_COLUMNS) {
+            stats->num_columns++;
+            token = strtok(NULL, ",");
+        }
+        stats->header_done = 1;
+        return;
+    }
+
+    char *token = strtok(line, ",");
+    int col = 0;
+    while (token != NULL && col < stats->num_columns) {
+        if (token[0] != '\0') {
+            stats->sum[col] += atof(token);
+            stats->count[col]++;
+        }
+        token = strtok(NULL, ",");
+        col++;
+    }
+}
+
+// Line action for csv_read_lines
+int parse_line_action(char *line, void *arg) {
+    parse_csv_line(line, (ColumnStats *)arg);
+    return 0;
+}
+
+// Catch-up line action: stops the read as soon as fresh work is queued
+typedef struct {
+    ColumnStats stats;
+    long lines;
+} CatchupParse;
+
+int catchup_line_action(char *line, void *arg) {
+    CatchupParse *parse = arg;
+    parse_csv_line(line, &parse->stats);
+    return ++parse->lines % CATCHUP_CHECK_LINES == 0 && file_queue_has_work(shared_data);
+}
+
+// Function to read and parse a whole file with the configured I/O mode, logging read throughput.
+// Returns 0 when done, 1 if action stopped early and -1 on error.
+int read_csv_file(const char *path, CsvLineAction action, void *arg) {
+    long start = now_ms();
+    long cpu_start = cpu_ms();
+    CsvReadStats stats;
+    int result = csv_read_lines(path, config.io_mode, action, arg, &stats);
+    if (result == 0) {
+        long elapsed = now_ms() - start;
+        printf("Calculator %d: Read %s, %ld KiB in %ld ms (%.1f MB/s, %s I/O)\n", calculator_id, path,
+               stats.bytes_read / 1024, elapsed, elapsed > 0 ? stats.bytes_read / 1000.0 / elapsed : 0.0,
+               io_mode_name(config.io_mode));
+        if (stats.bytes_decoded != stats.bytes_read) {
+            printf("Calculator %d: Decoded %s to %ld KiB using %ld ms CPU\n", calculator_id, path,
+                   stats.bytes_decoded / 1024, cpu_ms() - cpu_start);
+        }
+    }
+    return result;
+}
+
+// Function to publish a file's column averages to shared memory
+void publish_averages(const char *path, const ColumnStats *stats) {
+    sem_wait(sem);
+    for (int c = 0; c < stats->num_columns; c++) {
+        if (stats->count[c] > 0) {
+            float avg = stats->sum[c] / stats->count[c];
+            shared_data->averages[c] = avg;
+
+            if (avg < shared_data->min_averages[c]) {
+                shared_data->min_averages[c] = avg;
+            }
+            if (avg > shared_data->max_averages[c]) {
+                shared_data->max_averages[c] = avg;
+            }
+
+            printf("Calculator %d: File %s - Column %d Average: %.2f (Min: %.2f, Max: %.2f)\n",
+                   calculator_id, path, c, avg, shared_data->min_averages[c], shared_data->max_averages[c]);
+        }
+    }
+    sem_post(sem);
+}
+
+// Function to claim a file the generator is still writing. Returns the slot or NULL.
+StreamSlot *claim_stream() {
+    StreamSlot *claimed = NULL;
+    sem_wait(sem);
+    for (int i = 0; i < MAX_STREAMS; i++) {
+        StreamSlot *slot = &shared_data->streams[i];
+        if (slot->state == STREAM_WRITING && slot->claimed_by == -1) {
+            slot->claimed_by = calculator_id;
+            shared_data->files_processed++;
+            claimed = slot;
+            break;
+        }
+    }
+    sem_post(sem);
+    return claimed;
+}
+
+// Function to parse a file while it is being generated, consuming only committed rows
+void process_stream(StreamSlot *slot) {
+    int file_index = slot->file_index;
+    char stream_path[MAX_FILENAME];
+    csv_path(stream_path, sizeof(stream_path), "./home/.inprogress", file_index);
+    journal_append(JOURNAL_CLAIMED, file_index, calculator_id);
+    printf("Calculator %d: Streaming file %s\n", calculator_id, stream_path);
+
+    // Simulate processing time
+    sleep(2); // Simulate processing delay
+
+    // The generator may not have created the file yet
+    int fd;
+    while ((fd = open(stream_path, O_RDONLY)) == -1 && !__atomic_load_n(&slot->complete, __ATOMIC_ACQUIRE)) {
+        usleep(STREAM_POLL_US);
+    }
+    if (fd == -1) {
+        int failed = __atomic_load_n(&slot->failed, __ATOMIC_ACQUIRE);
+        if (failed)
+            printf("Calculator %d: Dropped file %s, its generator failed to write it\n", calculator_id, stream_path);
+        else
+            perror("Error opening streaming file for reading");
+        sem_wait(sem);
+        if (failed)
+            shared_data->files_processed--;
+        slot->state = STREAM_FREE;
+        sem_post(sem);
+        return;
+    }
+
+    // Compressed files are decoded as the watermark advances; any prefix of a frame decodes
+    ColumnStats stats = {0};
+    CsvLineSplitter splitter;
+    if (csv_splitter_open(&splitter, config.compression, parse_line_action, &stats) == -1) {
+        close(fd);
+        sem_wait(sem);
+        slot->state = STREAM_FREE;
+        sem_post(sem);
+        return;
+    }
+    char buffer[65536];
+    long consumed = 0;
+    while (1) {
+        // complete is published after the final watermark, so read it first
+        int complete = __atomic_load_n(&slot->complete, __ATOMIC_ACQUIRE);
+        long committed = __atomic_load_n(&slot->committed_bytes, __ATOMIC_ACQUIRE);
+
+        if (consumed >= committed) {
+            if (complete)
+                break;
+            usleep(STREAM_POLL_US);
+            continue;
+        }
+
+        size_t want = sizeof(buffer);
+        if ((long)want > committed - consumed)
+            want = committed - consumed;
+        ssize_t bytes = read(fd, buffer, want);
+        if (bytes <= 0) {
+            perror("Error reading streaming file");
+            break;
+        }
+        consumed += bytes;
+
+        // Parse every complete line; a partial one waits for the next read
+        if (csv_splitter_feed(&splitter, buffer, bytes) == -1)
+            break;
+    }
+    csv_splitter_close(&splitter);
+    close(fd);
+
+    // The generator failed and removed the file: what was parsed is not a whole file
+    if (__atomic_load_n(&slot->failed, __ATOMIC_ACQUIRE)) {
+        printf("Calculator %d: Dropped file %s, its generator failed to write it\n", calculator_id, stream_path);
+        sem_wait(sem);
+        shared_data->files_processed--;
+        slot->state = STREAM_FREE;
+        sem_post(sem);
+        return;
+    }
+
+    publish_averages(stream_path, &stats);
+
+    // The generator left finalisation to us: move straight to Processed and free the slot
+    char processed_path[MAX_FILENAME];
+    csv_path(processed_path, sizeof(processed_path), "./home/Processed", file_index);
+    if (rename(stream_path, processed_path) == 0) {
+        journal_append(JOURNAL_PROCESSED, file_index, calculator_id);
+        long latency_ms = now_ms() - slot->started_ms;
+        sem_wait(sem);
+        shared_data->files_moved_to_processed++;
+        sem_post(sem);
+        printf("Calculator %d: Moved file %s to Processed (%ld ms after generation started)\n",
+               calculator_id, processed_path, latency_ms);
+    } else {
+        perror("Error moving file to Processed");
+    }
+
+    sem_wait(sem);
+    slot->state = STREAM_FREE;
+    sem_post(sem);
+}
+
+// Function to take the oldest file out of UnProcessed. Returns its index or -1;
+// name receives its file name, which keeps the format it was generated in.
+int claim_catchup_file(char *name, size_t name_size) {
+    DIR *dir = opendir("./home/UnProcessed");
+    if (dir == NULL) {
+        perror("Error opening UnProcessed directory");
+        return -1;
+    }
+
+    // Oldest by modification time (kept across renames), lowest index on ties
+    int oldest = -1;
+    time_t oldest_mtime = 0;
+    struct dirent *entry;
+    while ((entry = readdir(dir)) != NULL) {
+        if (entry->d_type == DT_DIR || !is_csv_name(entry->d_name))
+            continue;
+        struct stat st;
+        if (fstatat(dirfd(dir), entry->d_name, &st, 0) == -1)
+            continue;
+        int idx = atoi(entry->d_name);
+        if (oldest == -1 || st.st_mtime < oldest_mtime || (st.st_mtime == oldest_mtime && idx < oldest)) {
+            oldest = idx;
+            oldest_mtime = st.st_mtime;
+            snprintf(name, name_size, "%s", entry->d_name);
+        }
+    }
+    closedir(dir);
+    if (oldest == -1)
+        return -1;
+
+    // Another idle calculator may have taken it first
+    char unprocessed_path[MAX_FILENAME];
+    char temp_path[MAX_FILENAME];
+    snprintf(unprocessed_path, sizeof(unprocessed_path), "./home/UnProcessed/%s", name);
+    snprintf(temp_path, sizeof(temp_path), "./home/Processing/%s", name);
+    if (rename(unprocessed_path, temp_path) != 0)
+        return -1;
+    return oldest;
+}
+
+// Function to sleep for ms milliseconds unless fresh work arrives. Returns 0 if it did.
+int sleep_unless_preempted(int ms) {
+    for (int waited = 0; waited < ms; waited += 100) {
+        if (file_queue_has_work(shared_data))
+            return 0;
+        usleep(100000);
+    }
+    return !file_queue_has_work(shared_data);
+}
+
+// Function to process a file from UnProcessed at low priority. The file goes back to
+// UnProcessed as soon as fresh work appears in the main queue.
+void process_catchup(int file_index, const char *name) {
+    char temp_path[MAX_FILENAME];
+    snprintf(temp_path, sizeof(temp_path), "./home/Processing/%s", name);
+    printf("Calculator %d: Catching up on %s\n", calculator_id, temp_path);
+
+    // Simulate processing time
+    int finished = sleep_unless_preempted(2000);
+
+    CatchupParse parse = {0};
+    int result = finished ? read_csv_file(temp_path, catchup_line_action, &parse) : 1;
+    if (result == -1) {
+        // Back in UnProcessed it would be the oldest again on every idle moment: set it aside instead
+        char backup_path[MAX_FILENAME];
+        snprintf(backup_path, sizeof(backup_path), "./home/Backup/%s", name);
+        if (rename(temp_path, backup_path) != 0) {
+            perror("Error moving unreadable file to Backup");
+            return;
+        }
+        journal_append(JOURNAL_MOVED_BACKUP, file_index, calculator_id);
+        sem_wait(sem);
+        shared_data->files_moved_to_backup++;
+        shared_data->catchup_failures++;
+        sem_post(sem);
+        printf("Calculator %d: Catch-up could not read file %d, moved it to Backup\n", calculator_id, file_index);
+        return;
+    }
+    finished = result == 0;
+
+    if (!finished) {
+        char unprocessed_path[MAX_FILENAME];
+        snprintf(unprocessed_path, sizeof(unprocessed_path), "./home/UnProcessed/%s", name);
+        if (rename(temp_path, unprocessed_path) != 0) {
+            perror("Error returning file to UnProcessed");
+        }
+        sem_wait(sem);
+        shared_data->catchup_preemptions++;
+        sem_post(sem);
+        printf("Calculator %d: Catch-up on file %d preempted by fresh work\n", calculator_id, file_index);
+        return;
+    }
+
+    publish_averages(temp_path, &parse.stats);
+
+    char processed_path[MAX_FILENAME];
+    snprintf(processed_path, sizeof(processed_path), "./home/Processed/%s", name);
+    if (rename(temp_path, processed_path) == 0) {
+        journal_append(JOURNAL_CAUGHT_UP, file_index, calculator_id);
+        sem_wait(sem);
+        shared_data->files_processed++;
+        shared_data->files_moved_to_processed++;
+        shared_data->files_recovered++;
+        sem_post(sem);
+        printf("Calculator %d: Recovered file %s from UnProcessed\n", calculator_id, processed_path);
+    } else {
+        perror("Error moving file to Processed");
+    }
+}
+
 int main(int argc, char *argv[]) {
     if (argc != 2) {
         fprintf(stderr, "Usage: %s <calculator_id>\n", argv[0]);
         exit(1);
     }
 
-    int calculator_id = atoi(argv[1]);
+    calculator_id = atoi(argv[1]);
 
     // Register signal handlers
     if (signal(SIGTERM, handle_signal) == SIG_ERR) {
@@ -38,110 +420,77 @@ int main(int argc, char *argv[]) {
     }
 
     // Initialize shared memory and semaphore
-    SharedMemory *shared_data = init_shared_memory();
-    sem_t *sem = init_semaphore();
+    shared_data = init_shared_memory();
+    sem = init_semaphore();
 
     // Read configuration
-    Config config;
     parse_config("config.txt", &config);
 
-    while (1) {
-        // Search for an unprocessed file in the home directory
-        char filepath[MAX_FILENAME];
-        int file_found = 0;
-        int file_index = -1; // To store the index of the found file
+    // Lifecycle events are appended to the shared journal
+    if (config.journal_enabled) {
+        journal_open(config.journal_path);
+    }
 
-        sem_wait(sem);
-        for (int i = 0; i < shared_data->files_generated; i++) {
-            snprintf(filepath, sizeof(filepath), "./home/%d.csv", i);
-            struct stat st;
-            if (stat(filepath, &st) == 0) {
-                // File exists and is unprocessed
-                file_found = 1;
-                file_index = i; // Store the index
-                break;
-            }
-        }
-        sem_post(sem);
+    // Generators make the same check, so both sides agree on the file names
+    if (config.compression != COMPRESS_NONE && !compress_available(config.compression)) {
+        config.compression = COMPRESS_NONE;
+    }
 
-        if (file_found && file_index != -1) {
+    while (1) {
+        // Claim the unprocessed file in the home directory closest to its Inspector Type1 deadline
+        long arrival_ms = -1;
+        long claim_ms = now_ms();
+        int file_index = claim_next_file(&arrival_ms);
+
+        if (file_index != -1) {
             // Mark file as being processed by moving it to Processing directory
+            char filepath[MAX_FILENAME];
             char temp_path[MAX_FILENAME];
-            snprintf(temp_path, sizeof(temp_path), "./home/Processing/%d.csv", file_index);
-            if (rename(filepath, temp_path) == 0) {
-                sem_wait(sem);
-                shared_data->files_processed++;
-                sem_post(sem);
-                printf("Calculator %d: Processing file %s\n", calculator_id, temp_path);
-            } else {
+            csv_path(filepath, sizeof(filepath), "./home", file_index);
+            csv_path(temp_path, sizeof(temp_path), "./home/Processing", file_index);
+            int moved = rename(filepath, temp_path) == 0;
+            if (!moved) {
                 perror("Error moving file to Processing");
+            }
+
+            // Out of ./home, so the claim marker is no longer needed
+            long slack_ms = arrival_ms + config.type1_threshold_age * 1000L - claim_ms;
+            sem_wait(sem);
+            file_release(shared_data, file_index);
+            if (moved) {
+                shared_data->files_processed++;
+                if (arrival_ms >= 0)
+                    record_deadline_slack(shared_data, slack_ms);
+            }
+            sem_post(sem);
+            if (!moved) {
                 continue;
             }
 
+            journal_append(JOURNAL_CLAIMED, file_index, calculator_id);
+            if (arrival_ms >= 0) {
+                printf("Calculator %d: Processing file %s (%ld ms before its deadline)\n", calculator_id, temp_path, slack_ms);
+            } else {
+                printf("Calculator %d: Processing file %s\n", calculator_id, temp_path);
+            }
+
             // Simulate processing time
             sleep(2); // Simulate processing delay
 
             // Calculate averages
-            FILE *file = fopen(temp_path, "r");
-            if (file == NULL) {
-                perror("Error opening file for reading");
+            ColumnStats stats = {0};
+            if (read_csv_file(temp_path, parse_line_action, &stats) == -1) {
                 continue;
             }
 
-            char line[1024];
-            int num_columns = 0;
-            float sum[MAX_COLUMNS] = {0.0};
-            int count[MAX_COLUMNS] = {0};
-
-            // Read header to determine number of columns
-            if (fgets(line, sizeof(line), file)) {
-                char *token = strtok(line, ",");
-                while (token != NULL && num_columns < MAX_COLUMNS) {
-                    num_columns++;
-                    token = strtok(NULL, ",");
-                }
-            }
-
-            // Read data lines
-            while (fgets(line, sizeof(line), file)) {
-                char *token = strtok(line, ",");
-                int col = 0;
-                while (token != NULL && col < num_columns) {
-                    if (token[0] != '\0') {
-                        sum[col] += atof(token);
-                        count[col]++;
-                    }
-                    token = strtok(NULL, ",");
-                    col++;
-                }
-            }
-
-            fclose(file);
-
             // Update shared memory with averages
-            sem_wait(sem);
-            for (int c = 0; c < num_columns; c++) {
-                if (count[c] > 0) {
-                    float avg = sum[c] / count[c];
-                    shared_data->averages[c] = avg;
-
-                    if (avg < shared_data->min_averages[c]) {
-                        shared_data->min_averages[c] = avg;
-                    }
-                    if (avg > shared_data->max_averages[c]) {
-                        shared_data->max_averages[c] = avg;
-                    }
-
-                    printf("Calculator %d: File %s - Column %d Average: %.2f (Min: %.2f, Max: %.2f)\n",
-                           calculator_id, temp_path, c, avg, shared_data->min_averages[c], shared_data->max_averages[c]);
-                }
-            }
-            sem_post(sem);
+            publish_averages(temp_path, &stats);
 
             // Move file to Processed directory
             char processed_path[MAX_FILENAME];
-            snprintf(processed_path, sizeof(processed_path), "./home/Processed/%d.csv", file_index);
+            csv_path(processed_path, sizeof(processed_path), "./home/Processed", file_index);
             if (rename(temp_path, processed_path) == 0) {
+                journal_append(JOURNAL_PROCESSED, file_index, calculator_id);
                 sem_wait(sem);
                 shared_data->files_moved_to_processed++;
                 sem_post(sem);
@@ -149,6 +498,30 @@ int main(int argc, char *argv[]) {
             } else {
                 perror("Error moving file to Processed");
             }
+            continue;
+        }
+
+        // Nothing complete is waiting: start on a file that is still being generated
+        if (config.streaming_enabled) {
+            StreamSlot *slot = claim_stream();
+            if (slot != NULL) {
+                process_stream(slot);
+                continue;
+            }
+        }
+
+        // Still idle: reprocess what Inspector Type1 gave up on
+        if (config.catchup_enabled) {
+            char catchup_name[MAX_FILENAME];
+            int catchup_index = claim_catchup_file(catchup_name, sizeof(catchup_name));
+            if (catchup_index != -1) {
+                process_catchup(catchup_index, catchup_name);
+                continue;
+            }
+        }
+
+        if (config.streaming_enabled) {
+            usleep(STREAM_POLL_US * 10);
         } else {
             // No file found, sleep for a while
             sleep(2);
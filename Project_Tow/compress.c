@@ -0,0 +1,383 @@
+// compress.c
+#include "compress.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <dlfcn.h>
+
+// liblz4 and libzstd are loaded at runtime so the build needs neither their headers nor
+// their development packages. Only the stable frame and streaming APIs are declared here.
+
+#define LZ4F_VERSION 100
+#define LZ4_CHUNK_SIZE (64 * 1024) // Input fed to LZ4F_compressUpdate per call
+#define ZSTD_C_COMPRESSION_LEVEL 100
+
+// LZ4F_preferences_t (lz4frame.h, stable since 1.8)
+typedef struct {
+    int block_size_id;
+    int block_mode;
+    int content_checksum_flag;
+    int frame_type;
+    unsigned long long content_size;
+    unsigned dict_id;
+    int block_checksum_flag;
+} Lz4FrameInfo;
+
+typedef struct {
+    Lz4FrameInfo frame_info;
+    int compression_level;
+    unsigned auto_flush;
+    unsigned favor_dec_speed;
+    unsigned reserved[3];
+} Lz4Preferences;
+
+// ZSTD_inBuffer and ZSTD_outBuffer (zstd.h)
+typedef struct {
+    const void *src;
+    size_t size;
+    size_t pos;
+} ZstdInBuffer;
+
+typedef struct {
+    void *dst;
+    size_t size;
+    size_t pos;
+} ZstdOutBuffer;
+
+static struct {
+    int loaded; // 0 = not tried, 1 = available, -1 = missing
+    unsigned (*is_error)(size_t code);
+    const char *(*error_name)(size_t code);
+    size_t (*create_cctx)(void **cctx, unsigned version);
+    size_t (*free_cctx)(void *cctx);
+    size_t (*compress_bound)(size_t src_size, const Lz4Preferences *prefs);
+    size_t (*compress_begin)(void *cctx, void *dst, size_t capacity, const Lz4Preferences *prefs);
+    size_t (*compress_update)(void *cctx, void *dst, size_t capacity, const void *src, size_t src_size, const void *options);
+    size_t (*flush)(void *cctx, void *dst, size_t capacity, const void *options);
+    size_t (*compress_end)(void *cctx, void *dst, size_t capacity, const void *options);
+    size_t (*create_dctx)(void **dctx, unsigned version);
+    size_t (*free_dctx)(void *dctx);
+    size_t (*decompress)(void *dctx, void *dst, size_t *dst_size, const void *src, size_t *src_size, const void *options);
+} lz4;
+
+static struct {
+    int loaded;
+    unsigned (*is_error)(size_t code);
+    const char *(*error_name)(size_t code);
+    void *(*create_cctx)(void);
+    size_t (*free_cctx)(void *cctx);
+    size_t (*set_parameter)(void *cctx, int parameter, int value);
+    size_t (*compress_stream2)(void *cctx, ZstdOutBuffer *output, ZstdInBuffer *input, int directive);
+    size_t (*cstream_out_size)(void);
+    void *(*create_dctx)(void);
+    size_t (*free_dctx)(void *dctx);
+    size_t (*decompress_stream)(void *dctx, ZstdOutBuffer *output, ZstdInBuffer *input);
+    size_t (*dstream_out_size)(void);
+} zstd;
+
+struct Codec {
+    CompressFormat format;
+    int encoder;
+    void *context;
+    char *out;
+    size_t out_capacity;
+    size_t pending; // LZ4 frame header produced at open, emitted by the first encode call
+};
+
+// Function to resolve a symbol into a function pointer, counting failures
+static void resolve(void *library, const char *name, void *target, int *missing) {
+    void *symbol = dlsym(library, name);
+    if (symbol == NULL)
+        (*missing)++;
+    memcpy(target, &symbol, sizeof(symbol));
+}
+
+static int load_lz4() {
+    if (lz4.loaded)
+        return lz4.loaded;
+    lz4.loaded = -1;
+    void *library = dlopen("liblz4.so.1", RTLD_NOW | RTLD_LOCAL);
+    if (library == NULL) {
+        fprintf(stderr, "LZ4 unavailable: %s\n", dlerror());
+        return -1;
+    }
+    int missing = 0;
+    resolve(library, "LZ4F_isError", &lz4.is_error, &missing);
+    resolve(library, "LZ4F_getErrorName", &lz4.error_name, &missing);
+    resolve(library, "LZ4F_createCompressionContext", &lz4.create_cctx, &missing);
+    resolve(library, "LZ4F_freeCompressionContext", &lz4.free_cctx, &missing);
+    resolve(library, "LZ4F_compressBound", &lz4.compress_bound, &missing);
+    resolve(library, "LZ4F_compressBegin", &lz4.compress_begin, &missing);
+    resolve(library, "LZ4F_compressUpdate", &lz4.compress_update, &missing);
+    resolve(library, "LZ4F_flush", &lz4.flush, &missing);
+    resolve(library, "LZ4F_compressEnd", &lz4.compress_end, &missing);
+    resolve(library, "LZ4F_createDecompressionContext", &lz4.create_dctx, &missing);
+    resolve(library, "LZ4F_freeDecompressionContext", &lz4.free_dctx, &missing);
+    resolve(library, "LZ4F_decompress", &lz4.decompress, &missing);
+    if (missing > 0) {
+        fprintf(stderr, "LZ4 unavailable: %d frame API symbols missing\n", missing);
+        dlclose(library);
+        return -1;
+    }
+    lz4.loaded = 1;
+    return 1;
+}
+
+static int load_zstd() {
+    if (zstd.loaded)
+        return zstd.loaded;
+    zstd.loaded = -1;
+    void *library = dlopen("libzstd.so.1", RTLD_NOW | RTLD_LOCAL);
+    if (library == NULL) {
+        fprintf(stderr, "Zstandard unavailable: %s\n", dlerror());
+        return -1;
+    }
+    int missing = 0;
+    resolve(library, "ZSTD_isError", &zstd.is_error, &missing);
+    resolve(library, "ZSTD_getErrorName", &zstd.error_name, &missing);
+    resolve(library, "ZSTD_createCCtx", &zstd.create_cctx, &missing);
+    resolve(library, "ZSTD_freeCCtx", &zstd.free_cctx, &missing);
+    resolve(library, "ZSTD_CCtx_setParameter", &zstd.set_parameter, &missing);
+    resolve(library, "ZSTD_compressStream2", &zstd.compress_stream2, &missing);
+    resolve(library, "ZSTD_CStreamOutSize", &zstd.cstream_out_size, &missing);
+    resolve(library, "ZSTD_createDCtx", &zstd.create_dctx, &missing);
+    resolve(library, "ZSTD_freeDCtx", &zstd.free_dctx, &missing);
+    resolve(library, "ZSTD_decompressStream", &zstd.decompress_stream, &missing);
+    resolve(library, "ZSTD_DStreamOutSize", &zstd.dstream_out_size, &missing);
+    if (missing > 0) {
+        fprintf(stderr, "Zstandard unavailable: %d streaming API symbols missing\n", missing);
+        dlclose(library);
+        return -1;
+    }
+    zstd.loaded = 1;
+    return 1;
+}
+
+const char *compress_extension(CompressFormat format) {
+    switch (format) {
+        case COMPRESS_LZ4: return ".csv.lz4";
+        case COMPRESS_ZSTD: return ".csv.zst";
+        default: return ".csv";
+    }
+}
+
+// Format of a file from its name, or -1 if it is not a CSV file at all
+int compress_format_from_name(const char *name) {
+    size_t len = strlen(name);
+    for (int format = COMPRESS_FORMAT_COUNT - 1; format >= 0; format--) {
+        const char *extension = compress_extension(format);
+        size_t extension_len = strlen(extension);
+        if (len > extension_len && strcmp(name + len - extension_len, extension) == 0)
+            return format;
+    }
+    return -1;
+}
+
+// Whether a directory entry is a CSV file in any of the supported formats
+int is_csv_name(const char *name) {
+    return compress_format_from_name(name) != -1;
+}
+
+// Whether the library for a format can be loaded
+int compress_available(CompressFormat format) {
+    switch (format) {
+        case COMPRESS_LZ4: return load_lz4() == 1;
+        case COMPRESS_ZSTD: return load_zstd() == 1;
+        default: return 1;
+    }
+}
+
+static Codec *codec_alloc(CompressFormat format, int encoder, size_t out_capacity) {
+    Codec *codec = calloc(1, sizeof(Codec));
+    if (codec == NULL) {
+        perror("Error allocating codec");
+        return NULL;
+    }
+    codec->format = format;
+    codec->encoder = encoder;
+    codec->out_capacity = out_capacity;
+    codec->out = malloc(out_capacity);
+    if (codec->out == NULL) {
+        perror("Error allocating codec buffer");
+        free(codec);
+        return NULL;
+    }
+    return codec;
+}
+
+// Create an encoder; level follows each library's own scale (LZ4: 0-12, zstd: 1-19)
+Codec *codec_open_encoder(CompressFormat format, int level) {
+    if (format == COMPRESS_NONE || !compress_available(format))
+        return NULL;
+
+    if (format == COMPRESS_LZ4) {
+        Lz4Preferences prefs;
+        memset(&prefs, 0, sizeof(prefs));
+        prefs.compression_level = level;
+        Codec *codec = codec_alloc(format, 1, lz4.compress_bound(LZ4_CHUNK_SIZE, &prefs) + 64);
+        if (codec == NULL)
+            return NULL;
+        size_t result = lz4.create_cctx(&codec->context, LZ4F_VERSION);
+        if (!lz4.is_error(result))
+            result = lz4.compress_begin(codec->context, codec->out, codec->out_capacity, &prefs);
+        if (lz4.is_error(result)) {
+            fprintf(stderr, "Error starting LZ4 frame: %s\n", lz4.error_name(result));
+            codec_close(codec);
+            return NULL;
+        }
+        codec->pending = result;
+        return codec;
+    }
+
+    Codec *codec = codec_alloc(format, 1, zstd.cstream_out_size());
+    if (codec == NULL)
+        return NULL;
+    codec->context = zstd.create_cctx();
+    if (codec->context == NULL) {
+        fprintf(stderr, "Error creating Zstandard context\n");
+        codec_close(codec);
+        return NULL;
+    }
+    size_t result = zstd.set_parameter(codec->context, ZSTD_C_COMPRESSION_LEVEL, level);
+    if (zstd.is_error(result)) {
+        fprintf(stderr, "Error setting Zstandard level: %s\n", zstd.error_name(result));
+    }
+    return codec;
+}
+
+Codec *codec_open_decoder(CompressFormat format) {
+    if (format == COMPRESS_NONE || !compress_available(format))
+        return NULL;
+
+    if (format == COMPRESS_LZ4) {
+        Codec *codec = codec_alloc(format, 0, LZ4_CHUNK_SIZE);
+        if (codec == NULL)
+            return NULL;
+        size_t result = lz4.create_dctx(&codec->context, LZ4F_VERSION);
+        if (lz4.is_error(result)) {
+            fprintf(stderr, "Error creating LZ4 context: %s\n", lz4.error_name(result));
+            codec_close(codec);
+            return NULL;
+        }
+        return codec;
+    }
+
+    Codec *codec = codec_alloc(format, 0, zstd.dstream_out_size());
+    if (codec == NULL)
+        return NULL;
+    codec->context = zstd.create_dctx();
+    if (codec->context == NULL) {
+        fprintf(stderr, "Error creating Zstandard context\n");
+        codec_close(codec);
+        return NULL;
+    }
+    return codec;
+}
+
+// Compress data and pass the output to sink. Returns 0 on success and -1 on error.
+int codec_encode(Codec *codec, const char *data, size_t len, CodecDirective directive, CodecSink sink, void *arg) {
+    if (codec->format == COMPRESS_LZ4) {
+        if (codec->pending > 0) {
+            if (sink(codec->out, codec->pending, arg))
+                return -1;
+            codec->pending = 0;
+        }
+        while (len > 0) {
+            size_t chunk = len < LZ4_CHUNK_SIZE ? len : LZ4_CHUNK_SIZE;
+            size_t produced = lz4.compress_update(codec->context, codec->out, codec->out_capacity, data, chunk, NULL);
+            if (lz4.is_error(produced)) {
+                fprintf(stderr, "Error compressing LZ4 block: %s\n", lz4.error_name(produced));
+                return -1;
+            }
+            if (produced > 0 && sink(codec->out, produced, arg))
+                return -1;
+            data += chunk;
+            len -= chunk;
+        }
+        if (directive != CODEC_CONTINUE) {
+            size_t produced = directive == CODEC_END
+                ? lz4.compress_end(codec->context, codec->out, codec->out_capacity, NULL)
+                : lz4.flush(codec->context, codec->out, codec->out_capacity, NULL);
+            if (lz4.is_error(produced)) {
+                fprintf(stderr, "Error finishing LZ4 block: %s\n", lz4.error_name(produced));
+                return -1;
+            }
+            if (produced > 0 && sink(codec->out, produced, arg))
+                return -1;
+        }
+        return 0;
+    }
+
+    // ZSTD_e_continue, ZSTD_e_flush and ZSTD_e_end share CodecDirective's values
+    ZstdInBuffer input = { data, len, 0 };
+    while (1) {
+        ZstdOutBuffer output = { codec->out, codec->out_capacity, 0 };
+        size_t remaining = zstd.compress_stream2(codec->context, &output, &input, directive);
+        if (zstd.is_error(remaining)) {
+            fprintf(stderr, "Error compressing Zstandard stream: %s\n", zstd.error_name(remaining));
+            return -1;
+        }
+        if (output.pos > 0 && sink(codec->out, output.pos, arg))
+            return -1;
+        int done = directive == CODEC_CONTINUE ? input.pos == input.size : remaining == 0;
+        if (done)
+            return 0;
+    }
+}
+
+// Decompress data (any prefix of a frame) and pass the output to sink.
+// Returns 0 on success, 1 if sink stopped it and -1 on error.
+int codec_decode(Codec *codec, const char *data, size_t len, CodecSink sink, void *arg) {
+    if (codec->format == COMPRESS_LZ4) {
+        while (1) {
+            size_t produced = codec->out_capacity;
+            size_t consumed = len;
+            size_t hint = lz4.decompress(codec->context, codec->out, &produced, data, &consumed, NULL);
+            if (lz4.is_error(hint)) {
+                fprintf(stderr, "Error decompressing LZ4 frame: %s\n", lz4.error_name(hint));
+                return -1;
+            }
+            if (produced > 0 && sink(codec->out, produced, arg))
+                return 1;
+            data += consumed;
+            len -= consumed;
+            // Done once the input is used up and nothing more is held back for a full buffer
+            if (len == 0 && produced < codec->out_capacity)
+                return 0;
+            if (consumed == 0 && produced == 0)
+                return 0; // Frame finished; trailing bytes are ignored
+        }
+    }
+
+    ZstdInBuffer input = { data, len, 0 };
+    while (1) {
+        ZstdOutBuffer output = { codec->out, codec->out_capacity, 0 };
+        size_t hint = zstd.decompress_stream(codec->context, &output, &input);
+        if (zstd.is_error(hint)) {
+            fprintf(stderr, "Error decompressing Zstandard frame: %s\n", zstd.error_name(hint));
+            return -1;
+        }
+        if (output.pos > 0 && sink(codec->out, output.pos, arg))
+            return 1;
+        // A full output buffer may hide more decoded data even with the input consumed
+        if (input.pos == input.size && output.pos < output.size)
+            return 0;
+    }
+}
+
+void codec_close(Codec *codec) {
+    if (codec == NULL)
+        return;
+    if (codec->context != NULL) {
+        if (codec->format == COMPRESS_LZ4 && codec->encoder)
+            lz4.free_cctx(codec->context);
+        else if (codec->format == COMPRESS_LZ4)
+            lz4.free_dctx(codec->context);
+        else if (codec->encoder)
+            zstd.free_cctx(codec->context);
+        else
+            zstd.free_dctx(codec->context);
+    }
+    free(codec->out);
+    free(codec);
+}
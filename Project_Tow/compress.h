@@ -0,0 +1,38 @@
+// compress.h
+#ifndef COMPRESS_H
+#define COMPRESS_H
+
+#include <stddef.h>
+
+// On-disk format of a CSV file, chosen by its extension
+typedef enum {
+    COMPRESS_NONE = 0, // <n>.csv
+    COMPRESS_LZ4,      // <n>.csv.lz4, LZ4 frame format
+    COMPRESS_ZSTD,     // <n>.csv.zst, Zstandard frame format
+    COMPRESS_FORMAT_COUNT
+} CompressFormat;
+
+// How codec_encode treats the data passed so far
+typedef enum {
+    CODEC_CONTINUE = 0, // Buffer freely
+    CODEC_FLUSH,        // Make everything passed so far decodable
+    CODEC_END           // Finish the frame
+} CodecDirective;
+
+// Receives encoder or decoder output; returning non-zero aborts the call
+typedef int (*CodecSink)(char *data, size_t len, void *arg);
+
+typedef struct Codec Codec;
+
+// Function prototypes
+const char *compress_extension(CompressFormat format);
+int compress_format_from_name(const char *name);
+int is_csv_name(const char *name);
+int compress_available(CompressFormat format);
+Codec *codec_open_encoder(CompressFormat format, int level);
+Codec *codec_open_decoder(CompressFormat format);
+int codec_encode(Codec *codec, const char *data, size_t len, CodecDirective directive, CodecSink sink, void *arg);
+int codec_decode(Codec *codec, const char *data, size_t len, CodecSink sink, void *arg);
+void codec_close(Codec *codec);
+
+#endif // COMPRESS_H
@@ -1,5 +1,7 @@
 // config.c
 #include "config.h"
+#include "workload.h"
+#include "file_io.h"
 #include <stdio.h>
 #include <string.h>
 #include <stdlib.h>
@@ -26,6 +28,24 @@ void initialize_default_config(Config *config) {
     config->threshold_files_deleted = 100;
     config->runtime_limit_minutes = 60;
     config->type1_threshold_age = 10;
+    config->journal_enabled = 1;
+    strcpy(config->journal_path, "./home/journal.bin");
+    config->journal_sync_interval_ms = 200;
+    config->cpus_generators[0] = '\0';
+    config->cpus_calculators[0] = '\0';
+    config->cpus_inspectors[0] = '\0';
+    config->numa_generators[0] = '\0';
+    config->numa_calculators[0] = '\0';
+    config->numa_inspectors[0] = '\0';
+    config->numa_bind = 0;
+    config->workload_mode = WORKLOAD_LIVE;
+    strcpy(config->workload_file, "./workload.txt");
+    config->workload_speed = 1.0;
+    config->streaming_enabled = 0;
+    config->catchup_enabled = 1;
+    config->io_mode = IO_BUFFERED;
+    config->compression = COMPRESS_NONE;
+    config->compression_level = 1;
 }
 
 // Function to parse the configuration file
@@ -81,6 +101,66 @@ void parse_config(const char *filename, Config *config) {
             config->runtime_limit_minutes = atoi(value);
         else if (strcmp(key, "type1_threshold_age") == 0)
             config->type1_threshold_age = atoi(value);
+        else if (strcmp(key, "journal_enabled") == 0)
+            config->journal_enabled = atoi(value);
+        else if (strcmp(key, "journal_path") == 0)
+            snprintf(config->journal_path, sizeof(config->journal_path), "%s", value);
+        else if (strcmp(key, "journal_sync_interval_ms") == 0) {
+            // The supervisor sleeps this long between commits, so zero would make it spin
+            if (atoi(value) >= 1)
+                config->journal_sync_interval_ms = atoi(value);
+            else
+                fprintf(stderr, "Invalid journal_sync_interval_ms %s (must be at least 1), keeping %d\n",
+                        value, config->journal_sync_interval_ms);
+        }
+        else if (strcmp(key, "cpus_generators") == 0)
+            snprintf(config->cpus_generators, sizeof(config->cpus_generators), "%s", value);
+        else if (strcmp(key, "cpus_calculators") == 0)
+            snprintf(config->cpus_calculators, sizeof(config->cpus_calculators), "%s", value);
+        else if (strcmp(key, "cpus_inspectors") == 0)
+            snprintf(config->cpus_inspectors, sizeof(config->cpus_inspectors), "%s", value);
+        else if (strcmp(key, "numa_generators") == 0)
+            snprintf(config->numa_generators, sizeof(config->numa_generators), "%s", value);
+        else if (strcmp(key, "numa_calculators") == 0)
+            snprintf(config->numa_calculators, sizeof(config->numa_calculators), "%s", value);
+        else if (strcmp(key, "numa_inspectors") == 0)
+            snprintf(config->numa_inspectors, sizeof(config->numa_inspectors), "%s", value);
+        else if (strcmp(key, "numa_policy") == 0)
+            config->numa_bind = (strcmp(value, "bind") == 0);
+        else if (strcmp(key, "workload_mode") == 0) {
+            if (strcmp(value, "record") == 0)
+                config->workload_mode = WORKLOAD_RECORD;
+            else if (strcmp(value, "replay") == 0)
+                config->workload_mode = WORKLOAD_REPLAY;
+            else
+                config->workload_mode = WORKLOAD_LIVE;
+        }
+        else if (strcmp(key, "workload_file") == 0)
+            snprintf(config->workload_file, sizeof(config->workload_file), "%s", value);
+        else if (strcmp(key, "workload_speed") == 0)
+            config->workload_speed = atof(value);
+        else if (strcmp(key, "streaming_enabled") == 0)
+            config->streaming_enabled = atoi(value);
+        else if (strcmp(key, "catchup_enabled") == 0)
+            config->catchup_enabled = atoi(value);
+        else if (strcmp(key, "io_mode") == 0) {
+            if (strcmp(value, "direct") == 0)
+                config->io_mode = IO_DIRECT;
+            else if (strcmp(value, "dontneed") == 0)
+                config->io_mode = IO_DONTNEED;
+            else
+                config->io_mode = IO_BUFFERED;
+        }
+        else if (strcmp(key, "compression") == 0) {
+            if (strcmp(value, "lz4") == 0)
+                config->compression = COMPRESS_LZ4;
+            else if (strcmp(value, "zstd") == 0)
+                config->compression = COMPRESS_ZSTD;
+            else
+                config->compression = COMPRESS_NONE;
+        }
+        else if (strcmp(key, "compression_level") == 0)
+            config->compression_level = atoi(value);
     }
 
     fclose(file);
@@ -23,6 +23,25 @@ typedef struct {
     int threshold_files_deleted;
     int runtime_limit_minutes;
     int type1_threshold_age; // Age threshold for Type1 Inspectors in seconds
+    int journal_enabled; // Record file lifecycle events and replay them on startup
+    char journal_path[256];
+    int journal_sync_interval_ms; // Group commit interval of the supervisor
+    // Placement: CPU lists ("0-3,8") and NUMA node lists per stage, empty = unrestricted
+    char cpus_generators[64];
+    char cpus_calculators[64];
+    char cpus_inspectors[64];
+    char numa_generators[64];
+    char numa_calculators[64];
+    char numa_inspectors[64];
+    int numa_bind; // 1 = bind memory to the nodes, 0 = prefer the first node
+    int workload_mode; // WorkloadMode: live, record or replay
+    char workload_file[256];
+    float workload_speed; // Replay speed multiplier (2.0 = twice as fast)
+    int streaming_enabled; // Let calculators consume files while they are being generated
+    int catchup_enabled;   // Let idle calculators reprocess files from UnProcessed
+    int io_mode;           // IoMode: how generators write and calculators read CSV files
+    int compression;       // CompressFormat of generated files
+    int compression_level; // Library-specific level (LZ4: 0-12, zstd: 1-19)
 } Config;
 
 // Function prototype
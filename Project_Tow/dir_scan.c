@@ -0,0 +1,200 @@
+// dir_scan.c
+#define _GNU_SOURCE
+#include "dir_scan.h"
+#include "compress.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+
+#define DIR_SCAN_BUFFER_SIZE (1 << 20) // ~25k entries per getdents64 call
+#define DIR_SCAN_CACHE_INITIAL 1024
+
+// Record layout returned by getdents64
+struct linux_dirent64 {
+    uint64_t d_ino;
+    int64_t d_off;
+    unsigned short d_reclen;
+    unsigned char d_type;
+    char d_name[];
+};
+
+// Open a directory once and keep its descriptor for every later scan
+int dir_scanner_open(DirScanner *scanner, const char *path) {
+    memset(scanner, 0, sizeof(*scanner));
+    scanner->dir_fd = open(path, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (scanner->dir_fd == -1) {
+        perror("Error opening directory");
+        return -1;
+    }
+
+    scanner->buffer_size = DIR_SCAN_BUFFER_SIZE;
+    scanner->buffer = malloc(scanner->buffer_size);
+    scanner->cache_capacity = DIR_SCAN_CACHE_INITIAL;
+    scanner->cache = calloc(scanner->cache_capacity, sizeof(MtimeCacheEntry));
+    if (scanner->buffer == NULL || scanner->cache == NULL) {
+        perror("Error allocating directory scanner");
+        dir_scanner_close(scanner);
+        return -1;
+    }
+    return 0;
+}
+
+// Release the scanner's descriptor and buffers
+void dir_scanner_close(DirScanner *scanner) {
+    if (scanner->dir_fd != -1)
+        close(scanner->dir_fd);
+    free(scanner->buffer);
+    free(scanner->cache);
+    scanner->dir_fd = -1;
+    scanner->buffer = NULL;
+    scanner->cache = NULL;
+}
+
+// Function to find the cache slot for an inode (matching entry or first empty slot)
+static MtimeCacheEntry *cache_slot(MtimeCacheEntry *cache, size_t capacity, uint64_t ino) {
+    size_t mask = capacity - 1;
+    size_t i = (ino * 0x9E3779B97F4A7C15ULL) & mask;
+    while (cache[i].ino != 0 && cache[i].ino != ino)
+        i = (i + 1) & mask;
+    return &cache[i];
+}
+
+// Function to rebuild the cache, dropping inodes not seen in the current or previous scan
+static void cache_rehash(DirScanner *scanner, size_t live) {
+    size_t capacity = DIR_SCAN_CACHE_INITIAL;
+    while (capacity < live * 4)
+        capacity *= 2;
+
+    MtimeCacheEntry *fresh = calloc(capacity, sizeof(MtimeCacheEntry));
+    if (fresh == NULL)
+        return; // Keep the old table; lookups remain correct
+
+    size_t used = 0;
+    for (size_t i = 0; i < scanner->cache_capacity; i++) {
+        MtimeCacheEntry *entry = &scanner->cache[i];
+        if (entry->ino == 0 || scanner->epoch - entry->epoch > 1)
+            continue;
+        *cache_slot(fresh, capacity, entry->ino) = *entry;
+        used++;
+    }
+    free(scanner->cache);
+    scanner->cache = fresh;
+    scanner->cache_capacity = capacity;
+    scanner->cache_used = used;
+}
+
+// Function to fetch a file's mtime with statx, asking the kernel for the mtime only
+static int fetch_mtime(DirScanner *scanner, const char *name, time_t *mtime) {
+    struct statx stx;
+    scanner->stats.stat_calls++;
+    if (statx(scanner->dir_fd, name, AT_SYMLINK_NOFOLLOW | AT_STATX_DONT_SYNC, STATX_MTIME, &stx) == -1)
+        return -1;
+    *mtime = stx.stx_mtime.tv_sec;
+    return 0;
+}
+
+// Scan the directory in bulk and invoke action for every CSV file older than min_age seconds.
+// mtimes are cached per inode: a file already known to be younger than min_age cannot have
+// aged past it without time passing, so it is only re-stat'ed once the cached mtime says so.
+int dir_scan_aged(DirScanner *scanner, int min_age, DirScanAction action) {
+    scanner->stats.other_calls++;
+    if (lseek(scanner->dir_fd, 0, SEEK_SET) == -1) {
+        perror("Error rewinding directory");
+        return -1;
+    }
+
+    scanner->epoch++;
+    time_t now = time(NULL);
+    size_t seen = 0;
+
+    while (1) {
+        scanner->stats.getdents_calls++;
+        long bytes = syscall(SYS_getdents64, scanner->dir_fd, scanner->buffer, scanner->buffer_size);
+        if (bytes == -1) {
+            perror("Error reading directory");
+            return -1;
+        }
+        if (bytes == 0)
+            break;
+
+        for (long offset = 0; offset < bytes; ) {
+            struct linux_dirent64 *entry = (struct linux_dirent64 *)(scanner->buffer + offset);
+            offset += entry->d_reclen;
+
+            // Skip directories and anything but plain or compressed CSV files
+            if (entry->d_type == DT_DIR || !is_csv_name(entry->d_name))
+                continue;
+            scanner->stats.entries_seen++;
+            seen++;
+
+            if (scanner->cache_used * 2 >= scanner->cache_capacity)
+                cache_rehash(scanner, seen + scanner->cache_used);
+
+            // If the table could not grow, fall back to stat'ing this entry uncached
+            MtimeCacheEntry *cached = NULL;
+            if (scanner->cache_used * 2 < scanner->cache_capacity) {
+                cached = cache_slot(scanner->cache, scanner->cache_capacity, entry->d_ino);
+                if (cached->ino == entry->d_ino) {
+                    cached->epoch = scanner->epoch;
+                    if (difftime(now, cached->mtime) <= min_age)
+                        continue; // Still young, no need to stat
+                }
+            }
+
+            time_t mtime;
+            if (fetch_mtime(scanner, entry->d_name, &mtime) == -1)
+                continue; // Moved away by another process in the meantime
+
+            if (cached != NULL) {
+                if (cached->ino != entry->d_ino) {
+                    cached->ino = entry->d_ino;
+                    scanner->cache_used++;
+                }
+                cached->mtime = mtime;
+                cached->epoch = scanner->epoch;
+            }
+
+            if (difftime(now, mtime) > min_age)
+                action(scanner, entry->d_name);
+        }
+    }
+
+    // Drop inodes that have left the directory
+    if (scanner->cache_used > seen * 2 + DIR_SCAN_CACHE_INITIAL)
+        cache_rehash(scanner, seen);
+    return 0;
+}
+
+// Move a scanned file into another cached directory
+int dir_scan_move(DirScanner *scanner, const char *name, int dest_fd) {
+    scanner->stats.act_calls++;
+    if (renameat(scanner->dir_fd, name, dest_fd, name) == -1)
+        return -1;
+    scanner->stats.files_acted++;
+    return 0;
+}
+
+// Delete a scanned file
+int dir_scan_remove(DirScanner *scanner, const char *name) {
+    scanner->stats.act_calls++;
+    if (unlinkat(scanner->dir_fd, name, 0) == -1)
+        return -1;
+    scanner->stats.files_acted++;
+    return 0;
+}
+
+// Total syscalls issued by the scanner per file moved or deleted
+double dir_scan_syscalls_per_file(const DirScanStats *stats) {
+    long total = stats->getdents_calls + stats->stat_calls + stats->act_calls + stats->other_calls;
+    return stats->files_acted ? (double)total / stats->files_acted : (double)total;
+}
+
+// Reset the syscall counters (the mtime cache is kept)
+void dir_scan_reset_stats(DirScanner *scanner) {
+    memset(&scanner->stats, 0, sizeof(scanner->stats));
+}
@@ -0,0 +1,50 @@
+// dir_scan.h
+#ifndef DIR_SCAN_H
+#define DIR_SCAN_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <time.h>
+
+// Syscall accounting for one scanner
+typedef struct {
+    long getdents_calls;
+    long stat_calls;
+    long act_calls;     // renameat/unlinkat
+    long other_calls;   // lseek to rewind the directory
+    long entries_seen;
+    long files_acted;
+} DirScanStats;
+
+// mtime cache entry keyed by inode number
+typedef struct {
+    uint64_t ino;
+    time_t mtime;
+    unsigned int epoch;
+} MtimeCacheEntry;
+
+// Directory scanner working relative to a cached directory descriptor
+typedef struct {
+    int dir_fd;
+    char *buffer;
+    size_t buffer_size;
+    MtimeCacheEntry *cache;
+    size_t cache_capacity;
+    size_t cache_used;
+    unsigned int epoch;
+    DirScanStats stats;
+} DirScanner;
+
+// Called for every CSV entry (.csv, .csv.lz4 or .csv.zst) older than the requested age
+typedef void (*DirScanAction)(DirScanner *scanner, const char *name);
+
+// Function prototypes
+int dir_scanner_open(DirScanner *scanner, const char *path);
+void dir_scanner_close(DirScanner *scanner);
+int dir_scan_aged(DirScanner *scanner, int min_age, DirScanAction action);
+int dir_scan_move(DirScanner *scanner, const char *name, int dest_fd);
+int dir_scan_remove(DirScanner *scanner, const char *name);
+double dir_scan_syscalls_per_file(const DirScanStats *stats);
+void dir_scan_reset_stats(DirScanner *scanner);
+
+#endif // DIR_SCAN_H
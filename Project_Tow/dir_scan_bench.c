@@ -0,0 +1,251 @@
+// dir_scan_bench.c
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <sys/stat.h>
+#include "dir_scan.h"
+
+#define DEFAULT_ENTRIES 100000  // CSV files in the scanned directory
+#define DEFAULT_AGED 2000       // Of those, files old enough to be moved on every scan
+#define DEFAULT_ROUNDS 5        // Scans per path; the first one is cold for the mtime cache
+#define DEFAULT_DIR "./dir_scan_bench_files"
+#define THRESHOLD_AGE 60        // Age in seconds past which a file is moved, as an inspector threshold
+#define AGED_SECONDS 3600       // How old the aged files are made
+#define MAX_PATH 512
+
+// Syscalls and time of one scan
+typedef struct {
+    long getdents_calls;
+    long stat_calls;
+    long act_calls;
+    long other_calls;   // open/close of the directory, or lseek to rewind it
+    long files_acted;
+    long ns;
+} ScanResult;
+
+// Destination of the new path's moves
+static int dest_fd = -1;
+
+// Function to print usage
+static void usage(const char *program) {
+    fprintf(stderr, "Usage: %s [--entries N] [--aged N] [--rounds N] [--dir PATH]\n", program);
+}
+
+// Function to read the monotonic clock in nanoseconds
+static long now_ns(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec * 1000000000L + now.tv_nsec;
+}
+
+// Function to create the directory: entries empty CSV files, the first aged of them AGED_SECONDS old
+static int populate(const char *dir, int entries, int aged) {
+    int dir_fd = open(dir, O_RDONLY | O_DIRECTORY);
+    if (dir_fd == -1)
+        return -1;
+    struct timespec times[2];
+    clock_gettime(CLOCK_REALTIME, &times[0]);
+    times[0].tv_sec -= AGED_SECONDS;
+    times[1] = times[0];
+    char name[64];
+    for (int i = 0; i < entries; i++) {
+        snprintf(name, sizeof(name), "%d.csv", i);
+        int fd = openat(dir_fd, name, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (fd == -1) {
+            close(dir_fd);
+            return -1;
+        }
+        if (i < aged)
+            futimens(fd, times);
+        close(fd);
+    }
+    close(dir_fd);
+    return 0;
+}
+
+// Function to put the moved files back (untimed), so every scan finds the same directory; rename keeps mtimes
+static void restore(const char *dir, const char *dest) {
+    int from_fd = open(dest, O_RDONLY | O_DIRECTORY);
+    int to_fd = open(dir, O_RDONLY | O_DIRECTORY);
+    DIR *moved = fdopendir(dup(from_fd));
+    struct dirent *entry;
+    while (moved != NULL && (entry = readdir(moved)) != NULL) {
+        if (entry->d_type != DT_DIR)
+            renameat(from_fd, entry->d_name, to_fd, entry->d_name);
+    }
+    if (moved != NULL)
+        closedir(moved);
+    close(from_fd);
+    close(to_fd);
+}
+
+// Function to scan the way the inspectors used to: opendir/readdir, a stat and a rename by full path.
+// glibc hides its getdents64 calls; each one refills the DIR buffer, which shows as readdir returning an
+// entry that does not lie past the previous one, plus the call that reports the end.
+static int scan_old(const char *dir, const char *dest, ScanResult *result) {
+    memset(result, 0, sizeof(*result));
+    long start = now_ns();
+    DIR *handle = opendir(dir);
+    if (handle == NULL)
+        return -1;
+    result->other_calls++;
+    time_t now = time(NULL);
+
+    struct dirent *entry;
+    const char *previous = NULL;
+    while ((entry = readdir(handle)) != NULL) {
+        if (previous == NULL || (const char *)entry <= previous)
+            result->getdents_calls++;
+        previous = (const char *)entry;
+
+        if (entry->d_type == DT_DIR || !strstr(entry->d_name, ".csv"))
+            continue;
+        char filepath[MAX_PATH];
+        snprintf(filepath, sizeof(filepath), "%s/%s", dir, entry->d_name);
+        struct stat st;
+        result->stat_calls++;
+        if (stat(filepath, &st) == -1)
+            continue;
+        if (difftime(now, st.st_mtime) > THRESHOLD_AGE) {
+            char destpath[MAX_PATH];
+            snprintf(destpath, sizeof(destpath), "%s/%s", dest, entry->d_name);
+            result->act_calls++;
+            if (rename(filepath, destpath) == 0)
+                result->files_acted++;
+        }
+    }
+    result->getdents_calls++; // The call that found the end
+    closedir(handle);
+    result->other_calls++;
+    result->ns = now_ns() - start;
+    return 0;
+}
+
+// Scan action of the new path: move the aged file like inspector_type1 does
+static void move_file(DirScanner *scanner, const char *name) {
+    dir_scan_move(scanner, name, dest_fd);
+}
+
+// Function to scan with dir_scan: a kept descriptor, bulk getdents64, cached mtimes and renameat
+static int scan_new(DirScanner *scanner, ScanResult *result) {
+    dir_scan_reset_stats(scanner);
+    long start = now_ns();
+    if (dir_scan_aged(scanner, THRESHOLD_AGE, move_file) == -1)
+        return -1;
+    result->ns = now_ns() - start;
+    result->getdents_calls = scanner->stats.getdents_calls;
+    result->stat_calls = scanner->stats.stat_calls;
+    result->act_calls = scanner->stats.act_calls;
+    result->other_calls = scanner->stats.other_calls;
+    result->files_acted = scanner->stats.files_acted;
+    return 0;
+}
+
+// Function to print one scan
+static void print_result(const char *path, int round, const ScanResult *result) {
+    long total = result->getdents_calls + result->stat_calls + result->act_calls + result->other_calls;
+    printf("%-5s %5d %10ld %10ld %10ld %8ld %10ld %14.2f %10.1f\n", path, round, result->getdents_calls,
+           result->stat_calls, result->act_calls, result->other_calls, result->files_acted,
+           result->files_acted ? (double)total / result->files_acted : (double)total, result->ns / 1e6);
+}
+
+// Function to remove every file the bench created, then its directories
+static void cleanup(const char *dir, const char *dest) {
+    restore(dir, dest);
+    rmdir(dest);
+    int dir_fd = open(dir, O_RDONLY | O_DIRECTORY);
+    DIR *handle = dir_fd == -1 ? NULL : fdopendir(dup(dir_fd));
+    struct dirent *entry;
+    while (handle != NULL && (entry = readdir(handle)) != NULL) {
+        if (entry->d_type != DT_DIR)
+            unlinkat(dir_fd, entry->d_name, 0);
+    }
+    if (handle != NULL)
+        closedir(handle);
+    if (dir_fd != -1)
+        close(dir_fd);
+    rmdir(dir);
+}
+
+// Main function
+int main(int argc, char *argv[]) {
+    int entries = DEFAULT_ENTRIES;
+    int aged = DEFAULT_AGED;
+    int rounds = DEFAULT_ROUNDS;
+    const char *dir = DEFAULT_DIR;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--entries") == 0 && i + 1 < argc) {
+            entries = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--aged") == 0 && i + 1 < argc) {
+            aged = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--rounds") == 0 && i + 1 < argc) {
+            rounds = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--dir") == 0 && i + 1 < argc) {
+            dir = argv[++i];
+        } else {
+            usage(argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+    if (entries < 1 || aged < 0 || aged > entries || rounds < 1) {
+        usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    // The destination sits inside the scanned directory, as UnProcessed sits in home
+    char dest[MAX_PATH];
+    snprintf(dest, sizeof(dest), "%s/moved", dir);
+    if ((mkdir(dir, 0755) != 0 && access(dir, W_OK) != 0) || (mkdir(dest, 0755) != 0 && access(dest, W_OK) != 0)) {
+        perror("Error creating bench directory");
+        return EXIT_FAILURE;
+    }
+    if (populate(dir, entries, aged) != 0) {
+        perror("Error creating bench files");
+        cleanup(dir, dest);
+        return EXIT_FAILURE;
+    }
+
+    printf("Directory scan: %d CSV files in %s, %d older than %d s moved on every scan\n",
+           entries, dir, aged, THRESHOLD_AGE);
+    printf("%-5s %5s %10s %10s %10s %8s %10s %14s %10s\n", "path", "round", "getdents", "stat", "rename",
+           "other", "moved", "syscalls/file", "ms");
+
+    int status = EXIT_SUCCESS;
+    ScanResult result;
+    for (int round = 1; round <= rounds && status == EXIT_SUCCESS; round++) {
+        if (scan_old(dir, dest, &result) != 0) {
+            perror("Error scanning with readdir");
+            status = EXIT_FAILURE;
+            break;
+        }
+        print_result("old", round, &result);
+        restore(dir, dest);
+    }
+
+    DirScanner scanner;
+    dest_fd = open(dest, O_RDONLY | O_DIRECTORY);
+    if (status == EXIT_SUCCESS && dest_fd != -1 && dir_scanner_open(&scanner, dir) == 0) {
+        for (int round = 1; round <= rounds; round++) {
+            if (scan_new(&scanner, &result) != 0) {
+                status = EXIT_FAILURE;
+                break;
+            }
+            print_result("new", round, &result);
+            restore(dir, dest);
+        }
+        dir_scanner_close(&scanner);
+    } else {
+        status = EXIT_FAILURE;
+    }
+    if (dest_fd != -1)
+        close(dest_fd);
+
+    cleanup(dir, dest);
+    return status;
+}
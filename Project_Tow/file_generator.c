@@ -1,6 +1,9 @@
 // file_generator.c
 #include "shared_memory.h"
 #include "config.h"
+#include "journal.h"
+#include "workload.h"
+#include "file_io.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -9,9 +12,228 @@
 #include <sys/stat.h>
 #include <signal.h>
 
+#define STREAM_PUBLISH_ROWS 256 // Rows between watermark updates
+
+// Shared state used when producing files
+SharedMemory *shared_data = NULL;
+sem_t *sem = NULL;
+Config config;
+int generator_id = 0;
+
 // Function to generate random float in a given range
-float generate_random_float(float min, float max) {
-    return min + ((float)rand() / RAND_MAX) * (max - min);
+float generate_random_float(unsigned int *seed, float min, float max) {
+    return min + ((float)rand_r(seed) / RAND_MAX) * (max - min);
+}
+
+// CPU time used by this process in milliseconds
+long cpu_ms() {
+    struct timespec now;
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &now);
+    return (long)now.tv_sec * 1000 + now.tv_nsec / 1000000;
+}
+
+// Milliseconds since the epoch
+long now_ms() {
+    struct timespec now;
+    clock_gettime(CLOCK_REALTIME, &now);
+    return (long)now.tv_sec * 1000 + now.tv_nsec / 1000000;
+}
+
+// Function to sleep until an absolute time in milliseconds since the epoch
+void sleep_until_ms(long deadline_ms) {
+    long remaining;
+    while ((remaining = deadline_ms - now_ms()) > 0) {
+        struct timespec delay = { remaining / 1000, (remaining % 1000) * 1000000 };
+        nanosleep(&delay, NULL);
+    }
+}
+
+// Function to publish the bytes of whole rows written so far to a streaming consumer
+void publish_watermark(CsvWriter *writer, StreamSlot *slot) {
+    csv_writer_flush_rows(writer);
+    __atomic_store_n(&slot->committed_bytes, writer->row_end, __ATOMIC_RELEASE);
+}
+
+// Function to write one CSV file; its content depends only on the entry (shape and seed).
+// With a stream slot, the committed-bytes watermark is advanced every STREAM_PUBLISH_ROWS rows.
+// *cached_bytes receives how much of the file is left in the page cache (-1 if unknown) and
+// *plain_bytes its size before compression.
+int write_csv_file(const char *filename, const WorkloadEntry *entry, StreamSlot *slot, long *cached_bytes, long *plain_bytes) {
+    // Upper bound for the size: every value at its widest, so direct mode can preallocate
+    char field[64];
+    int widest = snprintf(field, sizeof(field), "%.2f,", config.value_max);
+    int widest_min = snprintf(field, sizeof(field), "%.2f,", config.value_min);
+    if (widest_min > widest)
+        widest = widest_min;
+    long size_hint = entry->columns * 8L + (long)entry->rows * (entry->columns * widest + 1);
+
+    CsvWriter writer;
+    if (csv_writer_open(&writer, filename, config.io_mode, config.compression, config.compression_level, size_hint) == -1) {
+        return -1;
+    }
+
+    unsigned int seed = entry->seed;
+    int result = 0;
+
+    // Write CSV header
+    for (int c = 0; c < entry->columns; c++) {
+        int len = snprintf(field, sizeof(field), c < entry->columns - 1 ? "Col%d," : "Col%d", c);
+        result |= csv_writer_append(&writer, field, len);
+    }
+    result |= csv_writer_append(&writer, "\n", 1);
+
+    // Write random data to CSV
+    for (int r = 0; r < entry->rows && result == 0; r++) {
+        for (int c = 0; c < entry->columns; c++) {
+            if (((float)rand_r(&seed) / RAND_MAX) * 100 < entry->missing_percentage) {
+                result |= csv_writer_append(&writer, ",", 1); // Missing data
+            } else {
+                int len = snprintf(field, sizeof(field), "%.2f,", generate_random_float(&seed, config.value_min, config.value_max));
+                result |= csv_writer_append(&writer, field, len);
+            }
+        }
+        result |= csv_writer_append(&writer, "\n", 1);
+
+        if (slot != NULL && (r + 1) % STREAM_PUBLISH_ROWS == 0) {
+            publish_watermark(&writer, slot);
+        }
+    }
+
+    *plain_bytes = writer.plain_bytes;
+    result |= csv_writer_close(&writer);
+    if (slot != NULL) {
+        __atomic_store_n(&slot->committed_bytes, writer.row_end, __ATOMIC_RELEASE);
+    }
+    *cached_bytes = io_cached_bytes(filename);
+    return result;
+}
+
+// Function to take a free streaming slot for a new file (caller holds the semaphore)
+StreamSlot *acquire_stream_slot(int file_index) {
+    for (int i = 0; i < MAX_STREAMS; i++) {
+        StreamSlot *slot = &shared_data->streams[i];
+        if (slot->state == STREAM_FREE) {
+            slot->file_index = file_index;
+            slot->claimed_by = -1;
+            slot->complete = 0;
+            slot->failed = 0;
+            slot->committed_bytes = 0;
+            slot->started_ms = now_ms();
+            slot->state = STREAM_WRITING;
+            return slot;
+        }
+    }
+    return NULL; // All slots busy: write the file the classic way
+}
+
+// Function to move a finished file from .inprogress into ./home and queue it. Both happen under the
+// semaphore, so the calculators' fallback scan (also under it) never sees the file before it is queued.
+// Returns 0 once the file is published.
+int publish_file(const char *stream_path, const char *filename, int file_index) {
+    sem_wait(sem);
+    int published = rename(stream_path, filename) == 0;
+    if (published) {
+        // The file's deadline starts now: queue it for earliest-deadline-first claiming
+        file_enqueue(shared_data, file_index, now_ms());
+    }
+    sem_post(sem);
+    if (!published) {
+        perror("Error publishing generated file");
+        return -1;
+    }
+    return 0;
+}
+
+// Function to mark a streamed file complete. A claiming calculator finalises it itself;
+// otherwise the file is published to ./home like any other.
+void finish_stream(StreamSlot *slot, const char *stream_path, const char *filename) {
+    sem_wait(sem);
+    __atomic_store_n(&slot->complete, 1, __ATOMIC_RELEASE);
+    int claimed = slot->claimed_by != -1;
+    if (!claimed) {
+        slot->state = STREAM_FINALIZING;
+    }
+    sem_post(sem);
+
+    if (claimed)
+        return;
+
+    publish_file(stream_path, filename, slot->file_index);
+    sem_wait(sem);
+    slot->state = STREAM_FREE;
+    sem_post(sem);
+}
+
+// Function to drop a streamed file whose write failed. A claiming calculator discards what it
+// parsed and frees the slot itself; otherwise the slot is freed here.
+void abort_stream(StreamSlot *slot, const char *stream_path) {
+    unlink(stream_path);
+    sem_wait(sem);
+    slot->failed = 1;
+    __atomic_store_n(&slot->complete, 1, __ATOMIC_RELEASE);
+    if (slot->claimed_by == -1) {
+        slot->state = STREAM_FREE;
+    }
+    sem_post(sem);
+}
+
+// Function to claim the next file index and generate the file described by entry
+void produce_file(const WorkloadEntry *entry) {
+    // Generate a file name based on the current file count
+    StreamSlot *slot = NULL;
+    sem_wait(sem);
+    int file_index = shared_data->files_generated;
+    shared_data->files_generated++;
+    if (config.streaming_enabled) {
+        slot = acquire_stream_slot(file_index);
+    }
+    sem_post(sem);
+
+    const char *extension = compress_extension(config.compression);
+    char filename[MAX_FILENAME];
+    snprintf(filename, sizeof(filename), "./home/%d%s", file_index, extension);
+
+    long cached_bytes = -1;
+    long plain_bytes = 0;
+    long cpu_start = cpu_ms();
+    // Files are written out of sight in .inprogress and only appear in ./home once complete
+    char stream_path[MAX_FILENAME];
+    snprintf(stream_path, sizeof(stream_path), "./home/.inprogress/%d%s", file_index, extension);
+    if (slot != NULL) {
+        // Write where calculators can follow the watermark, then finalise
+        if (write_csv_file(stream_path, entry, slot, &cached_bytes, &plain_bytes) != 0) {
+            // A truncated file is never journaled as generated nor published
+            abort_stream(slot, stream_path);
+            return;
+        }
+        journal_append(JOURNAL_GENERATED, file_index, generator_id);
+        finish_stream(slot, stream_path, filename);
+        printf("Generator %d: Generated file %s with %d rows and %d columns (streamed)\n", generator_id, filename, entry->rows, entry->columns);
+    } else if (write_csv_file(stream_path, entry, NULL, &cached_bytes, &plain_bytes) == 0) {
+        journal_append(JOURNAL_GENERATED, file_index, generator_id);
+        if (publish_file(stream_path, filename, file_index) != 0) {
+            return;
+        }
+        if (cached_bytes >= 0) {
+            printf("Generator %d: Generated file %s with %d rows and %d columns (%ld KiB left in page cache)\n",
+                   generator_id, filename, entry->rows, entry->columns, cached_bytes / 1024);
+        } else {
+            printf("Generator %d: Generated file %s with %d rows and %d columns\n", generator_id, filename, entry->rows, entry->columns);
+        }
+    } else {
+        unlink(stream_path); // Never left behind for recovery to publish
+        return;
+    }
+
+    // CPU spent per byte saved on disk
+    if (config.compression != COMPRESS_NONE) {
+        struct stat st;
+        if (stat(filename, &st) == 0 && st.st_size > 0) {
+            printf("Generator %d: Compressed %s at level %d: %ld KiB -> %ld KiB (%.2fx) in %ld ms CPU\n",
+                   generator_id, filename, config.compression_level, plain_bytes / 1024, (long)st.st_size / 1024,
+                   (double)plain_bytes / st.st_size, cpu_ms() - cpu_start);
+        }
+    }
 }
 
 // Function to create directories if they do not already exist
@@ -40,7 +262,7 @@ int main(int argc, char *argv[]) {
         exit(1);
     }
 
-    int generator_id = atoi(argv[1]);
+    generator_id = atoi(argv[1]);
 
     // Register signal handlers
     if (signal(SIGTERM, handle_signal) == SIG_ERR) {
@@ -53,65 +275,71 @@ int main(int argc, char *argv[]) {
     }
 
     // Initialize shared memory and semaphore
-    SharedMemory *shared_data = init_shared_memory();
-    sem_t *sem = init_semaphore();
+    shared_data = init_shared_memory();
+    sem = init_semaphore();
 
     // Read configuration
-    Config config;
     parse_config("config.txt", &config);
 
+    // Lifecycle events are appended to the shared journal
+    if (config.journal_enabled) {
+        journal_open(config.journal_path);
+    }
+
     // Seed the random number generator
     srand(time(NULL) ^ (getpid() << 16));
 
     // Ensure the home directory exists
     create_directory_if_needed("./home");
+    create_directory_if_needed("./home/.inprogress");
+
+    // Without the codec library, fall back to plain CSV rather than producing nothing
+    if (config.compression != COMPRESS_NONE && !compress_available(config.compression)) {
+        fprintf(stderr, "Generator %d: %s compression unavailable, writing plain CSV\n",
+                generator_id, compress_extension(config.compression));
+        config.compression = COMPRESS_NONE;
+    }
+
+    // Arrival times are relative to the supervisor's start of run
+    long run_start_ms = shared_data->run_start_ms ? shared_data->run_start_ms : now_ms();
+
+    if (config.workload_mode == WORKLOAD_REPLAY) {
+        // Replay this generator's part of the trace, compressed in time by workload_speed
+        float speed = config.workload_speed > 0 ? config.workload_speed : 1.0f;
+        WorkloadEntry *entries = NULL;
+        int count = workload_load(config.workload_file, generator_id, &entries);
+        if (count < 0) {
+            exit(1);
+        }
+        for (int i = 0; i < count; i++) {
+            sleep_until_ms(run_start_ms + (long)(entries[i].arrival_ms / speed));
+            produce_file(&entries[i]);
+        }
+        free(entries);
+        printf("Generator %d: Replay finished (%d files)\n", generator_id, count);
+        while (1) {
+            pause(); // Wait for the supervisor to terminate us
+        }
+    }
 
     while (1) {
         // Generate a random sleep interval
         int sleep_time = config.gen_interval_min + rand() % (config.gen_interval_max - config.gen_interval_min + 1);
         sleep(sleep_time);
 
-        // Generate a file name based on the current file count
-        sem_wait(sem);
-        int file_index = shared_data->files_generated;
-        shared_data->files_generated++;
-        sem_post(sem);
-
-        char filename[MAX_FILENAME];
-        snprintf(filename, sizeof(filename), "./home/%d.csv", file_index);
+        // Determine random number of rows and columns and a seed for the content
+        WorkloadEntry entry;
+        entry.generator_id = generator_id;
+        entry.arrival_ms = now_ms() - run_start_ms;
+        entry.rows = config.rows_min + rand() % (config.rows_max - config.rows_min + 1);
+        entry.columns = config.columns_min + rand() % (config.columns_max - config.columns_min + 1);
+        entry.missing_percentage = config.missing_percentage;
+        entry.seed = (unsigned int)rand();
 
-        // Determine random number of rows and columns
-        int num_rows = config.rows_min + rand() % (config.rows_max - config.rows_min + 1);
-        int num_columns = config.columns_min + rand() % (config.columns_max - config.columns_min + 1);
-
-        FILE *file = fopen(filename, "w");
-        if (file == NULL) {
-            perror("Error creating CSV file");
-            continue;
+        if (config.workload_mode == WORKLOAD_RECORD) {
+            workload_record(config.workload_file, &entry);
         }
-
-        // Write CSV header
-        for (int c = 0; c < num_columns; c++) {
-            fprintf(file, "Col%d", c);
-            if (c < num_columns - 1)
-                fprintf(file, ",");
-        }
-        fprintf(file, "\n");
-
-        // Write random data to CSV
-        for (int r = 0; r < num_rows; r++) {
-            for (int c = 0; c < num_columns; c++) {
-                if (((float)rand() / RAND_MAX) * 100 < config.missing_percentage) {
-                    fprintf(file, ","); // Missing data
-                } else {
-                    fprintf(file, "%.2f,", generate_random_float(config.value_min, config.value_max));
-                }
-            }
-            fprintf(file, "\n");
-        }
-
-        fclose(file);
-        printf("Generator %d: Generated file %s with %d rows and %d columns\n", generator_id, filename, num_rows, num_columns);
+        produce_file(&entry);
     }
 
     // Cleanup (unreachable in current design)
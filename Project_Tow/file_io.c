@@ -0,0 +1,389 @@
+// file_io.c
+#define _GNU_SOURCE
+#include "file_io.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+const char *io_mode_name(IoMode mode) {
+    switch (mode) {
+        case IO_DIRECT: return "direct";
+        case IO_DONTNEED: return "dontneed";
+        default: return "buffered";
+    }
+}
+
+// Function to open a file, with O_DIRECT when asked for and supported. *direct reports which.
+static int open_maybe_direct(const char *path, int flags, IoMode mode, int *direct) {
+    *direct = 0;
+    if (mode == IO_DIRECT) {
+        int fd = open(path, flags | O_DIRECT, 0644);
+        if (fd != -1) {
+            *direct = 1;
+            return fd;
+        }
+        if (errno != EINVAL)
+            return -1;
+        // Filesystem without O_DIRECT support (e.g. tmpfs): use the page cache instead
+    }
+    return open(path, flags, 0644);
+}
+
+// Function to write len bytes, retrying short writes
+static int write_all(int fd, const char *data, size_t len) {
+    while (len > 0) {
+        ssize_t bytes = write(fd, data, len);
+        if (bytes == -1) {
+            if (errno == EINTR)
+                continue;
+            return -1;
+        }
+        data += bytes;
+        len -= bytes;
+    }
+    return 0;
+}
+
+// Function to hand the first len staged bytes to the kernel and keep the rest
+static int writer_flush(CsvWriter *writer, size_t len) {
+    if (len == 0)
+        return 0;
+    if (write_all(writer->fd, writer->buffer, len) == -1) {
+        perror("Error writing CSV file");
+        return -1;
+    }
+
+    // Plain text is consumable up to the last newline; a compressed stream up to any byte,
+    // since the decoder keeps partial blocks and the reader joins partial lines
+    char *last_newline = writer->codec ? writer->buffer + len - 1 : memrchr(writer->buffer, '\n', len);
+    if (last_newline != NULL)
+        writer->row_end = writer->written + (last_newline - writer->buffer) + 1;
+    writer->written += len;
+
+    memmove(writer->buffer, writer->buffer + len, writer->used - len);
+    writer->used -= len;
+    return 0;
+}
+
+// Open a file for writing, compressed unless format is COMPRESS_NONE. In direct mode size_hint
+// bytes are reserved up front so the aligned writes never have to extend the allocation.
+int csv_writer_open(CsvWriter *writer, const char *path, IoMode mode, CompressFormat format, int level, long size_hint) {
+    memset(writer, 0, sizeof(*writer));
+    writer->mode = mode;
+    writer->fd = open_maybe_direct(path, O_WRONLY | O_CREAT | O_TRUNC, mode, &writer->direct);
+    if (writer->fd == -1) {
+        perror("Error creating CSV file");
+        return -1;
+    }
+
+    if (mode == IO_DIRECT && size_hint > 0) {
+        // Reserve blocks without changing the visible size; unsupported filesystems just skip it
+        if (fallocate(writer->fd, FALLOC_FL_KEEP_SIZE, 0, size_hint) == -1 && errno != EOPNOTSUPP) {
+            perror("Error preallocating CSV file");
+        }
+    }
+
+    if (posix_memalign((void **)&writer->buffer, IO_BLOCK_SIZE, IO_BUFFER_SIZE) != 0) {
+        fprintf(stderr, "Error allocating CSV write buffer\n");
+        close(writer->fd);
+        return -1;
+    }
+
+    if (format != COMPRESS_NONE) {
+        writer->codec = codec_open_encoder(format, level);
+        writer->plain = malloc(IO_PLAIN_SIZE);
+        if (writer->codec == NULL || writer->plain == NULL) {
+            fprintf(stderr, "Error preparing %s encoder\n", compress_extension(format));
+            codec_close(writer->codec);
+            free(writer->plain);
+            free(writer->buffer);
+            close(writer->fd);
+            return -1;
+        }
+    }
+    return 0;
+}
+
+// Stage bytes bound for the file, writing out the buffer whenever it fills up
+static int writer_stage(char *data, size_t len, void *arg) {
+    CsvWriter *writer = arg;
+    while (len > 0) {
+        size_t space = IO_BUFFER_SIZE - writer->used;
+        size_t chunk = len < space ? len : space;
+        memcpy(writer->buffer + writer->used, data, chunk);
+        writer->used += chunk;
+        data += chunk;
+        len -= chunk;
+
+        // IO_BUFFER_SIZE is a multiple of IO_BLOCK_SIZE, so a full buffer is always aligned
+        if (writer->used == IO_BUFFER_SIZE && writer_flush(writer, writer->used) == -1)
+            return -1;
+    }
+    return 0;
+}
+
+// Function to pass the waiting plain text through the encoder
+static int writer_encode(CsvWriter *writer, CodecDirective directive) {
+    int result = codec_encode(writer->codec, writer->plain, writer->plain_used, directive, writer_stage, writer);
+    writer->plain_used = 0;
+    return result;
+}
+
+// Append CSV text, compressing it first when the writer has an encoder
+int csv_writer_append(CsvWriter *writer, const char *data, size_t len) {
+    writer->plain_bytes += len;
+    if (writer->codec == NULL)
+        return writer_stage((char *)data, len, writer);
+
+    while (len > 0) {
+        size_t space = IO_PLAIN_SIZE - writer->plain_used;
+        size_t chunk = len < space ? len : space;
+        memcpy(writer->plain + writer->plain_used, data, chunk);
+        writer->plain_used += chunk;
+        data += chunk;
+        len -= chunk;
+
+        if (writer->plain_used == IO_PLAIN_SIZE && writer_encode(writer, CODEC_CONTINUE) == -1)
+            return -1;
+    }
+    return 0;
+}
+
+// Hand whole rows to the kernel so row_end can be published to a streaming reader.
+// Called at a row boundary; in direct mode only whole blocks are written and the
+// partial block stays staged.
+int csv_writer_flush_rows(CsvWriter *writer) {
+    if (writer->codec != NULL && writer_encode(writer, CODEC_FLUSH) == -1)
+        return -1;
+    if (writer->direct)
+        return writer_flush(writer, writer->used - writer->used % IO_BLOCK_SIZE);
+    return writer_flush(writer, writer->used);
+}
+
+// Write the remainder and close. Direct mode pads the final block and trims the file back to
+// its real size; dontneed mode makes the data durable and drops it from the page cache.
+int csv_writer_close(CsvWriter *writer) {
+    int result = 0;
+    if (writer->codec != NULL) {
+        if (writer_encode(writer, CODEC_END) == -1)
+            result = -1;
+        codec_close(writer->codec);
+        writer->codec = NULL;
+        free(writer->plain);
+        writer->plain = NULL;
+    }
+    long size = writer->written + writer->used;
+
+    if (writer->direct && writer->used % IO_BLOCK_SIZE != 0) {
+        size_t padded = writer->used + IO_BLOCK_SIZE - writer->used % IO_BLOCK_SIZE;
+        memset(writer->buffer + writer->used, 0, padded - writer->used);
+        writer->used = padded;
+    }
+    if (writer_flush(writer, writer->used) == -1)
+        result = -1;
+    if (writer->direct && ftruncate(writer->fd, size) == -1) {
+        perror("Error trimming CSV file");
+        result = -1;
+    }
+    writer->written = size;
+    writer->row_end = size;
+
+    if (writer->mode == IO_DONTNEED) {
+        // Only clean pages can be dropped, so write them back first
+        if (fdatasync(writer->fd) == -1) {
+            perror("Error syncing CSV file");
+        }
+        posix_fadvise(writer->fd, 0, 0, POSIX_FADV_DONTNEED);
+    }
+
+    if (close(writer->fd) == -1) {
+        perror("Error closing CSV file");
+        result = -1;
+    }
+    free(writer->buffer);
+    writer->buffer = NULL;
+    return result;
+}
+
+// Function to append bytes to the carried-over partial line
+static int carry_append(char **carry, size_t *carry_len, size_t *carry_capacity, const char *data, size_t len) {
+    if (*carry_len + len + 1 > *carry_capacity) {
+        size_t capacity = *carry_capacity ? *carry_capacity : 1024;
+        while (*carry_len + len + 1 > capacity)
+            capacity *= 2;
+        char *grown = realloc(*carry, capacity);
+        if (grown == NULL) {
+            perror("Error growing CSV line buffer");
+            return -1;
+        }
+        *carry = grown;
+        *carry_capacity = capacity;
+    }
+    memcpy(*carry + *carry_len, data, len);
+    *carry_len += len;
+    (*carry)[*carry_len] = '\0';
+    return 0;
+}
+
+// Prepare a splitter; compressed formats are decoded before splitting
+int csv_splitter_open(CsvLineSplitter *splitter, CompressFormat format, CsvLineAction action, void *arg) {
+    memset(splitter, 0, sizeof(*splitter));
+    splitter->action = action;
+    splitter->arg = arg;
+    if (format != COMPRESS_NONE) {
+        splitter->codec = codec_open_decoder(format);
+        if (splitter->codec == NULL) {
+            fprintf(stderr, "Error preparing %s decoder\n", compress_extension(format));
+            return -1;
+        }
+    }
+    return 0;
+}
+
+// Function to split decoded text into lines. Returns 0, 1 if the action stopped, -1 on error.
+static int splitter_lines(char *data, size_t len, void *arg) {
+    CsvLineSplitter *splitter = arg;
+    splitter->plain_bytes += len;
+
+    char *line = data;
+    char *end = data + len;
+    char *newline;
+    if (splitter->carry_len > 0) {
+        newline = memchr(line, '\n', end - line);
+        size_t part = newline ? (size_t)(newline - line) : (size_t)(end - line);
+        if (carry_append(&splitter->carry, &splitter->carry_len, &splitter->carry_capacity, line, part) == -1)
+            return -1;
+        if (newline == NULL)
+            return 0;
+        splitter->carry_len = 0;
+        line = newline + 1;
+        if (splitter->action(splitter->carry, splitter->arg))
+            return 1;
+    }
+
+    while ((newline = memchr(line, '\n', end - line)) != NULL) {
+        *newline = '\0';
+        if (splitter->action(line, splitter->arg))
+            return 1;
+        line = newline + 1;
+    }
+    if (line < end && carry_append(&splitter->carry, &splitter->carry_len, &splitter->carry_capacity, line, end - line) == -1)
+        return -1;
+    return 0;
+}
+
+// Feed the next bytes of the file (any split is fine). data may be modified.
+// Returns 0 to continue, 1 if the action stopped and -1 on error.
+int csv_splitter_feed(CsvLineSplitter *splitter, char *data, size_t len) {
+    if (splitter->codec == NULL)
+        return splitter_lines(data, len, splitter);
+    return codec_decode(splitter->codec, data, len, splitter_lines, splitter);
+}
+
+// Emit a last line without a trailing newline and release the splitter.
+// Returns 1 if the action stopped on it, otherwise 0.
+int csv_splitter_close(CsvLineSplitter *splitter) {
+    int result = 0;
+    if (splitter->carry_len > 0 && splitter->action(splitter->carry, splitter->arg))
+        result = 1;
+    codec_close(splitter->codec);
+    free(splitter->carry);
+    memset(splitter, 0, sizeof(*splitter));
+    return result;
+}
+
+// Read a file in IO_BUFFER_SIZE chunks and invoke action for every line (without its newline).
+// The format follows the file's extension, and compressed files are decoded chunk by chunk.
+// Returns 0 at end of file, 1 if action stopped the read and -1 on error.
+int csv_read_lines(const char *path, IoMode mode, CsvLineAction action, void *arg, CsvReadStats *stats) {
+    int direct;
+    int format = compress_format_from_name(path);
+    int fd = open_maybe_direct(path, O_RDONLY, mode, &direct);
+    if (fd == -1) {
+        perror("Error opening file for reading");
+        return -1;
+    }
+    if (mode == IO_DONTNEED) {
+        posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+    }
+
+    char *buffer;
+    if (posix_memalign((void **)&buffer, IO_BLOCK_SIZE, IO_BUFFER_SIZE) != 0) {
+        fprintf(stderr, "Error allocating CSV read buffer\n");
+        close(fd);
+        return -1;
+    }
+
+    // The aligned buffer is only ever read into; lines crossing chunks are joined by the splitter
+    CsvLineSplitter splitter;
+    int result = csv_splitter_open(&splitter, format == -1 ? COMPRESS_NONE : format, action, arg);
+    stats->bytes_read = 0;
+
+    while (result == 0) {
+        ssize_t bytes = read(fd, buffer, IO_BUFFER_SIZE);
+        if (bytes == -1) {
+            if (errno == EINTR)
+                continue;
+            perror("Error reading CSV file");
+            result = -1;
+            break;
+        }
+        if (bytes == 0)
+            break;
+        stats->bytes_read += bytes;
+        result = csv_splitter_feed(&splitter, buffer, bytes);
+    }
+    stats->bytes_decoded = splitter.plain_bytes;
+    if (result == 0)
+        result = csv_splitter_close(&splitter);
+    else
+        csv_splitter_close(&splitter);
+
+    if (mode == IO_DONTNEED) {
+        posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+    }
+    close(fd);
+    free(buffer);
+    return result;
+}
+
+// Bytes of a file currently resident in the page cache, or -1 if it cannot be checked
+long io_cached_bytes(const char *path) {
+    int fd = open(path, O_RDONLY);
+    if (fd == -1)
+        return -1;
+    struct stat st;
+    if (fstat(fd, &st) == -1) {
+        close(fd);
+        return -1;
+    }
+    if (st.st_size == 0) {
+        close(fd);
+        return 0;
+    }
+
+    void *map = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED)
+        return -1;
+
+    long page_size = sysconf(_SC_PAGESIZE);
+    size_t pages = (st.st_size + page_size - 1) / page_size;
+    unsigned char *resident = malloc(pages);
+    long cached = -1;
+    if (resident != NULL && mincore(map, st.st_size, resident) == 0) {
+        cached = 0;
+        for (size_t i = 0; i < pages; i++) {
+            if (resident[i] & 1)
+                cached += page_size;
+        }
+    }
+    free(resident);
+    munmap(map, st.st_size);
+    return cached;
+}
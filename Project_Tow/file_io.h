@@ -0,0 +1,66 @@
+// file_io.h
+#ifndef FILE_IO_H
+#define FILE_IO_H
+
+#include "compress.h"
+#include <stddef.h>
+
+#define IO_BLOCK_SIZE 4096          // Alignment required by O_DIRECT
+#define IO_BUFFER_SIZE (1 << 20)    // Staging buffer for writes and reads
+#define IO_PLAIN_SIZE (128 * 1024)  // Uncompressed text handed to the encoder at a time
+
+// How CSV files are written by generators and read by calculators
+typedef enum {
+    IO_BUFFERED = 0, // Page cache as usual (default)
+    IO_DIRECT,       // Preallocated with fallocate, aligned O_DIRECT blocks bypass the page cache
+    IO_DONTNEED      // Page cache, dropped with posix_fadvise(DONTNEED) once the file is done
+} IoMode;
+
+// Writer that stages a file in an aligned buffer and tracks how much a reader may consume
+typedef struct {
+    int fd;
+    IoMode mode;
+    int direct;       // O_DIRECT in effect (falls back when the filesystem refuses it)
+    char *buffer;
+    size_t used;
+    long written;     // Bytes handed to the kernel
+    long row_end;     // Bytes handed to the kernel that a streaming reader may consume
+    Codec *codec;     // Encoder for compressed formats, NULL for plain CSV
+    char *plain;      // Uncompressed text waiting for the encoder
+    size_t plain_used;
+    long plain_bytes; // Uncompressed bytes appended so far
+} CsvWriter;
+
+// Callback for every line read; returning non-zero stops the read
+typedef int (*CsvLineAction)(char *line, void *arg);
+
+// Splits a byte stream, decoded first if compressed, into lines for an action
+typedef struct {
+    Codec *codec;
+    CsvLineAction action;
+    void *arg;
+    char *carry;      // Partial line joined across chunks
+    size_t carry_len;
+    size_t carry_capacity;
+    long plain_bytes; // Decoded bytes passed to the splitter
+} CsvLineSplitter;
+
+// Per-read statistics
+typedef struct {
+    long bytes_read;    // Bytes read from disk
+    long bytes_decoded; // Bytes of CSV text after decompression
+} CsvReadStats;
+
+// Function prototypes
+const char *io_mode_name(IoMode mode);
+int csv_writer_open(CsvWriter *writer, const char *path, IoMode mode, CompressFormat format, int level, long size_hint);
+int csv_writer_append(CsvWriter *writer, const char *data, size_t len);
+int csv_writer_flush_rows(CsvWriter *writer);
+int csv_writer_close(CsvWriter *writer);
+int csv_splitter_open(CsvLineSplitter *splitter, CompressFormat format, CsvLineAction action, void *arg);
+int csv_splitter_feed(CsvLineSplitter *splitter, char *data, size_t len);
+int csv_splitter_close(CsvLineSplitter *splitter);
+int csv_read_lines(const char *path, IoMode mode, CsvLineAction action, void *arg, CsvReadStats *stats);
+long io_cached_bytes(const char *path);
+
+#endif // FILE_IO_H
@@ -1,15 +1,23 @@
 // inspector_type1.c
 #include "shared_memory.h"
 #include "config.h"
+#include "journal.h"
+#include "dir_scan.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <unistd.h>
-#include <dirent.h>
+#include <fcntl.h>
 #include <time.h>
 #include <sys/stat.h>
 #include <signal.h>
 
+// Shared state used by the scan action
+SharedMemory *shared_data = NULL;
+sem_t *sem = NULL;
+int inspector_id = 0;
+int unprocessed_fd = -1; // Cached destination directory
+
 // Signal handler for graceful shutdown
 void handle_signal(int sig) {
     printf("Inspector Type1 received signal %d. Cleaning up and exiting.\n", sig);
@@ -17,26 +25,63 @@ void handle_signal(int sig) {
     exit(0);
 }
 
+// Scan action: called for every file older than the threshold
+void inspect_file(DirScanner *scanner, const char *name) {
+    // Never race a calculator: a file it has claimed is left alone
+    int file_index = atoi(name);
+    sem_wait(sem);
+    int expired = file_try_expire(shared_data, file_index) == 0;
+    if (!expired) {
+        shared_data->expire_conflicts++;
+    }
+    sem_post(sem);
+    if (!expired) {
+        printf("Inspector Type1 %d: Skipped %s, claimed by a calculator\n", inspector_id, name);
+        return;
+    }
+
+    int moved = dir_scan_move(scanner, name, unprocessed_fd) == 0;
+    if (!moved) {
+        perror("Error moving file to UnProcessed");
+    }
+    sem_wait(sem);
+    file_release(shared_data, file_index);
+    if (moved) {
+        shared_data->files_moved_to_unprocessed++;
+    }
+    sem_post(sem);
+
+    if (moved) {
+        journal_append(JOURNAL_MOVED_UNPROCESSED, file_index, inspector_id);
+        printf("Inspector Type1 %d: Moved %s to UnProcessed (deadline missed)\n", inspector_id, name);
+    }
+}
+
 int main(int argc, char *argv[]) {
     if (argc != 2) {
         fprintf(stderr, "Usage: %s <inspector_id>\n", argv[0]);
         exit(1);
     }
 
-    int inspector_id = atoi(argv[1]);
+    inspector_id = atoi(argv[1]);
 
     // Register signal handlers
     signal(SIGTERM, handle_signal);
     signal(SIGINT, handle_signal);
 
     // Initialize shared memory and semaphore
-    SharedMemory *shared_data = init_shared_memory();
-    sem_t *sem = init_semaphore();
+    shared_data = init_shared_memory();
+    sem = init_semaphore();
 
     // Read configuration
     Config config;
     parse_config("config.txt", &config);
 
+    // Lifecycle events are appended to the shared journal
+    if (config.journal_enabled) {
+        journal_open(config.journal_path);
+    }
+
     // Ensure the UnProcessed directory exists
     struct stat st_dir = {0};
     if (stat("./home/UnProcessed", &st_dir) == -1) {
@@ -46,51 +91,30 @@ int main(int argc, char *argv[]) {
         }
     }
 
+    // Scan with a cached directory descriptor; all lookups and moves are dirfd-relative
+    unprocessed_fd = open("./home/UnProcessed", O_RDONLY | O_DIRECTORY);
+    if (unprocessed_fd == -1) {
+        perror("Error opening UnProcessed directory");
+        exit(1);
+    }
+
+    DirScanner scanner;
+    while (dir_scanner_open(&scanner, "./home") == -1) {
+        sleep(5);
+    }
+
     while (1) {
-        DIR *dir = opendir("./home");
-        if (dir == NULL) {
-            perror("Error opening home directory");
+        long acted_before = scanner.stats.files_acted;
+        if (dir_scan_aged(&scanner, config.type1_threshold_age, inspect_file) == -1) {
             sleep(5);
             continue;
         }
 
-        struct dirent *entry;
-        while ((entry = readdir(dir)) != NULL) {
-            // Skip directories and non-CSV files
-            if (entry->d_type == DT_DIR || !strstr(entry->d_name, ".csv"))
-                continue;
-
-            char filepath[MAX_FILENAME];
-            // Ensure that the file name does not exceed the buffer size
-            snprintf(filepath, sizeof(filepath), "./home/%s", entry->d_name);
-
-            struct stat st;
-            if (stat(filepath, &st) == -1) {
-                perror("Error getting file status");
-                continue;
-            }
-
-            time_t current_time = time(NULL);
-            double age = difftime(current_time, st.st_mtime);
-
-            // If file is older than Type1 threshold
-            if (age > config.type1_threshold_age) {
-                char unprocessed_path[MAX_FILENAME];
-                // Ensure that the file name does not exceed the buffer size for UnProcessed
-                snprintf(unprocessed_path, sizeof(unprocessed_path), "./home/UnProcessed/%s", entry->d_name);
-
-                if (rename(filepath, unprocessed_path) == 0) {
-                    sem_wait(sem);
-                    shared_data->files_moved_to_unprocessed++;
-                    sem_post(sem);
-                    printf("Inspector Type1 %d: Moved %s to UnProcessed\n", inspector_id, entry->d_name);
-                } else {
-                    perror("Error moving file to UnProcessed");
-                }
-            }
+        if (scanner.stats.files_acted > acted_before) {
+            printf("Inspector Type1 %d: %ld entries scanned, %.2f syscalls per file (%ld getdents, %ld statx, %ld moves)\n",
+                   inspector_id, scanner.stats.entries_seen, dir_scan_syscalls_per_file(&scanner.stats),
+                   scanner.stats.getdents_calls, scanner.stats.stat_calls, scanner.stats.act_calls);
         }
-
-        closedir(dir);
         sleep(10); // Inspect every 10 seconds
     }
 
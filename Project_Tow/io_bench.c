@@ -0,0 +1,290 @@
+// io_bench.c
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include "file_io.h"
+
+#define DEFAULT_FILES 20       // Files written and read back per mode
+#define DEFAULT_ROWS 10000     // Rows per file (the largest the default config generates)
+#define DEFAULT_COLUMNS 15     // Columns per file
+#define DEFAULT_DIR "./io_bench_files"
+#define MAX_PATH 512
+#define SWEEP_LEVELS 6         // Levels swept per codec
+
+// What one mode did over every file
+typedef struct {
+    long write_ns;
+    long read_ns;
+    long write_cpu_ns;
+    long read_cpu_ns;
+    long bytes;         // CSV bytes written (and read back), before compression
+    long disk_bytes;    // Bytes the files take on disk
+    long lines;         // Lines the reader handed to its action
+    long cached_write;  // Bytes left in the page cache after writing
+    long cached_read;   // Bytes left in the page cache after reading
+    int direct;         // O_DIRECT was in effect for every file
+} ModeResult;
+
+// Levels swept for each codec, on each library's own scale (LZ4: 0-12, zstd: 1-19)
+static const int sweep_levels[COMPRESS_FORMAT_COUNT][SWEEP_LEVELS] = {
+    [COMPRESS_LZ4] = { 0, 1, 3, 6, 9, 12 },
+    [COMPRESS_ZSTD] = { 1, 3, 6, 9, 12, 19 }
+};
+
+// Names of the codecs as printed
+static const char *codec_names[COMPRESS_FORMAT_COUNT] = { "none", "lz4", "zstd" };
+
+// Function to print usage
+static void usage(const char *program) {
+    fprintf(stderr, "Usage: %s [--files N] [--rows N] [--columns N] [--seed N] [--dir PATH] [--pressure MiB]\n"
+                    "          (--pressure: hold all but MiB of the available memory while benchmarking)\n", program);
+}
+
+// Function to read the monotonic clock in nanoseconds
+static long now_ns(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec * 1000000000L + now.tv_nsec;
+}
+
+// Function to read the CPU time of the process in nanoseconds
+static long cpu_ns(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &now);
+    return now.tv_sec * 1000000000L + now.tv_nsec;
+}
+
+// Function to read how much memory the kernel could hand out without swapping, in MiB (-1 if unknown)
+static long available_mib(void) {
+    FILE *meminfo = fopen("/proc/meminfo", "r");
+    if (meminfo == NULL)
+        return -1;
+    char line[128];
+    long kib = -1;
+    while (fgets(line, sizeof(line), meminfo)) {
+        if (sscanf(line, "MemAvailable: %ld kB", &kib) == 1)
+            break;
+    }
+    fclose(meminfo);
+    return kib < 0 ? -1 : kib / 1024;
+}
+
+// Function to compete with the page cache: hold all but leave_mib of the available memory in touched
+// anonymous pages, which the kernel cannot drop the way it drops cached file pages.
+// Returns the block (NULL when there is nothing to hold) and its size in *held_mib.
+static char *hold_memory(long leave_mib, long *held_mib) {
+    long available = available_mib();
+    *held_mib = available - leave_mib;
+    if (available < 0 || *held_mib <= 0) {
+        *held_mib = 0;
+        return NULL;
+    }
+    char *block = malloc(*held_mib << 20);
+    if (block == NULL) {
+        *held_mib = 0;
+        return NULL;
+    }
+    long page_size = sysconf(_SC_PAGESIZE);
+    for (long offset = 0; offset < *held_mib << 20; offset += page_size)
+        block[offset] = 1;
+    return block;
+}
+
+// Function to build one file's text the way generators write it, so every mode writes the same bytes
+static char *build_csv(int rows, int columns, unsigned int seed, size_t *length) {
+    size_t capacity = columns * 8L + (size_t)rows * (columns * 8 + 1) + 1;
+    char *text = malloc(capacity);
+    if (text == NULL)
+        return NULL;
+    size_t used = 0;
+    for (int c = 0; c < columns; c++) {
+        used += snprintf(text + used, capacity - used, c < columns - 1 ? "Col%d," : "Col%d\n", c);
+    }
+    for (int r = 0; r < rows; r++) {
+        for (int c = 0; c < columns; c++) {
+            if (rand_r(&seed) % 100 < 5) {
+                text[used++] = ','; // Missing data
+            } else {
+                used += snprintf(text + used, capacity - used, "%.2f,", 1.0 + 99.0 * rand_r(&seed) / RAND_MAX);
+            }
+        }
+        text[used++] = '\n';
+    }
+    *length = used;
+    return text;
+}
+
+// Function to count the lines a reader hands over
+static int count_line(char *line, void *arg) {
+    (void)line;
+    (*(long *)arg)++;
+    return 0;
+}
+
+// Function to write every file in one mode and format and read them back; returns 0 on success
+static int run_mode(IoMode mode, CompressFormat format, int level, const char *dir, int files, const char *text,
+                    size_t length, ModeResult *result) {
+    char path[MAX_PATH];
+    const char *extension = compress_extension(format);
+    memset(result, 0, sizeof(*result));
+    result->direct = 1;
+
+    long start = now_ns();
+    long cpu_start = cpu_ns();
+    for (int f = 0; f < files; f++) {
+        snprintf(path, sizeof(path), "%s/%d%s", dir, f, extension);
+        CsvWriter writer;
+        if (csv_writer_open(&writer, path, mode, format, level, (long)length) == -1)
+            return -1;
+        // Appended in pieces the size of a generator row batch, not as one call
+        int failed = 0;
+        for (size_t offset = 0; offset < length && !failed; offset += IO_PLAIN_SIZE) {
+            size_t piece = length - offset < IO_PLAIN_SIZE ? length - offset : IO_PLAIN_SIZE;
+            failed = csv_writer_append(&writer, text + offset, piece) != 0;
+        }
+        result->direct &= writer.direct;
+        if (csv_writer_close(&writer) != 0 || failed)
+            return -1;
+        result->bytes += length;
+    }
+    result->write_ns = now_ns() - start;
+    result->write_cpu_ns = cpu_ns() - cpu_start;
+    for (int f = 0; f < files; f++) {
+        snprintf(path, sizeof(path), "%s/%d%s", dir, f, extension);
+        struct stat st;
+        if (stat(path, &st) == 0)
+            result->disk_bytes += st.st_size;
+        result->cached_write += io_cached_bytes(path);
+    }
+
+    start = now_ns();
+    cpu_start = cpu_ns();
+    for (int f = 0; f < files; f++) {
+        snprintf(path, sizeof(path), "%s/%d%s", dir, f, extension);
+        CsvReadStats stats;
+        if (csv_read_lines(path, mode, count_line, &result->lines, &stats) != 0)
+            return -1;
+    }
+    result->read_ns = now_ns() - start;
+    result->read_cpu_ns = cpu_ns() - cpu_start;
+    for (int f = 0; f < files; f++) {
+        snprintf(path, sizeof(path), "%s/%d%s", dir, f, extension);
+        result->cached_read += io_cached_bytes(path);
+        unlink(path);
+    }
+    return 0;
+}
+
+// Function to sweep each available codec over its levels with buffered I/O: the CPU paid for the bytes
+// saved on disk, with throughput counted in CSV bytes. Returns 0 on success.
+static int run_compression_sweep(const char *dir, int files, const char *text, size_t length) {
+    printf("\nCompression with buffered I/O (MB/s of CSV text, CPU ms over all files):\n");
+    printf("%-6s %6s %8s %14s %12s %14s %12s\n", "codec", "level", "ratio", "write CPU ms", "write MB/s",
+           "read CPU ms", "read MB/s");
+    for (int format = 0; format < COMPRESS_FORMAT_COUNT; format++) {
+        if (format != COMPRESS_NONE && !compress_available(format)) {
+            printf("%-6s (library not found, skipped)\n", codec_names[format]);
+            continue;
+        }
+        int levels = format == COMPRESS_NONE ? 1 : SWEEP_LEVELS;
+        for (int l = 0; l < levels; l++) {
+            int level = sweep_levels[format][l];
+            ModeResult result;
+            if (run_mode(IO_BUFFERED, format, level, dir, files, text, length, &result) != 0) {
+                fprintf(stderr, "Error benchmarking %s at level %d\n", codec_names[format], level);
+                return -1;
+            }
+            printf("%-6s %6d %7.2fx %14.1f %12.1f %14.1f %12.1f\n",
+                   codec_names[format], level,
+                   (double)result.bytes / result.disk_bytes, result.write_cpu_ns / 1e6,
+                   result.bytes * 1e3 / result.write_ns, result.read_cpu_ns / 1e6,
+                   result.bytes * 1e3 / result.read_ns);
+        }
+    }
+    return 0;
+}
+
+// Main function
+int main(int argc, char *argv[]) {
+    int files = DEFAULT_FILES;
+    int rows = DEFAULT_ROWS;
+    int columns = DEFAULT_COLUMNS;
+    unsigned int seed = 1;
+    const char *dir = DEFAULT_DIR;
+    long pressure_mib = -1;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--files") == 0 && i + 1 < argc) {
+            files = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--rows") == 0 && i + 1 < argc) {
+            rows = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--columns") == 0 && i + 1 < argc) {
+            columns = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+            seed = (unsigned int)strtoul(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--dir") == 0 && i + 1 < argc) {
+            dir = argv[++i];
+        } else if (strcmp(argv[i], "--pressure") == 0 && i + 1 < argc) {
+            pressure_mib = atol(argv[++i]);
+        } else {
+            usage(argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+    if (files < 1 || rows < 1 || columns < 1 || (pressure_mib < 0 && pressure_mib != -1)) {
+        usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+    if (mkdir(dir, 0755) != 0 && access(dir, W_OK) != 0) {
+        perror("Error creating bench directory");
+        return EXIT_FAILURE;
+    }
+
+    size_t length;
+    char *text = build_csv(rows, columns, seed, &length);
+    if (text == NULL) {
+        fprintf(stderr, "Error allocating CSV text\n");
+        return EXIT_FAILURE;
+    }
+
+    // Under pressure the files compete for what is left once a hog holds the rest of the memory
+    char *hog = NULL;
+    long held_mib = 0;
+    if (pressure_mib >= 0) {
+        hog = hold_memory(pressure_mib, &held_mib);
+        printf("Memory pressure: holding %ld MiB, %ld MiB left available\n", held_mib, available_mib());
+    }
+
+    // Reads follow the writes at once, as a calculator picks up a fresh file
+    printf("I/O modes: %d files of %d rows x %d columns (%ld KiB each) in %s\n",
+           files, rows, columns, (long)length / 1024, dir);
+    printf("%-9s %8s %12s %12s %16s %16s %10s\n", "mode", "direct", "write MB/s", "read MB/s",
+           "cached KiB/wr", "cached KiB/rd", "lines");
+    IoMode modes[] = { IO_BUFFERED, IO_DIRECT, IO_DONTNEED };
+    for (int m = 0; m < 3; m++) {
+        ModeResult result;
+        if (run_mode(modes[m], COMPRESS_NONE, 0, dir, files, text, length, &result) != 0) {
+            fprintf(stderr, "Error benchmarking %s I/O\n", io_mode_name(modes[m]));
+            free(hog);
+            free(text);
+            return EXIT_FAILURE;
+        }
+        printf("%-9s %8s %12.1f %12.1f %16ld %16ld %10ld\n", io_mode_name(modes[m]), result.direct ? "yes" : "no",
+               result.bytes * 1e3 / result.write_ns, result.bytes * 1e3 / result.read_ns,
+               result.cached_write / 1024, result.cached_read / 1024, result.lines);
+    }
+
+    // The codec sweep is about CPU, not about the cache: it runs without the hog
+    free(hog);
+    if (pressure_mib < 0 && run_compression_sweep(dir, files, text, length) != 0) {
+        free(text);
+        return EXIT_FAILURE;
+    }
+
+    free(text);
+    rmdir(dir);
+    return 0;
+}
@@ -0,0 +1,343 @@
+// journal.c
+#include "journal.h"
+#include "compress.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <stddef.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <dirent.h>
+#include <libgen.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#define JOURNAL_READ_BATCH 4096
+
+// Append descriptor shared by every journal_append call in this process
+static int journal_fd = -1;
+
+// Function to compute the FNV-1a checksum of a record (excluding the checksum field)
+static uint32_t journal_checksum(const JournalRecord *record) {
+    const unsigned char *bytes = (const unsigned char *)record;
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < offsetof(JournalRecord, checksum); i++) {
+        hash ^= bytes[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+// Function to fill in a record with the current timestamp and checksum
+static void journal_fill_record(JournalRecord *record, JournalEventType type, int file_index, int value) {
+    struct timespec now;
+    clock_gettime(CLOCK_REALTIME, &now);
+
+    memset(record, 0, sizeof(*record));
+    record->magic = JOURNAL_MAGIC;
+    record->type = type;
+    record->file_index = file_index;
+    record->value = value;
+    record->timestamp = (int64_t)now.tv_sec * 1000000000LL + now.tv_nsec;
+    record->checksum = journal_checksum(record);
+}
+
+// Open the journal for appending (one record per write, so concurrent writers never interleave)
+int journal_open(const char *path) {
+    journal_fd = open(path, O_WRONLY | O_CREAT | O_APPEND, 0644);
+    if (journal_fd == -1) {
+        perror("Error opening journal");
+        return -1;
+    }
+    return 0;
+}
+
+// Append a lifecycle event; durability is provided by the supervisor's periodic group commit
+void journal_append(JournalEventType type, int file_index, int actor_id) {
+    if (journal_fd == -1)
+        return;
+
+    JournalRecord record;
+    journal_fill_record(&record, type, file_index, actor_id);
+    if (write(journal_fd, &record, sizeof(record)) != sizeof(record)) {
+        perror("Error appending to journal");
+    }
+}
+
+// Group commit: a single fdatasync covers every record appended by every process since the last call
+int journal_sync() {
+    if (journal_fd == -1)
+        return 0;
+    if (fdatasync(journal_fd) == -1) {
+        perror("Error syncing journal");
+        return -1;
+    }
+    return 0;
+}
+
+// Number of records currently in the journal
+long journal_record_count() {
+    struct stat st;
+    if (journal_fd == -1 || fstat(journal_fd, &st) == -1)
+        return 0;
+    return st.st_size / (long)sizeof(JournalRecord);
+}
+
+// Close the journal
+void journal_close() {
+    if (journal_fd != -1) {
+        close(journal_fd);
+        journal_fd = -1;
+    }
+}
+
+// Function to record the last known state of a file, growing the state table as needed
+static int journal_set_state(unsigned char **states, int *capacity, int file_index, unsigned char state) {
+    if (file_index < 0)
+        return 0;
+    if (file_index >= *capacity) {
+        int new_capacity = *capacity ? *capacity : 1024;
+        while (new_capacity <= file_index)
+            new_capacity *= 2;
+        unsigned char *grown = realloc(*states, new_capacity);
+        if (grown == NULL) {
+            perror("Error growing journal state table");
+            return -1;
+        }
+        memset(grown + *capacity, 0, new_capacity - *capacity);
+        *states = grown;
+        *capacity = new_capacity;
+    }
+    (*states)[file_index] = state;
+    return 0;
+}
+
+// Function to rewrite the journal as a single checkpoint of the rebuilt counters
+static int journal_compact(const char *path, const long counters[JOURNAL_COUNTER_COUNT]) {
+    char tmp_path[MAX_FILENAME];
+    snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", path);
+
+    int fd = open(tmp_path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd == -1) {
+        perror("Error creating compacted journal");
+        return -1;
+    }
+
+    JournalRecord checkpoint[JOURNAL_COUNTER_COUNT];
+    for (int c = 0; c < JOURNAL_COUNTER_COUNT; c++) {
+        journal_fill_record(&checkpoint[c], JOURNAL_CHECKPOINT, c, (int)counters[c]);
+    }
+    if (write(fd, checkpoint, sizeof(checkpoint)) != sizeof(checkpoint) || fdatasync(fd) == -1) {
+        perror("Error writing compacted journal");
+        close(fd);
+        unlink(tmp_path);
+        return -1;
+    }
+    close(fd);
+
+    if (rename(tmp_path, path) == -1) {
+        perror("Error replacing journal");
+        unlink(tmp_path);
+        return -1;
+    }
+
+    // Make the rename itself durable
+    char dir_path[MAX_FILENAME];
+    snprintf(dir_path, sizeof(dir_path), "%s", path);
+    int dir_fd = open(dirname(dir_path), O_RDONLY | O_DIRECTORY);
+    if (dir_fd != -1) {
+        fsync(dir_fd);
+        close(dir_fd);
+    }
+    return 0;
+}
+
+// Function to move file idx between directories, whatever its CSV format. Returns 0 if moved.
+static int move_stranded_file(const char *from_dir, const char *to_dir, int idx) {
+    for (int format = 0; format < COMPRESS_FORMAT_COUNT; format++) {
+        char from_path[MAX_FILENAME];
+        char to_path[MAX_FILENAME];
+        snprintf(from_path, sizeof(from_path), "%s/%d%s", from_dir, idx, compress_extension(format));
+        snprintf(to_path, sizeof(to_path), "%s/%d%s", to_dir, idx, compress_extension(format));
+        if (rename(from_path, to_path) == 0)
+            return 0;
+    }
+    return -1;
+}
+
+// Replay the journal: rebuild the shared counters, requeue files stranded in Processing
+// or .inprogress, remove partial files from .inprogress and compact the journal down to a checkpoint. Must run before any worker is started.
+int journal_recover(const char *path, SharedMemory *shared_data) {
+    int fd = open(path, O_RDWR | O_APPEND);
+    if (fd == -1) {
+        if (errno == ENOENT)
+            return 0; // First run, nothing to replay
+        perror("Error opening journal for recovery");
+        return -1;
+    }
+
+    long counters[JOURNAL_COUNTER_COUNT] = {0};
+    unsigned char *states = NULL;
+    int capacity = 0;
+    long replayed = 0;
+    int torn = 0;
+
+    JournalRecord *batch = malloc(sizeof(JournalRecord) * JOURNAL_READ_BATCH);
+    if (batch == NULL) {
+        perror("Error allocating journal read buffer");
+        close(fd);
+        return -1;
+    }
+
+    ssize_t bytes;
+    while (!torn && (bytes = read(fd, batch, sizeof(JournalRecord) * JOURNAL_READ_BATCH)) > 0) {
+        int count = bytes / sizeof(JournalRecord);
+        if (bytes % sizeof(JournalRecord) != 0)
+            torn = 1; // Partial record at the tail
+
+        for (int i = 0; i < count; i++) {
+            JournalRecord *record = &batch[i];
+            if (record->magic != JOURNAL_MAGIC || record->checksum != journal_checksum(record)) {
+                torn = 1; // Everything after a corrupt record is discarded
+                break;
+            }
+            replayed++;
+
+            int idx = record->file_index;
+            unsigned char previous = (idx >= 0 && idx < capacity) ? states[idx] : 0;
+            switch (record->type) {
+                case JOURNAL_CHECKPOINT:
+                    if (idx >= 0 && idx < JOURNAL_COUNTER_COUNT)
+                        counters[idx] = record->value;
+                    continue;
+                case JOURNAL_GENERATED:
+                    if (idx + 1 > counters[JOURNAL_COUNTER_GENERATED])
+                        counters[JOURNAL_COUNTER_GENERATED] = idx + 1;
+                    break;
+                case JOURNAL_CLAIMED:
+                    counters[JOURNAL_COUNTER_PROCESSED]++;
+                    break;
+                case JOURNAL_PROCESSED:
+                    counters[JOURNAL_COUNTER_MOVED_PROCESSED]++;
+                    break;
+                case JOURNAL_MOVED_UNPROCESSED:
+                    counters[JOURNAL_COUNTER_MOVED_UNPROCESSED]++;
+                    break;
+                case JOURNAL_MOVED_BACKUP:
+                    counters[JOURNAL_COUNTER_MOVED_BACKUP]++;
+                    break;
+                case JOURNAL_DELETED:
+                    counters[JOURNAL_COUNTER_DELETED]++;
+                    break;
+                case JOURNAL_CAUGHT_UP:
+                    counters[JOURNAL_COUNTER_PROCESSED]++;
+                    counters[JOURNAL_COUNTER_MOVED_PROCESSED]++;
+                    counters[JOURNAL_COUNTER_RECOVERED]++;
+                    break;
+                case JOURNAL_REQUEUED:
+                    if (previous == JOURNAL_CLAIMED)
+                        counters[JOURNAL_COUNTER_PROCESSED]--;
+                    break;
+                default:
+                    continue;
+            }
+            journal_set_state(&states, &capacity, idx,
+                              record->type == JOURNAL_REQUEUED ? JOURNAL_GENERATED : record->type);
+        }
+    }
+    free(batch);
+
+    // Files last seen as generated or claimed may be sitting in Processing after a crash
+    int requeued = 0;
+    for (int idx = 0; idx < capacity; idx++) {
+        if (states[idx] != JOURNAL_GENERATED && states[idx] != JOURNAL_CLAIMED)
+            continue;
+
+        if (move_stranded_file("./home/Processing", "./home", idx) != 0)
+            continue;
+
+        JournalRecord record;
+        journal_fill_record(&record, JOURNAL_REQUEUED, idx, 0);
+        if (write(fd, &record, sizeof(record)) != sizeof(record)) {
+            perror("Error appending to journal");
+        }
+        if (states[idx] == JOURNAL_CLAIMED)
+            counters[JOURNAL_COUNTER_PROCESSED]--;
+        requeued++;
+    }
+    // Anything else in Processing was taken by the catch-up lane, whose claims are not journaled and
+    // whose UnProcessed state an earlier compaction may have forgotten: hand it back, its state is unchanged
+    int returned = 0;
+    DIR *processing = opendir("./home/Processing");
+    if (processing != NULL) {
+        struct dirent *entry;
+        while ((entry = readdir(processing)) != NULL) {
+            if (entry->d_type == DT_DIR || !is_csv_name(entry->d_name))
+                continue;
+
+            char processing_path[MAX_FILENAME];
+            char unprocessed_path[MAX_FILENAME];
+            snprintf(processing_path, sizeof(processing_path), "./home/Processing/%s", entry->d_name);
+            snprintf(unprocessed_path, sizeof(unprocessed_path), "./home/UnProcessed/%s", entry->d_name);
+            if (rename(processing_path, unprocessed_path) == 0)
+                returned++;
+        }
+        closedir(processing);
+    }
+
+    // Files left in .inprogress: complete ones (journaled as generated) were about to be published,
+    // the rest were cut short by a stopped or failed generator and are removed
+    int removed = 0;
+    DIR *inprogress = opendir("./home/.inprogress");
+    if (inprogress != NULL) {
+        struct dirent *entry;
+        while ((entry = readdir(inprogress)) != NULL) {
+            if (entry->d_type == DT_DIR || !is_csv_name(entry->d_name))
+                continue;
+
+            int idx = atoi(entry->d_name);
+            char stream_path[MAX_FILENAME];
+            char home_path[MAX_FILENAME];
+            snprintf(stream_path, sizeof(stream_path), "./home/.inprogress/%s", entry->d_name);
+            snprintf(home_path, sizeof(home_path), "./home/%s", entry->d_name);
+            unsigned char state = (idx >= 0 && idx < capacity) ? states[idx] : 0;
+            if (state != JOURNAL_GENERATED) {
+                if (unlink(stream_path) == 0) {
+                    if (state == JOURNAL_CLAIMED)
+                        counters[JOURNAL_COUNTER_PROCESSED]--;
+                    removed++;
+                }
+                continue;
+            }
+            if (rename(stream_path, home_path) != 0)
+                continue;
+
+            JournalRecord record;
+            journal_fill_record(&record, JOURNAL_REQUEUED, idx, 0);
+            if (write(fd, &record, sizeof(record)) != sizeof(record)) {
+                perror("Error appending to journal");
+            }
+            requeued++;
+        }
+        closedir(inprogress);
+    }
+
+    if (requeued > 0)
+        fdatasync(fd);
+    close(fd);
+    free(states);
+
+    shared_data->files_generated = counters[JOURNAL_COUNTER_GENERATED];
+    shared_data->files_processed = counters[JOURNAL_COUNTER_PROCESSED];
+    shared_data->files_moved_to_processed = counters[JOURNAL_COUNTER_MOVED_PROCESSED];
+    shared_data->files_moved_to_unprocessed = counters[JOURNAL_COUNTER_MOVED_UNPROCESSED];
+    shared_data->files_moved_to_backup = counters[JOURNAL_COUNTER_MOVED_BACKUP];
+    shared_data->files_deleted = counters[JOURNAL_COUNTER_DELETED];
+    shared_data->files_recovered = counters[JOURNAL_COUNTER_RECOVERED];
+
+    printf("Journal: replayed %ld records%s, requeued %d stranded files, returned %d to UnProcessed, removed %d partial files\n",
+           replayed, torn ? " (discarded torn tail)" : "", requeued, returned, removed);
+
+    return journal_compact(path, counters);
+}
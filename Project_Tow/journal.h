@@ -0,0 +1,54 @@
+// journal.h
+#ifndef JOURNAL_H
+#define JOURNAL_H
+
+#include "shared_memory.h"
+#include <stdint.h>
+
+#define JOURNAL_MAGIC 0x4A524E4C // "JRNL"
+
+// File lifecycle events recorded in the journal
+typedef enum {
+    JOURNAL_GENERATED = 1,      // Generator finished writing ./home/<n>.csv
+    JOURNAL_CLAIMED,            // Calculator moved the file to Processing
+    JOURNAL_PROCESSED,          // Calculator moved the file to Processed
+    JOURNAL_MOVED_UNPROCESSED,  // Type1 inspector moved the file to UnProcessed
+    JOURNAL_MOVED_BACKUP,       // Type2 inspector moved the file to Backup
+    JOURNAL_DELETED,            // Type3 inspector deleted the file from Backup
+    JOURNAL_REQUEUED,           // Recovery moved a stranded file back to ./home
+    JOURNAL_CHECKPOINT,         // Counter snapshot written when the journal is compacted
+    JOURNAL_CAUGHT_UP           // Catch-up lane moved a file from UnProcessed to Processed
+} JournalEventType;
+
+// Counters carried by checkpoint records (file_index holds the counter id)
+typedef enum {
+    JOURNAL_COUNTER_GENERATED = 0,
+    JOURNAL_COUNTER_PROCESSED,
+    JOURNAL_COUNTER_MOVED_PROCESSED,
+    JOURNAL_COUNTER_MOVED_UNPROCESSED,
+    JOURNAL_COUNTER_MOVED_BACKUP,
+    JOURNAL_COUNTER_DELETED,
+    JOURNAL_COUNTER_RECOVERED,
+    JOURNAL_COUNTER_COUNT
+} JournalCounter;
+
+// Fixed-size on-disk record (32 bytes)
+typedef struct {
+    uint32_t magic;
+    uint32_t type;
+    int32_t file_index;
+    int32_t value;       // Actor id for lifecycle events, counter value for checkpoints
+    int64_t timestamp;   // Nanoseconds since the epoch
+    uint32_t reserved;
+    uint32_t checksum;   // FNV-1a over the preceding fields
+} JournalRecord;
+
+// Function prototypes
+int journal_open(const char *path);
+void journal_append(JournalEventType type, int file_index, int actor_id);
+int journal_sync();
+long journal_record_count();
+void journal_close();
+int journal_recover(const char *path, SharedMemory *shared_data);
+
+#endif // JOURNAL_H
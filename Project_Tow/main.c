@@ -1,6 +1,9 @@
 // main.c
 #include "shared_memory.h"
 #include "config.h"
+#include "journal.h"
+#include "placement.h"
+#include "workload.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <sys/stat.h>
@@ -13,8 +16,13 @@
 // Global array to hold child PIDs
 pid_t *children_pids = NULL;
 int total_children = 0;
+int child_count = 0;
 Config config;
 
+// Placement sampling for every child, and per-stage migration totals
+PlacementSample *children_samples = NULL;
+StagePlacementStats stage_stats[STAGE_COUNT];
+
 // Directories
 const char *directories[] = {
     "./home",
@@ -22,7 +30,8 @@ const char *directories[] = {
     "./home/Processed",
     "./home/Backup",
     "./home/Deleted",
-    "./home/Processing" 
+    "./home/Processing",
+    "./home/.inprogress"
 };
 
 // Function to create directories if they do not already exist
@@ -38,21 +47,63 @@ void create_directory_if_needed(const char *dir_path) {
     }
 }
 
+// Function to remember a spawned child and start sampling its CPU placement
+void record_child(pid_t pid, WorkerStage stage) {
+    children_pids[child_count] = pid;
+    placement_sample_init(&children_samples[child_count], pid, stage);
+    child_count++;
+}
+
+// Function to print per-stage scheduler migrations
+void log_stage_migrations() {
+    for (int s = 0; s < STAGE_COUNT; s++) {
+        printf("[Placement] %s: %ld CPU migrations (%ld cross-node)\n",
+               stage_name(s), stage_stats[s].migrations, stage_stats[s].cross_node_migrations);
+    }
+}
+
+// Function to print how close calculator claims came to the Inspector Type1 deadline
+void log_deadlines(SharedMemory *shared_data, sem_t *sem) {
+    sem_wait(sem);
+    long claims = shared_data->deadline_claims;
+    long late = shared_data->deadline_late_claims;
+    long total_slack = shared_data->deadline_slack_total_ms;
+    long min_slack = shared_data->deadline_slack_min_ms;
+    long conflicts = shared_data->expire_conflicts;
+    int lost = shared_data->files_moved_to_unprocessed;
+    int recovered = shared_data->files_recovered;
+    long preemptions = shared_data->catchup_preemptions;
+    long failures = shared_data->catchup_failures;
+    sem_post(sem);
+
+    printf("Deadlines: %d files lost to UnProcessed, %ld inspector/calculator conflicts avoided\n", lost, conflicts);
+    printf("Catch-up: %d of them recovered, %ld catch-up runs preempted by fresh work, %ld unreadable files moved to Backup\n",
+           recovered, preemptions, failures);
+    if (claims > 0) {
+        printf("Deadlines: %ld claims, average slack %ld ms, minimum slack %ld ms, %ld claimed late\n",
+               claims, total_slack / claims, min_slack, late);
+    }
+}
+
 // Function to handle termination signals for graceful shutdown
 void handle_signal(int sig) {
     printf("Received signal %d. Terminating all child processes.\n", sig);
     // Terminate all child processes
-    for (int i = 0; i < total_children; i++) {
+    for (int i = 0; i < child_count; i++) {
         if (kill(children_pids[i], SIGTERM) == -1) {
             perror("Error terminating child process");
         }
     }
 
     // Wait for all child processes to terminate
-    for (int i = 0; i < total_children; i++) {
+    for (int i = 0; i < child_count; i++) {
         waitpid(children_pids[i], NULL, 0);
     }
 
+    // Final group commit so every event written by the children is durable
+    journal_sync();
+    journal_close();
+
     // Cleanup shared memory and semaphore
     cleanup_shared_memory(NULL); // Assuming cleanup_shared_memory checks if NULL
     cleanup_semaphore(NULL);     // Assuming cleanup_semaphore checks if NULL
@@ -74,17 +125,37 @@ int main(int argc, char *argv[]) {
         create_directory_if_needed(directories[i]);
     }
 
+    // Replay the journal to rebuild counters and requeue stranded files before any worker starts
+    if (config.journal_enabled) {
+        if (journal_recover(config.journal_path, shared_data) != 0) {
+            fprintf(stderr, "Journal recovery failed, continuing with current counters\n");
+        }
+        journal_open(config.journal_path);
+    }
+
+    // Files left in ./home by a previous run are claimed through the fallback scan
+    file_table_reset(shared_data);
+
+    // Common time origin for workload arrival times; a new recording starts from an empty trace
+    struct timespec run_start;
+    clock_gettime(CLOCK_REALTIME, &run_start);
+    shared_data->run_start_ms = (long)run_start.tv_sec * 1000 + run_start.tv_nsec / 1000000;
+    if (config.workload_mode == WORKLOAD_RECORD) {
+        workload_reset(config.workload_file);
+    }
+
     // Allocate memory for child PIDs
     total_children = config.num_generators + config.num_calculators +
-                     config.inspectors_type1 + config.inspectors_type2 + config.inspectors_type3;
+                     config.inspectors_type1 + config.inspectors_type2 + config.inspectors_type3 +
+                     1; // Visualization
     children_pids = malloc(sizeof(pid_t) * total_children);
-    if (children_pids == NULL) {
+    children_samples = malloc(sizeof(PlacementSample) * total_children);
+    if (children_pids == NULL || children_samples == NULL) {
         perror("Error allocating memory for child PIDs");
         cleanup_shared_memory(shared_data);
         cleanup_semaphore(sem);
         exit(1);
     }
-    int child_index = 0;
 
     // Start File Generators
     for (int i = 0; i < config.num_generators; i++) {
@@ -93,12 +164,13 @@ int main(int argc, char *argv[]) {
             // Child process
             char generator_id_str[12]; // Increased buffer size
             snprintf(generator_id_str, sizeof(generator_id_str), "%d", i);
+            apply_stage_placement(&config, STAGE_GENERATOR);
             execl("./file_generator", "./file_generator", generator_id_str, NULL);
             perror("Error executing file_generator");
             exit(1);
         } else if (pid > 0) {
             // Parent process
-            children_pids[child_index++] = pid;
+            record_child(pid, STAGE_GENERATOR);
         } else {
             perror("Error forking generator");
         }
@@ -111,12 +183,13 @@ int main(int argc, char *argv[]) {
             // Child process
             char calculator_id_str[12]; // Increased buffer size
             snprintf(calculator_id_str, sizeof(calculator_id_str), "%d", i);
+            apply_stage_placement(&config, STAGE_CALCULATOR);
             execl("./calculator", "./calculator", calculator_id_str, NULL);
             perror("Error executing calculator");
             exit(1);
         } else if (pid > 0) {
             // Parent process
-            children_pids[child_index++] = pid;
+            record_child(pid, STAGE_CALCULATOR);
         } else {
             perror("Error forking calculator");
         }
@@ -129,12 +202,13 @@ int main(int argc, char *argv[]) {
             // Child process
             char inspector_id_str[12]; // Increased buffer size
             snprintf(inspector_id_str, sizeof(inspector_id_str), "%d", i);
+            apply_stage_placement(&config, STAGE_INSPECTOR);
             execl("./inspector_type1", "./inspector_type1", inspector_id_str, NULL);
             perror("Error executing inspector_type1");
             exit(1);
         } else if (pid > 0) {
             // Parent process
-            children_pids[child_index++] = pid;
+            record_child(pid, STAGE_INSPECTOR);
         } else {
             perror("Error forking inspector_type1");
         }
@@ -147,12 +221,13 @@ int main(int argc, char *argv[]) {
             // Child process
             char inspector_id_str[12]; // Increased buffer size
             snprintf(inspector_id_str, sizeof(inspector_id_str), "%d", i);
+            apply_stage_placement(&config, STAGE_INSPECTOR);
             execl("./inspector_type2", "./inspector_type2", inspector_id_str, NULL);
             perror("Error executing inspector_type2");
             exit(1);
         } else if (pid > 0) {
             // Parent process
-            children_pids[child_index++] = pid;
+            record_child(pid, STAGE_INSPECTOR);
         } else {
             perror("Error forking inspector_type2");
         }
@@ -165,12 +240,13 @@ int main(int argc, char *argv[]) {
             // Child process
             char inspector_id_str[12]; // Increased buffer size
             snprintf(inspector_id_str, sizeof(inspector_id_str), "%d", i);
+            apply_stage_placement(&config, STAGE_INSPECTOR);
             execl("./inspector_type3", "./inspector_type3", inspector_id_str, NULL);
             perror("Error executing inspector_type3");
             exit(1);
         } else if (pid > 0) {
             // Parent process
-            children_pids[child_index++] = pid;
+            record_child(pid, STAGE_INSPECTOR);
         } else {
             perror("Error forking inspector_type3");
         }
@@ -195,27 +271,57 @@ int main(int argc, char *argv[]) {
         exit(1);
     } else if (viz_pid > 0) {
         // Parent process
-        children_pids[child_index++] = viz_pid;
+        record_child(viz_pid, STAGE_VISUALIZATION);
     } else {
         perror("Error forking visualization");
     }
 
     // Monitor termination conditions
     time_t start_time = time(NULL);
+    int tick_ms = config.journal_enabled ? config.journal_sync_interval_ms : 1000;
+    long journal_commits = 0;
+    long journal_synced = journal_record_count(); // Records covered by the last group commit
+    time_t last_placement_log = start_time;
+    int history_elapsed_ms = 0;
     while (1) {
-        sleep(1); // Check every second
+        usleep(tick_ms * 1000); // Check every tick
+
+        // Group commit of all journal records appended since the previous tick (none: nothing to flush)
+        long journal_records = config.journal_enabled ? journal_record_count() : 0;
+        if (journal_records > journal_synced && journal_sync() == 0) {
+            journal_commits++;
+            journal_synced = journal_records;
+        }
+
+        // Sample where every child ran since the previous tick
+        for (int i = 0; i < child_count; i++) {
+            placement_sample_update(&children_samples[i], stage_stats);
+        }
 
         // Calculate elapsed time in minutes
         time_t current_time = time(NULL);
+        if (difftime(current_time, last_placement_log) >= 10) {
+            log_stage_migrations();
+            last_placement_log = current_time;
+        }
         double elapsed_minutes = difftime(current_time, start_time) / 60.0;
 
         // Fetch shared counters
+        CounterSample sample;
         sem_wait(sem);
-        int processed = shared_data->files_processed;
-        int not_processed = shared_data->files_generated - shared_data->files_processed;
-        int backup = shared_data->files_moved_to_backup;
-        int deleted = shared_data->files_deleted;
+        snapshot_counters(shared_data, &sample);
         sem_post(sem);
+        int processed = sample.files_processed;
+        int not_processed = sample.files_generated - sample.files_processed;
+        int backup = sample.files_moved_to_backup;
+        int deleted = sample.files_deleted;
+
+        // Publish one history sample per second for observers
+        history_elapsed_ms += tick_ms;
+        if (history_elapsed_ms >= 1000) {
+            history_append(shared_data, &sample);
+            history_elapsed_ms = 0;
+        }
 
         // Check termination conditions
         if (processed > config.threshold_files_processed ||
@@ -230,6 +336,17 @@ int main(int argc, char *argv[]) {
             printf("Files Moved to Backup: %d (Threshold: %d)\n", backup, config.threshold_files_backup);
             printf("Files Deleted: %d (Threshold: %d)\n", deleted, config.threshold_files_deleted);
             printf("Elapsed Time: %.2f minutes (Limit: %d minutes)\n", elapsed_minutes, config.runtime_limit_minutes);
+            if (elapsed_minutes > 0) {
+                printf("Useful Throughput: %.2f files/minute moved to Processed\n",
+                       sample.files_moved_to_processed / elapsed_minutes);
+            }
+            if (config.journal_enabled) {
+                long records = journal_record_count();
+                printf("Journal: %ld records, %ld group commits (%.1f records per fsync)\n",
+                       records, journal_commits, journal_commits ? (double)records / journal_commits : 0.0);
+            }
+            log_deadlines(shared_data, sem);
+            log_stage_migrations();
             printf("Terminating all child processes...\n\n");
 
             handle_signal(SIGTERM);
@@ -240,6 +357,7 @@ int main(int argc, char *argv[]) {
     cleanup_shared_memory(shared_data);
     cleanup_semaphore(sem);
     free(children_pids);
+    free(children_samples);
 
     return 0;
 }
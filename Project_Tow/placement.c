@@ -0,0 +1,225 @@
+// placement.c
+#define _GNU_SOURCE
+#include "placement.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sched.h>
+#include <dirent.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+
+#ifndef MPOL_PREFERRED
+#define MPOL_PREFERRED 1
+#endif
+#ifndef MPOL_BIND
+#define MPOL_BIND 2
+#endif
+
+#define MAX_NUMA_NODES 1024
+#define MAX_TRACKED_CPUS 1024
+#define BITS_PER_LONG (8 * sizeof(unsigned long))
+
+// Cached CPU -> NUMA node mapping (-2 = not looked up yet)
+static int cpu_nodes[MAX_TRACKED_CPUS];
+static int cpu_nodes_initialized = 0;
+
+const char *stage_name(WorkerStage stage) {
+    switch (stage) {
+        case STAGE_GENERATOR: return "generators";
+        case STAGE_CALCULATOR: return "calculators";
+        case STAGE_INSPECTOR: return "inspectors";
+        case STAGE_VISUALIZATION: return "visualization";
+        default: return "unknown";
+    }
+}
+
+// Function to parse a list such as "0-3,8,10-11", calling set_bit for every member
+static int parse_id_list(const char *list, int max_id, void (*set_bit)(int id, void *target), void *target) {
+    int count = 0;
+    const char *p = list;
+    while (*p) {
+        char *end;
+        long first = strtol(p, &end, 10);
+        if (end == p)
+            return -1;
+        long last = first;
+        if (*end == '-') {
+            p = end + 1;
+            last = strtol(p, &end, 10);
+            if (end == p)
+                return -1;
+        }
+        for (long id = first; id <= last && id < max_id; id++) {
+            set_bit((int)id, target);
+            count++;
+        }
+        p = (*end == ',') ? end + 1 : end;
+        if (*end != ',' && *end != '\0')
+            return -1;
+    }
+    return count;
+}
+
+static void set_cpu_bit(int id, void *target) {
+    CPU_SET(id, (cpu_set_t *)target);
+}
+
+static void set_node_bit(int id, void *target) {
+    ((unsigned long *)target)[id / BITS_PER_LONG] |= 1UL << (id % BITS_PER_LONG);
+}
+
+// Apply the configured CPU affinity and memory policy for a stage. Called in the child
+// between fork and exec; both settings are inherited across execve.
+void apply_stage_placement(const Config *config, WorkerStage stage) {
+    const char *cpus = "";
+    const char *nodes = "";
+    switch (stage) {
+        case STAGE_GENERATOR:
+            cpus = config->cpus_generators;
+            nodes = config->numa_generators;
+            break;
+        case STAGE_CALCULATOR:
+            cpus = config->cpus_calculators;
+            nodes = config->numa_calculators;
+            break;
+        case STAGE_INSPECTOR:
+            cpus = config->cpus_inspectors;
+            nodes = config->numa_inspectors;
+            break;
+        default:
+            return; // Visualization is left to the scheduler
+    }
+
+    if (cpus[0] != '\0') {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        if (parse_id_list(cpus, CPU_SETSIZE, set_cpu_bit, &set) <= 0) {
+            fprintf(stderr, "Invalid CPU list for %s: %s\n", stage_name(stage), cpus);
+        } else if (sched_setaffinity(0, sizeof(set), &set) == -1) {
+            perror("Error setting CPU affinity");
+        }
+    }
+
+    if (nodes[0] != '\0') {
+        unsigned long mask[MAX_NUMA_NODES / BITS_PER_LONG] = {0};
+        if (parse_id_list(nodes, MAX_NUMA_NODES, set_node_bit, mask) <= 0) {
+            fprintf(stderr, "Invalid NUMA node list for %s: %s\n", stage_name(stage), nodes);
+            return;
+        }
+
+        int mode = MPOL_BIND;
+        if (!config->numa_bind) {
+            // Preferred takes a single node: keep the lowest one in the list
+            mode = MPOL_PREFERRED;
+            for (int w = 0; w < MAX_NUMA_NODES / (int)BITS_PER_LONG; w++) {
+                if (mask[w]) {
+                    mask[w] &= -mask[w];
+                    for (w++; w < MAX_NUMA_NODES / (int)BITS_PER_LONG; w++)
+                        mask[w] = 0;
+                }
+            }
+        }
+        if (syscall(SYS_set_mempolicy, mode, mask, MAX_NUMA_NODES + 1) == -1) {
+            perror("Error setting NUMA memory policy");
+        }
+    }
+}
+
+// Function to find the NUMA node of a CPU from sysfs
+static int cpu_to_node(int cpu) {
+    if (!cpu_nodes_initialized) {
+        for (int i = 0; i < MAX_TRACKED_CPUS; i++)
+            cpu_nodes[i] = -2;
+        cpu_nodes_initialized = 1;
+    }
+    if (cpu < 0 || cpu >= MAX_TRACKED_CPUS)
+        return -1;
+    if (cpu_nodes[cpu] != -2)
+        return cpu_nodes[cpu];
+
+    cpu_nodes[cpu] = 0; // Non-NUMA kernels expose no nodeN link
+    char path[64];
+    snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d", cpu);
+    DIR *dir = opendir(path);
+    if (dir != NULL) {
+        struct dirent *entry;
+        while ((entry = readdir(dir)) != NULL) {
+            if (strncmp(entry->d_name, "node", 4) == 0 && entry->d_name[4] >= '0' && entry->d_name[4] <= '9') {
+                cpu_nodes[cpu] = atoi(entry->d_name + 4);
+                break;
+            }
+        }
+        closedir(dir);
+    }
+    return cpu_nodes[cpu];
+}
+
+// Function to read the CPU a process last ran on (field 39 of /proc/<pid>/stat)
+static int read_last_cpu(pid_t pid) {
+    char path[64];
+    char buffer[1024];
+    snprintf(path, sizeof(path), "/proc/%d/stat", (int)pid);
+    FILE *file = fopen(path, "r");
+    if (file == NULL)
+        return -1;
+    size_t len = fread(buffer, 1, sizeof(buffer) - 1, file);
+    fclose(file);
+    buffer[len] = '\0';
+
+    // Fields after the command name start at field 3
+    char *p = strrchr(buffer, ')');
+    if (p == NULL)
+        return -1;
+    int field = 2;
+    char *saveptr;
+    for (char *token = strtok_r(p + 1, " ", &saveptr); token != NULL; token = strtok_r(NULL, " ", &saveptr)) {
+        if (++field == 39)
+            return atoi(token);
+    }
+    return -1;
+}
+
+// Function to read the kernel's migration counter from /proc/<pid>/sched
+static long read_migrations(pid_t pid) {
+    char path[64];
+    char line[256];
+    snprintf(path, sizeof(path), "/proc/%d/sched", (int)pid);
+    FILE *file = fopen(path, "r");
+    if (file == NULL)
+        return -1;
+    long migrations = -1;
+    while (fgets(line, sizeof(line), file)) {
+        if (strncmp(line, "se.nr_migrations", 16) == 0) {
+            char *colon = strchr(line, ':');
+            if (colon != NULL)
+                migrations = atol(colon + 1);
+            break;
+        }
+    }
+    fclose(file);
+    return migrations;
+}
+
+void placement_sample_init(PlacementSample *sample, pid_t pid, WorkerStage stage) {
+    sample->pid = pid;
+    sample->stage = stage;
+    sample->last_cpu = read_last_cpu(pid);
+    sample->last_migrations = read_migrations(pid);
+}
+
+// Sample a child and fold any migrations since the previous sample into its stage totals
+void placement_sample_update(PlacementSample *sample, StagePlacementStats stats[STAGE_COUNT]) {
+    long migrations = read_migrations(sample->pid);
+    if (migrations >= 0 && sample->last_migrations >= 0 && migrations >= sample->last_migrations)
+        stats[sample->stage].migrations += migrations - sample->last_migrations;
+    sample->last_migrations = migrations;
+
+    int cpu = read_last_cpu(sample->pid);
+    if (cpu >= 0 && sample->last_cpu >= 0 && cpu != sample->last_cpu &&
+        cpu_to_node(cpu) != cpu_to_node(sample->last_cpu)) {
+        stats[sample->stage].cross_node_migrations++;
+    }
+    if (cpu >= 0)
+        sample->last_cpu = cpu;
+}
@@ -0,0 +1,37 @@
+// placement.h
+#ifndef PLACEMENT_H
+#define PLACEMENT_H
+
+#include "config.h"
+#include <sys/types.h>
+
+// Worker stages that can be pinned independently
+typedef enum {
+    STAGE_GENERATOR = 0,
+    STAGE_CALCULATOR,
+    STAGE_INSPECTOR,
+    STAGE_VISUALIZATION,
+    STAGE_COUNT
+} WorkerStage;
+
+// Per-stage scheduler statistics collected by the supervisor
+typedef struct {
+    long migrations;            // Kernel-reported migrations (se.nr_migrations)
+    long cross_node_migrations; // Observed moves to a CPU on a different NUMA node
+} StagePlacementStats;
+
+// Per-child sampling state
+typedef struct {
+    pid_t pid;
+    WorkerStage stage;
+    int last_cpu;
+    long last_migrations;
+} PlacementSample;
+
+// Function prototypes
+const char *stage_name(WorkerStage stage);
+void apply_stage_placement(const Config *config, WorkerStage stage);
+void placement_sample_init(PlacementSample *sample, pid_t pid, WorkerStage stage);
+void placement_sample_update(PlacementSample *sample, StagePlacementStats stats[STAGE_COUNT]);
+
+#endif // PLACEMENT_H
@@ -7,6 +7,8 @@
 #include <fcntl.h>           
 #include <unistd.h>
 #include <string.h>
+#include <time.h>
+#include <limits.h>
 
 // Initialize shared memory
 SharedMemory* init_shared_memory() {
@@ -23,7 +25,7 @@ SharedMemory* init_shared_memory() {
         exit(1);
     }
 
-    if (shm_stat.st_size == 0) {
+    if (shm_stat.st_size < (off_t)sizeof(SharedMemory)) {
         if (ftruncate(shm_fd, sizeof(SharedMemory)) == -1) {
             perror("Error truncating shared memory");
             exit(1);
@@ -51,6 +53,9 @@ SharedMemory* init_shared_memory() {
         shared_data->files_moved_to_unprocessed = 0;
         shared_data->files_moved_to_backup = 0;
         shared_data->files_deleted = 0;
+        shared_data->history_seq = 0;
+        shared_data->history_count = 0;
+        shared_data->deadline_slack_min_ms = LONG_MAX;
     }
 
     return shared_data;
@@ -81,3 +86,158 @@ void cleanup_semaphore(sem_t *sem) {
     }
     sem_unlink("/files_semaphore");
 }
+
+// Copy the live counters into a sample (caller holds the semaphore)
+void snapshot_counters(SharedMemory *shared_data, CounterSample *sample) {
+    struct timespec now;
+    clock_gettime(CLOCK_REALTIME, &now);
+    sample->timestamp_ms = (long)now.tv_sec * 1000 + now.tv_nsec / 1000000;
+    sample->files_generated = shared_data->files_generated;
+    sample->files_processed = shared_data->files_processed;
+    sample->files_moved_to_processed = shared_data->files_moved_to_processed;
+    sample->files_moved_to_unprocessed = shared_data->files_moved_to_unprocessed;
+    sample->files_moved_to_backup = shared_data->files_moved_to_backup;
+    sample->files_deleted = shared_data->files_deleted;
+}
+
+// Append a sample to the history ring (single writer: the supervisor)
+void history_append(SharedMemory *shared_data, const CounterSample *sample) {
+    unsigned int seq = shared_data->history_seq;
+    __atomic_store_n(&shared_data->history_seq, seq + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+
+    shared_data->history[shared_data->history_count % HISTORY_SIZE] = *sample;
+    __atomic_store_n(&shared_data->history_count, shared_data->history_count + 1, __ATOMIC_RELAXED);
+
+    __atomic_store_n(&shared_data->history_seq, seq + 2, __ATOMIC_RELEASE);
+}
+
+// Change counter observers poll to decide whether anything needs redrawing
+unsigned int history_version(SharedMemory *shared_data) {
+    return __atomic_load_n(&shared_data->history_seq, __ATOMIC_ACQUIRE);
+}
+
+// Read sample number index without taking the semaphore. Returns 0 on success and -1 if the
+// sample has already been overwritten or not yet written; *count receives the total written.
+int history_read(SharedMemory *shared_data, unsigned long index, CounterSample *sample, unsigned long *count) {
+    while (1) {
+        unsigned int seq = __atomic_load_n(&shared_data->history_seq, __ATOMIC_ACQUIRE);
+        if (seq & 1)
+            continue; // Writer in progress
+
+        unsigned long total = __atomic_load_n(&shared_data->history_count, __ATOMIC_RELAXED);
+        int valid = index < total && total - index <= HISTORY_SIZE;
+        if (valid)
+            *sample = shared_data->history[index % HISTORY_SIZE];
+
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        if (__atomic_load_n(&shared_data->history_seq, __ATOMIC_RELAXED) == seq) {
+            *count = total;
+            return valid ? 0 : -1;
+        }
+    }
+}
+
+// Forget every tracked file and the deadline statistics (called by the supervisor at startup)
+void file_table_reset(SharedMemory *shared_data) {
+    memset(shared_data->files, 0, sizeof(shared_data->files));
+    shared_data->deadline_claims = 0;
+    shared_data->deadline_late_claims = 0;
+    shared_data->deadline_slack_total_ms = 0;
+    shared_data->deadline_slack_min_ms = LONG_MAX;
+    shared_data->expire_conflicts = 0;
+    shared_data->files_queued = 0;
+}
+
+// The functions below are called with the semaphore held. A file whose table slot is taken
+// by another live file stays untracked, and cannot be claimed or expired until that file leaves.
+
+// Record a file that has just appeared in ./home. Returns 0 if it is now tracked.
+int file_enqueue(SharedMemory *shared_data, int file_index, long arrival_ms) {
+    FileEntry *entry = &shared_data->files[file_index % MAX_TRACKED_FILES];
+    if (entry->state != FILE_UNTRACKED)
+        return -1;
+    entry->file_index = file_index;
+    entry->claimed_by = -1;
+    entry->arrival_ms = arrival_ms;
+    entry->state = FILE_QUEUED;
+    __atomic_store_n(&shared_data->files_queued, shared_data->files_queued + 1, __ATOMIC_RELAXED);
+    return 0;
+}
+
+// Index of the queued file with the earliest deadline, or -1 if none is queued.
+// All files share the same age threshold, so the earliest deadline is the earliest arrival.
+int file_earliest_deadline(SharedMemory *shared_data) {
+    int best = -1;
+    long best_arrival = LONG_MAX;
+    for (int i = 0; i < MAX_TRACKED_FILES; i++) {
+        FileEntry *entry = &shared_data->files[i];
+        if (entry->state == FILE_QUEUED && entry->arrival_ms < best_arrival) {
+            best_arrival = entry->arrival_ms;
+            best = entry->file_index;
+        }
+    }
+    return best;
+}
+
+// Take a file for a calculator. Returns -1 if Inspector Type1 or another calculator holds it.
+int file_try_claim(SharedMemory *shared_data, int file_index, int calculator_id) {
+    FileEntry *entry = &shared_data->files[file_index % MAX_TRACKED_FILES];
+    if (entry->state == FILE_UNTRACKED) {
+        // Not published through the table (e.g. requeued by journal recovery)
+        entry->file_index = file_index;
+        entry->arrival_ms = 0;
+    } else if (entry->file_index != file_index || entry->state != FILE_QUEUED) {
+        return -1; // Held, or the slot belongs to another live file that may be held
+    } else {
+        __atomic_store_n(&shared_data->files_queued, shared_data->files_queued - 1, __ATOMIC_RELAXED);
+    }
+    entry->claimed_by = calculator_id;
+    entry->state = FILE_CLAIMED;
+    return 0;
+}
+
+// Take a file for Inspector Type1. Returns -1 if a calculator holds it.
+int file_try_expire(SharedMemory *shared_data, int file_index) {
+    FileEntry *entry = &shared_data->files[file_index % MAX_TRACKED_FILES];
+    if (entry->state == FILE_UNTRACKED) {
+        entry->file_index = file_index;
+        entry->arrival_ms = 0;
+    } else if (entry->file_index != file_index || entry->state != FILE_QUEUED) {
+        return -1; // Held, or the slot belongs to another live file that may be held
+    } else {
+        __atomic_store_n(&shared_data->files_queued, shared_data->files_queued - 1, __ATOMIC_RELAXED);
+    }
+    entry->state = FILE_EXPIRED;
+    return 0;
+}
+
+// Drop a file from the table once it has left ./home
+void file_release(SharedMemory *shared_data, int file_index) {
+    FileEntry *entry = &shared_data->files[file_index % MAX_TRACKED_FILES];
+    if (entry->state != FILE_UNTRACKED && entry->file_index == file_index)
+        entry->state = FILE_UNTRACKED;
+}
+
+// Whether the main queue has work, checked without the semaphore by the catch-up lane
+int file_queue_has_work(SharedMemory *shared_data) {
+    return __atomic_load_n(&shared_data->files_queued, __ATOMIC_RELAXED) > 0;
+}
+
+// Arrival time of a tracked file, or -1 if it is unknown
+long file_arrival_ms(SharedMemory *shared_data, int file_index) {
+    FileEntry *entry = &shared_data->files[file_index % MAX_TRACKED_FILES];
+    if (entry->state == FILE_UNTRACKED || entry->file_index != file_index || entry->arrival_ms <= 0)
+        return -1;
+    return entry->arrival_ms;
+}
+
+// Fold the slack of one claim (deadline minus claim time) into the statistics
+void record_deadline_slack(SharedMemory *shared_data, long slack_ms) {
+    shared_data->deadline_claims++;
+    shared_data->deadline_slack_total_ms += slack_ms;
+    if (slack_ms < shared_data->deadline_slack_min_ms)
+        shared_data->deadline_slack_min_ms = slack_ms;
+    if (slack_ms < 0)
+        shared_data->deadline_late_claims++;
+}
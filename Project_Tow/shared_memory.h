@@ -9,6 +9,55 @@
 #define MAX_COLUMNS 50
 #define MAX_ROWS 100000
 #define MAX_FILENAME 512
+#define HISTORY_SIZE 600 // Ten minutes of one-second samples
+#define MAX_STREAMS 64 // Files that can be generated and consumed concurrently
+#define MAX_TRACKED_FILES 4096 // Files waiting in ./home that the claim table can track
+
+// States of a streaming slot
+typedef enum {
+    STREAM_FREE = 0,
+    STREAM_WRITING,     // Generator is writing ./home/.inprogress/<n>.csv
+    STREAM_FINALIZING   // Finished without a consumer; generator is moving it to ./home
+} StreamState;
+
+// A file published while it is still being generated
+typedef struct {
+    int state;            // StreamState (changed under the semaphore)
+    int file_index;
+    int claimed_by;       // Calculator id, -1 while unclaimed
+    int complete;         // Set by the generator after the final watermark
+    int failed;           // Set with complete when the write failed: the file is gone and must be dropped
+    long committed_bytes; // Bytes of whole rows written so far
+    long started_ms;      // When generation started
+} StreamSlot;
+
+// States of a claim table entry
+typedef enum {
+    FILE_UNTRACKED = 0,
+    FILE_QUEUED,   // Waiting in ./home
+    FILE_CLAIMED,  // A calculator is moving it to Processing
+    FILE_EXPIRED   // Inspector Type1 is moving it to UnProcessed
+} FileState;
+
+// A file waiting in ./home, stored at file_index % MAX_TRACKED_FILES.
+// The claim marker makes calculators and Inspector Type1 mutually exclusive on a file.
+typedef struct {
+    int state;       // FileState (changed under the semaphore)
+    int file_index;
+    int claimed_by;  // Calculator id while FILE_CLAIMED
+    long arrival_ms; // When the file appeared in ./home
+} FileEntry;
+
+// One sample of the file counters, taken by the supervisor
+typedef struct {
+    long timestamp_ms; // Milliseconds since the epoch
+    int files_generated;
+    int files_processed;
+    int files_moved_to_processed;
+    int files_moved_to_unprocessed;
+    int files_moved_to_backup;
+    int files_deleted;
+} CounterSample;
 
 // Shared memory structure for storing averages and file counters
 typedef struct {
@@ -21,6 +70,34 @@ typedef struct {
     int files_moved_to_unprocessed;
     int files_moved_to_backup;
     int files_deleted;
+
+    // Start of the run in milliseconds since the epoch, set by the supervisor
+    long run_start_ms;
+
+    // Files being generated that calculators may consume early
+    StreamSlot streams[MAX_STREAMS];
+
+    // Claim table for earliest-deadline-first scheduling, and how close claims came
+    // to the Inspector Type1 deadline (arrival + type1_threshold_age)
+    FileEntry files[MAX_TRACKED_FILES];
+    long deadline_claims;
+    long deadline_late_claims;    // Claimed after the deadline had already passed
+    long deadline_slack_total_ms;
+    long deadline_slack_min_ms;
+    long expire_conflicts;        // Inspector Type1 skipped a file a calculator held
+    int files_queued;             // Entries in FILE_QUEUED; read without the semaphore
+
+    // Catch-up lane: files taken back out of UnProcessed by idle calculators
+    int files_recovered;
+    long catchup_preemptions;     // Catch-up files handed back because fresh work arrived
+    long catchup_failures;        // Catch-up files that could not be read, set aside in Backup
+
+    // Counter history written only by the supervisor and read without the semaphore.
+    // history_seq is a seqlock and doubles as the change counter observers poll:
+    // it is odd while a sample is being written and moves by 2 per new sample.
+    unsigned int history_seq;
+    unsigned long history_count; // Total samples ever written
+    CounterSample history[HISTORY_SIZE];
     // Additional fields can be added as needed
 } SharedMemory;
 
@@ -29,5 +106,18 @@ SharedMemory* init_shared_memory();
 void cleanup_shared_memory(SharedMemory *shared_data);
 sem_t* init_semaphore();
 void cleanup_semaphore(sem_t *sem);
+void snapshot_counters(SharedMemory *shared_data, CounterSample *sample);
+void history_append(SharedMemory *shared_data, const CounterSample *sample);
+unsigned int history_version(SharedMemory *shared_data);
+int history_read(SharedMemory *shared_data, unsigned long index, CounterSample *sample, unsigned long *count);
+void file_table_reset(SharedMemory *shared_data);
+int file_enqueue(SharedMemory *shared_data, int file_index, long arrival_ms);
+int file_earliest_deadline(SharedMemory *shared_data);
+int file_try_claim(SharedMemory *shared_data, int file_index, int calculator_id);
+int file_try_expire(SharedMemory *shared_data, int file_index);
+void file_release(SharedMemory *shared_data, int file_index);
+int file_queue_has_work(SharedMemory *shared_data);
+long file_arrival_ms(SharedMemory *shared_data, int file_index);
+void record_deadline_slack(SharedMemory *shared_data, long slack_ms);
 
 #endif // SHARED_MEMORY_H
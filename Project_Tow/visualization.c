@@ -1,4 +1,5 @@
 // visualization.c
+#define GL_GLEXT_PROTOTYPES
 #include "shared_memory.h"
 #include "config.h"
 #include <GL/glut.h>
@@ -6,14 +7,161 @@
 #include <stdlib.h>
 #include <signal.h>
 
+#define NUM_SERIES 6
+#define POLL_INTERVAL_MS 100 // How often the change counter is checked
+
 // Global pointers for shared memory and semaphore
 SharedMemory *shared_data = NULL;
 sem_t *sem = NULL;
 
+// Throughput chart area
+float chart_x = 50.0f;
+float chart_y = 620.0f;
+float chart_width = 700.0f;
+float chart_height = 230.0f;
+
+// Retained vertex buffers, one per counter. Each holds 2 * HISTORY_SIZE vertices and every
+// vertex is written at slot and slot + HISTORY_SIZE, so any window of HISTORY_SIZE samples
+// is contiguous and drawn with a single glDrawArrays call.
+GLuint series_vbo[NUM_SERIES];
+float series_rates[NUM_SERIES][HISTORY_SIZE]; // CPU copy of the rates, used for scaling
+unsigned long uploaded_count = 0;  // Next sample number to upload
+unsigned long rate_start = 0;      // First sample number with a rate vertex
+int have_previous = 0;
+CounterSample previous_sample;
+CounterSample latest_sample;       // Drives the bars
+unsigned int seen_version = 0;
+
+// Define colors for different counters
+float colors[NUM_SERIES][3] = {
+    {0.0f, 1.0f, 0.0f},   // Green for Generated
+    {0.0f, 0.0f, 1.0f},   // Blue for Processed
+    {1.0f, 1.0f, 0.0f},   // Yellow for Moved to Processed
+    {1.0f, 0.0f, 0.0f},   // Red for Moved to UnProcessed
+    {0.5f, 0.0f, 0.5f},   // Purple for Moved to Backup
+    {1.0f, 0.5f, 0.0f}    // Orange for Deleted
+};
+
 // Function prototypes
 void display();
 void timer_func(int value);
 
+// Function to read one counter of a sample by series number
+int sample_value(const CounterSample *sample, int series) {
+    switch (series) {
+        case 0: return sample->files_generated;
+        case 1: return sample->files_processed;
+        case 2: return sample->files_moved_to_processed;
+        case 3: return sample->files_moved_to_unprocessed;
+        case 4: return sample->files_moved_to_backup;
+        default: return sample->files_deleted;
+    }
+}
+
+// Function to create the retained vertex buffers
+void init_series_buffers() {
+    glGenBuffers(NUM_SERIES, series_vbo);
+    for (int s = 0; s < NUM_SERIES; s++) {
+        glBindBuffer(GL_ARRAY_BUFFER, series_vbo[s]);
+        glBufferData(GL_ARRAY_BUFFER, sizeof(float) * 2 * 2 * HISTORY_SIZE, NULL, GL_DYNAMIC_DRAW);
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+// Function to upload only the samples published since the previous poll
+void upload_new_samples() {
+    CounterSample sample;
+    unsigned long count;
+    unsigned long next = uploaded_count;
+
+    while (1) {
+        if (history_read(shared_data, next, &sample, &count) == -1) {
+            if (next < count) {
+                // Fell more than a full ring behind; restart from the oldest retained sample
+                next = count > HISTORY_SIZE ? count - HISTORY_SIZE : 0;
+                have_previous = 0;
+                continue;
+            }
+            break; // Caught up
+        }
+
+        if (have_previous) {
+            float dt = (sample.timestamp_ms - previous_sample.timestamp_ms) / 1000.0f;
+            int slot = next % HISTORY_SIZE;
+            for (int s = 0; s < NUM_SERIES; s++) {
+                float rate = dt > 0 ? (sample_value(&sample, s) - sample_value(&previous_sample, s)) / dt : 0.0f;
+                float vertex[2] = { (float)next, rate };
+                series_rates[s][slot] = rate;
+                glBindBuffer(GL_ARRAY_BUFFER, series_vbo[s]);
+                glBufferSubData(GL_ARRAY_BUFFER, sizeof(vertex) * slot, sizeof(vertex), vertex);
+                glBufferSubData(GL_ARRAY_BUFFER, sizeof(vertex) * (slot + HISTORY_SIZE), sizeof(vertex), vertex);
+            }
+        } else {
+            rate_start = next + 1;
+        }
+
+        previous_sample = sample;
+        latest_sample = sample;
+        have_previous = 1;
+        next++;
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    uploaded_count = next;
+}
+
+// Function to draw throughput-over-time lines from the retained buffers
+void draw_throughput_chart() {
+    // Chart frame
+    glColor3f(0.3f, 0.3f, 0.3f);
+    glBegin(GL_LINE_LOOP);
+        glVertex2f(chart_x, chart_y);
+        glVertex2f(chart_x + chart_width, chart_y);
+        glVertex2f(chart_x + chart_width, chart_y + chart_height);
+        glVertex2f(chart_x, chart_y + chart_height);
+    glEnd();
+
+    unsigned long window_start = uploaded_count > HISTORY_SIZE ? uploaded_count - HISTORY_SIZE : 0;
+    unsigned long first = rate_start > window_start ? rate_start : window_start;
+    int visible = uploaded_count > first ? (int)(uploaded_count - first) : 0;
+
+    // Scale to the peak rate in the visible window
+    float max_rate = 1.0f;
+    for (int s = 0; s < NUM_SERIES; s++) {
+        for (int i = 0; i < visible; i++) {
+            float rate = series_rates[s][(first + i) % HISTORY_SIZE];
+            if (rate > max_rate) max_rate = rate;
+        }
+    }
+
+    char title[64];
+    snprintf(title, sizeof(title), "Throughput (files/s, peak %.1f)", max_rate);
+    glColor3f(1.0f, 1.0f, 1.0f);
+    glRasterPos2f(chart_x, chart_y + chart_height + 10);
+    for (char *c = title; *c != '\0'; c++) {
+        glutBitmapCharacter(GLUT_BITMAP_HELVETICA_12, *c);
+    }
+
+    if (visible < 2)
+        return;
+
+    // Map sample numbers to the chart's x axis and rates to its y axis
+    float x_scale = chart_width / HISTORY_SIZE;
+    glPushMatrix();
+    glTranslatef(chart_x - window_start * x_scale, chart_y, 0.0f);
+    glScalef(x_scale, chart_height / max_rate, 1.0f);
+
+    glEnableClientState(GL_VERTEX_ARRAY);
+    for (int s = 0; s < NUM_SERIES; s++) {
+        glColor3f(colors[s][0], colors[s][1], colors[s][2]);
+        glBindBuffer(GL_ARRAY_BUFFER, series_vbo[s]);
+        glVertexPointer(2, GL_FLOAT, 0, NULL);
+        glDrawArrays(GL_LINE_STRIP, first % HISTORY_SIZE, visible);
+    }
+    glDisableClientState(GL_VERTEX_ARRAY);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glPopMatrix();
+}
+
 // Signal handler for graceful shutdown
 void handle_signal(int sig) {
     printf("Visualization received signal %d. Cleaning up and exiting.\n", sig);
@@ -32,21 +180,18 @@ void display() {
     glMatrixMode(GL_PROJECTION);
     glPushMatrix();
     glLoadIdentity();
-    gluOrtho2D(0, 800, 0, 600);
+    gluOrtho2D(0, 800, 0, 900);
     glMatrixMode(GL_MODELVIEW);
     glPushMatrix();
     glLoadIdentity();
 
-    // Fetch data from shared memory
-    int generated, processed, moved_processed, moved_unprocessed, moved_backup, deleted;
-    sem_wait(sem);
-    generated = shared_data->files_generated;
-    processed = shared_data->files_processed;
-    moved_processed = shared_data->files_moved_to_processed;
-    moved_unprocessed = shared_data->files_moved_to_unprocessed;
-    moved_backup = shared_data->files_moved_to_backup;
-    deleted = shared_data->files_deleted;
-    sem_post(sem);
+    // Latest sample published by the supervisor (no semaphore needed)
+    int generated = latest_sample.files_generated;
+    int processed = latest_sample.files_processed;
+    int moved_processed = latest_sample.files_moved_to_processed;
+    int moved_unprocessed = latest_sample.files_moved_to_unprocessed;
+    int moved_backup = latest_sample.files_moved_to_backup;
+    int deleted = latest_sample.files_deleted;
 
     // Determine the maximum value for scaling
     int max_value = generated;
@@ -57,16 +202,6 @@ void display() {
     if (deleted > max_value) max_value = deleted;
     if (max_value == 0) max_value = 1; // Prevent division by zero
 
-    // Define colors for different counters
-    float colors[6][3] = {
-        {0.0f, 1.0f, 0.0f},   // Green for Generated
-        {0.0f, 0.0f, 1.0f},   // Blue for Processed
-        {1.0f, 1.0f, 0.0f},   // Yellow for Moved to Processed
-        {1.0f, 0.0f, 0.0f},   // Red for Moved to UnProcessed
-        {0.5f, 0.0f, 0.5f},   // Purple for Moved to Backup
-        {1.0f, 0.5f, 0.0f}    // Orange for Deleted
-    };
-
     // Draw bars representing different counters
     float bar_width = 100.0f;
     float bar_spacing = 20.0f;
@@ -142,6 +277,8 @@ void display() {
         }
     }
 
+    draw_throughput_chart();
+
     // Restore projection matrix
     glMatrixMode(GL_PROJECTION);
     glPopMatrix();
@@ -151,13 +288,17 @@ void display() {
     glutSwapBuffers();
 }
 
-// OpenGL timer function to update display and check termination
+// OpenGL timer function: redraw only when the supervisor has published a new sample
 void timer_func(int value) {
-    // Redraw the display
-    glutPostRedisplay();
+    unsigned int version = history_version(shared_data);
+    if (version != seen_version) {
+        seen_version = version;
+        upload_new_samples();
+        glutPostRedisplay();
+    }
 
     // Register the timer callback again
-    glutTimerFunc(1000, timer_func, 0); // Refresh every second
+    glutTimerFunc(POLL_INTERVAL_MS, timer_func, 0);
 }
 
 int main(int argc, char *argv[]) {
@@ -172,11 +313,12 @@ int main(int argc, char *argv[]) {
     // Initialize OpenGL (Visualization)
     glutInit(&argc, argv);
     glutInitDisplayMode(GLUT_DOUBLE | GLUT_RGB | GLUT_DEPTH);
-    glutInitWindowSize(800, 600);
+    glutInitWindowSize(800, 900);
     glutCreateWindow("File Management Simulation");
     glClearColor(0.0, 0.0, 0.0, 1.0);
     glutDisplayFunc(display);
-    glutTimerFunc(1000, timer_func, 0);
+    init_series_buffers();
+    glutTimerFunc(POLL_INTERVAL_MS, timer_func, 0);
 
     // Start OpenGL main loop
     glutMainLoop();
@@ -0,0 +1,94 @@
+// workload.c
+#include "workload.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+// Truncate the trace and write its header (called once by the supervisor before recording)
+int workload_reset(const char *path) {
+    FILE *file = fopen(path, "w");
+    if (file == NULL) {
+        perror("Error creating workload trace");
+        return -1;
+    }
+    fprintf(file, "# generator_id,arrival_ms,rows,columns,missing_percentage,seed\n");
+    fclose(file);
+    return 0;
+}
+
+// Append one entry; a single O_APPEND write keeps lines from concurrent generators intact
+int workload_record(const char *path, const WorkloadEntry *entry) {
+    int fd = open(path, O_WRONLY | O_CREAT | O_APPEND, 0644);
+    if (fd == -1) {
+        perror("Error opening workload trace");
+        return -1;
+    }
+
+    char line[128];
+    int len = snprintf(line, sizeof(line), "%d,%ld,%d,%d,%.2f,%u\n",
+                       entry->generator_id, entry->arrival_ms, entry->rows, entry->columns,
+                       entry->missing_percentage, entry->seed);
+    if (write(fd, line, len) != len) {
+        perror("Error recording workload entry");
+        close(fd);
+        return -1;
+    }
+    close(fd);
+    return 0;
+}
+
+// Function to order entries by arrival time
+static int compare_arrival(const void *a, const void *b) {
+    const WorkloadEntry *ea = a;
+    const WorkloadEntry *eb = b;
+    return (ea->arrival_ms > eb->arrival_ms) - (ea->arrival_ms < eb->arrival_ms);
+}
+
+// Load the entries of one generator, sorted by arrival time. Returns the count or -1.
+int workload_load(const char *path, int generator_id, WorkloadEntry **entries) {
+    FILE *file = fopen(path, "r");
+    if (file == NULL) {
+        perror("Error opening workload trace");
+        return -1;
+    }
+
+    int count = 0;
+    int capacity = 64;
+    *entries = malloc(sizeof(WorkloadEntry) * capacity);
+    if (*entries == NULL) {
+        perror("Error allocating workload entries");
+        fclose(file);
+        return -1;
+    }
+
+    char line[256];
+    while (fgets(line, sizeof(line), file)) {
+        // Ignore comments and empty lines
+        if (line[0] == '#' || strlen(line) < 3)
+            continue;
+
+        WorkloadEntry entry;
+        if (sscanf(line, "%d,%ld,%d,%d,%f,%u", &entry.generator_id, &entry.arrival_ms, &entry.rows,
+                   &entry.columns, &entry.missing_percentage, &entry.seed) != 6)
+            continue;
+        if (entry.generator_id != generator_id)
+            continue;
+
+        if (count == capacity) {
+            capacity *= 2;
+            WorkloadEntry *grown = realloc(*entries, sizeof(WorkloadEntry) * capacity);
+            if (grown == NULL) {
+                perror("Error growing workload entries");
+                break;
+            }
+            *entries = grown;
+        }
+        (*entries)[count++] = entry;
+    }
+    fclose(file);
+
+    qsort(*entries, count, sizeof(WorkloadEntry), compare_arrival);
+    return count;
+}
@@ -0,0 +1,30 @@
+// workload.h
+#ifndef WORKLOAD_H
+#define WORKLOAD_H
+
+// Workload trace format: one line per generated file
+//   generator_id,arrival_ms,rows,columns,missing_percentage,seed
+// arrival_ms is relative to the start of the run; lines starting with '#' are ignored.
+
+typedef enum {
+    WORKLOAD_LIVE = 0,  // Random timing and shapes (default)
+    WORKLOAD_RECORD,    // Random timing and shapes, appended to the trace
+    WORKLOAD_REPLAY     // Timing and shapes read from the trace
+} WorkloadMode;
+
+// One generated file
+typedef struct {
+    int generator_id;
+    long arrival_ms;
+    int rows;
+    int columns;
+    float missing_percentage;
+    unsigned int seed; // Seeds the file's content
+} WorkloadEntry;
+
+// Function prototypes
+int workload_reset(const char *path);
+int workload_record(const char *path, const WorkloadEntry *entry);
+int workload_load(const char *path, int generator_id, WorkloadEntry **entries);
+
+#endif // WORKLOAD_H